@@ -0,0 +1,1216 @@
+#include "CPUFilter.h"
+
+#include <array>
+#include <cmath>
+#include <cctype>
+#include <regex>
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+
+#include "opencv2/core.hpp"
+#include "opencv2/imgproc.hpp"
+
+#include "LibCore/Parallel.h"
+#include "LibGraphics/DefaultShaders.h"
+
+#define CPU_FILTER_CHUNK_PIXELS (64 * 1024)
+#define CPU_FILTER_COLUMN_GRAIN 256		// interleaved channel columns per task of a vertical pass
+
+namespace LibCV
+{
+	namespace
+	{
+		struct Color
+		{
+			float r, g, b;
+		};
+
+		inline Color operator+(const Color& a, const Color& b) { return Color{ a.r + b.r, a.g + b.g, a.b + b.b }; }
+		inline Color operator-(const Color& a, const Color& b) { return Color{ a.r - b.r, a.g - b.g, a.b - b.b }; }
+		inline Color operator*(const Color& a, float s) { return Color{ a.r * s, a.g * s, a.b * s }; }
+		inline Color Mix(const Color& a, const Color& b, float t) { return a + (b - a) * t; }
+		inline float Length(const Color& c) { return std::sqrt(c.r * c.r + c.g * c.g + c.b * c.b); }
+		inline float Fract(float value) { return value - std::floor(value); }
+		inline float Length(float x, float y) { return std::sqrt(x * x + y * y); }
+
+		// what an 8 bit framebuffer stores
+		inline uchar Unorm(float value) { return cv::saturate_cast<uchar>(value * 255.0f); }
+
+		inline int Wrap(int64_t index, int size)
+		{
+			const int64_t wrapped = index % size;
+			return static_cast<int>(wrapped < 0 ? wrapped + size : wrapped);
+		}
+
+		// a uniform's components, ints are stored as floats as well
+		using Value = std::array<float, 4>;
+
+		class Parameters
+		{
+		public:
+			void Set(const std::string& name, const Value& value) { values[name] = value; }
+			void Override(const Parameters& overrides)
+			{
+				for (auto& value : overrides.values)
+					values[value.first] = value.second;
+			}
+			float Float(const char* name) const { return Get(name)[0]; }
+			int Int(const char* name) const { return static_cast<int>(Get(name)[0]); }
+			Value Vec(const char* name) const { return Get(name); }
+
+		private:
+			Value Get(const char* name) const
+			{
+				auto found = values.find(name);
+				return found == values.end() ? Value{} : found->second;
+			}
+
+			std::map<std::string, Value> values;
+		};
+
+		// GL_LINEAR with GL_REPEAT, which is what every texture of the GL path samples with;
+		// row 0 is the first row in memory, TexCoord.y grows with the row like the uploaded textures
+		class Sampler
+		{
+		public:
+			explicit Sampler(const cv::Mat& image) : image{ image }, width{ image.cols }, height{ image.rows } {}
+
+			Color Texel(int64_t x, int64_t y) const
+			{
+				const uchar* pixel = image.ptr<uchar>(Wrap(y, height)) + 3 * Wrap(x, width);
+				return Color{ pixel[2] / 255.0f, pixel[1] / 255.0f, pixel[0] / 255.0f };
+			}
+
+			Color Sample(float u, float v) const
+			{
+				if (!std::isfinite(u) || !std::isfinite(v))
+					return Color{};
+
+				const float x = Fract(u) * width - 0.5f, y = Fract(v) * height - 0.5f;
+				const float x0 = std::floor(x), y0 = std::floor(y);
+				const auto ix = static_cast<int64_t>(x0), iy = static_cast<int64_t>(y0);
+				const Color lower = Mix(Texel(ix, iy), Texel(ix + 1, iy), x - x0);
+				const Color upper = Mix(Texel(ix, iy + 1), Texel(ix + 1, iy + 1), x - x0);
+				return Mix(lower, upper, y - y0);
+			}
+
+		private:
+			const cv::Mat& image;
+			int width, height;
+		};
+
+		template<typename RowFn>
+		void ForEachRows(LibCore::Async::ThreadPool& pool, int height, int width, RowFn&& rowFn)
+		{
+			const size_t grain = std::max<size_t>(1, CPU_FILTER_CHUNK_PIXELS / std::max(width, 1));
+			LibCore::Async::ParallelFor(pool, LibCore::Async::Range{ 0, static_cast<size_t>(height) }, grain, [&rowFn](const LibCore::Async::Range& rows) {
+				rowFn(static_cast<int>(rows.Begin), static_cast<int>(rows.End));
+			});
+		}
+
+		// one fragment per pixel with TexCoord at the pixel centre, like the full screen quad
+		template<typename ShadeFn>
+		void Shade(const cv::Mat& src, cv::Mat& dst, LibCore::Async::ThreadPool& pool, ShadeFn&& shade)
+		{
+			const Sampler sampler{ src };
+			const float invWidth = 1.0f / src.cols, invHeight = 1.0f / src.rows;
+			ForEachRows(pool, src.rows, src.cols, [&](int begin, int end) {
+				for (int y = begin; y < end; ++y)
+				{
+					uchar* out = dst.ptr<uchar>(y);
+					const float v = (y + 0.5f) * invHeight;
+					for (int x = 0; x < src.cols; ++x, out += 3)
+					{
+						const Color color = shade(sampler, (x + 0.5f) * invWidth, v, x, y);
+						out[0] = Unorm(color.b);
+						out[1] = Unorm(color.g);
+						out[2] = Unorm(color.r);
+					}
+				}
+			});
+		}
+
+		// every channel only depends on itself: 256 entries per channel, then the vectorised cv::LUT per band
+		template<typename ChannelFn>
+		void ApplyLUT(const cv::Mat& src, cv::Mat& dst, LibCore::Async::ThreadPool& pool, ChannelFn&& channelFn)
+		{
+			cv::Mat lut(1, 256, CV_8UC3);
+			uchar* entries = lut.ptr<uchar>();
+			for (int i = 0; i < 256; ++i)
+			{
+				for (int channel = 0; channel < 3; ++channel)	// r, g, b
+					entries[i * 3 + 2 - channel] = Unorm(channelFn(i / 255.0f, channel));
+			}
+
+			ForEachRows(pool, src.rows, src.cols, [&](int begin, int end) {
+				cv::Mat band = dst.rowRange(begin, end);
+				cv::LUT(src.rowRange(begin, end), lut, band);
+			});
+		}
+
+		// out = matrix * rgb + offset, matrix rows and columns in r, g, b order
+		void ApplyColorMatrix(const cv::Mat& src, cv::Mat& dst, LibCore::Async::ThreadPool& pool, const float (&matrix)[3][4])
+		{
+			cv::Matx34f bgrMatrix;
+			for (int row = 0; row < 3; ++row)
+			{
+				for (int column = 0; column < 3; ++column)
+					bgrMatrix(row, column) = matrix[2 - row][2 - column];
+				bgrMatrix(row, 3) = matrix[2 - row][3] * 255.0f;
+			}
+
+			ForEachRows(pool, src.rows, src.cols, [&](int begin, int end) {
+				cv::Mat band = dst.rowRange(begin, end);
+				cv::transform(src.rowRange(begin, end), band, bgrMatrix);
+			});
+		}
+
+		// linear texel-aligned shaders through the vectorised cv::filter2D; the image is padded with wrapped
+		// texels (GL_REPEAT) and every band reads its neighbours from the padding
+		void Convolve(const cv::Mat& src, cv::Mat& dst, LibCore::Async::ThreadPool& pool, const cv::Mat& kernel)
+		{
+			const int radiusX = kernel.cols / 2, radiusY = kernel.rows / 2;
+			cv::Mat padded;
+			cv::copyMakeBorder(src, padded, radiusY, radiusY, radiusX, radiusX, cv::BORDER_WRAP);
+
+			ForEachRows(pool, src.rows, src.cols, [&](int begin, int end) {
+				cv::Mat band = dst.rowRange(begin, end);
+				cv::filter2D(padded(cv::Rect{ radiusX, radiusY + begin, src.cols, end - begin }), band, -1, kernel);
+			});
+		}
+
+		float HashNoise(float u, float v, float scale, float phase)
+		{
+			return Fract(std::sin(u * scale * 12.9898f + v * scale * 78.233f + phase) * 43758.5453f);
+		}
+
+		// direction from the centre, GLSL leaves normalize(vec2(0)) undefined, the centre pixel stays in place
+		inline bool Direction(float x, float y, float& dirX, float& dirY)
+		{
+			const float length = Length(x, y);
+			if (length <= 0.0f)
+				return false;
+			dirX = x / length;
+			dirY = y / length;
+			return true;
+		}
+
+		float EdgeMagnitude(const float (&gx)[9], const float (&gy)[9], const Color (&texels)[9])
+		{
+			float sumX = 0.0f, sumY = 0.0f;
+			for (int i = 0; i < 9; ++i)
+			{
+				sumX += gx[i] * texels[i].r;
+				sumY += gy[i] * texels[i].r;
+			}
+			return Length(sumX, sumY);
+		}
+
+		// 3x3 neighbourhood, index 0 is (-1, +1) like the offsets of the shaders
+		void Neighbourhood(const Sampler& sampler, int x, int y, Color (&texels)[9])
+		{
+			for (int i = 0; i < 9; ++i)
+				texels[i] = sampler.Texel(x + i % 3 - 1, y + 1 - i / 3);
+		}
+
+		Color Grey(float value) { return Color{ value, value, value }; }
+
+		// ---- DefaultShaders.h -------------------------------------------------------------------------------
+
+		void GaussianBlur(const cv::Mat& src, cv::Mat& dst, const Parameters& parameters, LibCore::Async::ThreadPool& pool)
+		{
+			static const float weights[3] = { 1.0f, 2.0f, 1.0f };
+			const float scale = parameters.Float("uBlurScale");
+			if (scale == 1.0f)
+			{
+				const cv::Mat kernel = (cv::Mat_<float>(3, 3) << 1, 2, 1, 2, 4, 2, 1, 2, 1) / 16.0f;
+				Convolve(src, dst, pool, kernel);
+				return;
+			}
+
+			const float stepU = scale / src.cols, stepV = scale / src.rows;
+			Shade(src, dst, pool, [stepU, stepV](const Sampler& sampler, float u, float v, int, int) {
+				Color color{};
+				for (int dy = -1; dy <= 1; ++dy)
+				{
+					for (int dx = -1; dx <= 1; ++dx)
+						color = color + sampler.Sample(u + dx * stepU, v + dy * stepV) * (weights[dx + 1] * weights[dy + 1] / 16.0f);
+				}
+				return color;
+			});
+		}
+
+		void RadialBlur(const cv::Mat& src, cv::Mat& dst, const Parameters& parameters, LibCore::Async::ThreadPool& pool)
+		{
+			const Value center = parameters.Vec("uBlurCenter");
+			const float strength = parameters.Float("uBlurStrength");
+			const int steps = parameters.Int("uBlurSteps");
+			Shade(src, dst, pool, [center, strength, steps](const Sampler& sampler, float u, float v, int, int) {
+				Color color{};
+				for (int i = 0; i < steps; ++i)
+				{
+					const float t = steps > 1 ? float(i) / float(steps - 1) : 0.0f;
+					color = color + sampler.Sample(u + (u - center[0]) * t * strength, v + (v - center[1]) * t * strength);
+				}
+				return steps > 0 ? color * (1.0f / steps) : Color{};
+			});
+		}
+
+		void Outline(const cv::Mat& src, cv::Mat& dst, const Parameters& parameters, LibCore::Async::ThreadPool& pool)
+		{
+			const float threshold = parameters.Float("uThreshold");
+			const float step = 1.0f / 1024.0f;
+			Shade(src, dst, pool, [threshold, step](const Sampler& sampler, float u, float v, int, int) {
+				const Color color = sampler.Sample(u, v);
+				const float edge =
+					Length(color - sampler.Sample(u - step, v)) + Length(color - sampler.Sample(u + step, v)) +
+					Length(color - sampler.Sample(u, v + step)) + Length(color - sampler.Sample(u, v - step));
+				return edge > threshold ? Color{} : color;
+			});
+		}
+
+		void ChromaticAberration(const cv::Mat& src, cv::Mat& dst, const Parameters& parameters, LibCore::Async::ThreadPool& pool)
+		{
+			const float intensity = parameters.Float("uIntensity");
+			Shade(src, dst, pool, [intensity](const Sampler& sampler, float u, float v, int, int) {
+				return Color{ sampler.Sample(u + intensity, v).r, sampler.Sample(u, v).g, sampler.Sample(u - intensity, v).b };
+			});
+		}
+
+		float HueToRGB(float p, float q, float t)
+		{
+			if (t < 0.0f) t += 1.0f;
+			if (t > 1.0f) t -= 1.0f;
+			if (t < 1.0f / 6.0f) return p + (q - p) * 6.0f * t;
+			if (t < 1.0f / 2.0f) return q;
+			if (t < 2.0f / 3.0f) return p + (q - p) * (2.0f / 3.0f - t) * 6.0f;
+			return p;
+		}
+
+		void HSLAdjustment(const cv::Mat& src, cv::Mat& dst, const Parameters& parameters, LibCore::Async::ThreadPool& pool)
+		{
+			const float hueShift = parameters.Float("uHue") / 360.0f;
+			const float saturation = parameters.Float("uSaturation");
+			const float lightness = parameters.Float("uLightness") - 0.5f;
+			Shade(src, dst, pool, [hueShift, saturation, lightness](const Sampler& sampler, float, float, int x, int y) {
+				const Color c = sampler.Texel(x, y);
+				const float maximum = std::max(c.r, std::max(c.g, c.b));
+				const float minimum = std::min(c.r, std::min(c.g, c.b));
+				float h = 0.0f, s = 0.0f, l = (maximum + minimum) / 2.0f;
+				if (maximum != minimum)
+				{
+					const float d = maximum - minimum;
+					s = l > 0.5f ? d / (2.0f - maximum - minimum) : d / (maximum + minimum);
+					if (maximum == c.r)
+						h = (c.g - c.b) / d + (c.g < c.b ? 6.0f : 0.0f);
+					else if (maximum == c.g)
+						h = (c.b - c.r) / d + 2.0f;
+					else
+						h = (c.r - c.g) / d + 4.0f;
+					h /= 6.0f;
+				}
+
+				h += hueShift;
+				s *= saturation;
+				l += lightness;
+
+				if (s == 0.0f)
+					return Grey(l);
+				const float q = l < 0.5f ? l * (1.0f + s) : l + s - l * s;
+				const float p = 2.0f * l - q;
+				return Color{ HueToRGB(p, q, h + 1.0f / 3.0f), HueToRGB(p, q, h), HueToRGB(p, q, h - 1.0f / 3.0f) };
+			});
+		}
+
+		void GrayScale(const cv::Mat& src, cv::Mat& dst, const Parameters&, LibCore::Async::ThreadPool& pool)
+		{
+			const float matrix[3][4] = {
+				{ 0.299f, 0.587f, 0.114f, 0.0f },
+				{ 0.299f, 0.587f, 0.114f, 0.0f },
+				{ 0.299f, 0.587f, 0.114f, 0.0f } };
+			ApplyColorMatrix(src, dst, pool, matrix);
+		}
+
+		void SepiaTone(const cv::Mat& src, cv::Mat& dst, const Parameters&, LibCore::Async::ThreadPool& pool)
+		{
+			const float matrix[3][4] = {
+				{ 0.393f, 0.769f, 0.189f, 0.0f },
+				{ 0.349f, 0.686f, 0.168f, 0.0f },
+				{ 0.272f, 0.534f, 0.131f, 0.0f } };
+			ApplyColorMatrix(src, dst, pool, matrix);
+		}
+
+		void SobelEdgeDetect(const cv::Mat& src, cv::Mat& dst, const Parameters& parameters, LibCore::Async::ThreadPool& pool)
+		{
+			const float threshold = parameters.Float("uThreshold");
+			const float step = 0.01f;	// in texture coordinates, not texels
+			Shade(src, dst, pool, [threshold, step](const Sampler& sampler, float u, float v, int, int) {
+				auto red = [&](float du, float dv) { return sampler.Sample(u + du, v + dv).r; };
+				const float gx = -red(-step, step) + red(step, step) - 2.0f * red(-step, 0.0f) + 2.0f * red(step, 0.0f) - red(-step, -step) + red(step, -step);
+				const float gy = -red(-step, -step) - 2.0f * red(0.0f, -step) - red(step, -step) + red(-step, step) + 2.0f * red(0.0f, step) + red(step, step);
+				return Grey(Length(gx, gy) > threshold ? 1.0f : 0.0f);
+			});
+		}
+
+		void PrewittEdgeDetect(const cv::Mat& src, cv::Mat& dst, const Parameters& parameters, LibCore::Async::ThreadPool& pool)
+		{
+			static const float gx[9] = { -1, 0, 1, -1, 0, 1, -1, 0, 1 };
+			static const float gy[9] = { 1, 1, 1, 0, 0, 0, -1, -1, -1 };
+			const float threshold = parameters.Float("uThreshold");
+			Shade(src, dst, pool, [threshold](const Sampler& sampler, float, float, int x, int y) {
+				Color texels[9];
+				Neighbourhood(sampler, x, y, texels);
+				return Grey(EdgeMagnitude(gx, gy, texels) > threshold ? 1.0f : 0.0f);
+			});
+		}
+
+		void RobertsCrossEdgeDetect(const cv::Mat& src, cv::Mat& dst, const Parameters& parameters, LibCore::Async::ThreadPool& pool)
+		{
+			const float threshold = parameters.Float("uThreshold");
+			Shade(src, dst, pool, [threshold](const Sampler& sampler, float, float, int x, int y) {
+				const float gx = sampler.Texel(x, y).r - sampler.Texel(x + 1, y - 1).r;
+				const float gy = sampler.Texel(x + 1, y).r - sampler.Texel(x, y - 1).r;
+				return Grey(Length(gx, gy) > threshold ? 1.0f : 0.0f);
+			});
+		}
+
+		void Distortion(const cv::Mat& src, cv::Mat& dst, const Parameters& parameters, LibCore::Async::ThreadPool& pool)
+		{
+			const float time = parameters.Float("uTime");
+			Shade(src, dst, pool, [time](const Sampler& sampler, float u, float v, int, int) {
+				return sampler.Sample(u + std::sin(v * 10.0f + time) * 0.1f, v);
+			});
+		}
+
+		void Posterisation(const cv::Mat& src, cv::Mat& dst, const Parameters& parameters, LibCore::Async::ThreadPool& pool)
+		{
+			const float levels = static_cast<float>(parameters.Int("uLevels"));
+			ApplyLUT(src, dst, pool, [levels](float value, int) { return std::floor(value * levels) / levels; });
+		}
+
+		void Noise(const cv::Mat& src, cv::Mat& dst, const Parameters& parameters, LibCore::Async::ThreadPool& pool)
+		{
+			const float amount = parameters.Float("uNoiseAmount");
+			Shade(src, dst, pool, [amount](const Sampler& sampler, float u, float v, int x, int y) {
+				const float noise = HashNoise(u, v, 1.0f, 0.0f) * amount;
+				return sampler.Texel(x, y) + Grey(noise);
+			});
+		}
+
+		void Bloom(const cv::Mat& src, cv::Mat& dst, const Parameters& parameters, LibCore::Async::ThreadPool& pool)
+		{
+			const float threshold = parameters.Float("uThreshold");
+			ApplyLUT(src, dst, pool, [threshold](float value, int) { return std::max(value - threshold, 0.0f) + value; });
+		}
+
+		void HalfTone(const cv::Mat& src, cv::Mat& dst, const Parameters& parameters, LibCore::Async::ThreadPool& pool)
+		{
+			const float dotSize = parameters.Float("uDotSize");
+			const float scaleX = src.cols / dotSize, scaleY = src.rows / dotSize;
+			Shade(src, dst, pool, [scaleX, scaleY](const Sampler& sampler, float u, float v, int x, int y) {
+				const Color color = sampler.Texel(x, y);
+				const float radius = Length(color) * 0.5f;
+				return Length(Fract(u * scaleX) - 0.5f, Fract(v * scaleY) - 0.5f) < radius ? color : Grey(1.0f);
+			});
+		}
+
+		void VHS(const cv::Mat& src, cv::Mat& dst, const Parameters& parameters, LibCore::Async::ThreadPool& pool)
+		{
+			const float time = parameters.Float("uTime");
+			Shade(src, dst, pool, [time](const Sampler& sampler, float u, float v, int, int) {
+				const float glitchU = u + std::sin(v * 50.0f + time * 5.0f) * 0.005f;
+				Color color{ sampler.Sample(glitchU + 0.005f, v).r, sampler.Sample(glitchU, v).g, sampler.Sample(glitchU - 0.005f, v).b };
+				if (HashNoise(u, v, 1.0f, 0.0f) > 0.95f)
+					color = color + Grey(0.2f);
+				return color;
+			});
+		}
+
+		void Mosaic(const cv::Mat& src, cv::Mat& dst, const Parameters& parameters, LibCore::Async::ThreadPool& pool)
+		{
+			const float cellSize = parameters.Float("uMosaicSize");
+			const float width = static_cast<float>(src.cols), height = static_cast<float>(src.rows);
+			Shade(src, dst, pool, [cellSize, width, height](const Sampler& sampler, float u, float v, int, int) {
+				return sampler.Sample(std::floor(u * width / cellSize) * cellSize / width, std::floor(v * height / cellSize) * cellSize / height);
+			});
+		}
+
+		void GodsRay(const cv::Mat& src, cv::Mat& dst, const Parameters& parameters, LibCore::Async::ThreadPool& pool)
+		{
+			const Value light = parameters.Vec("uLightPosition");
+			const float intensity = parameters.Float("uIntensity");
+			const float size = parameters.Float("uSize");
+			Shade(src, dst, pool, [light, intensity, size](const Sampler& sampler, float u, float v, int x, int y) {
+				const float attenuation = std::max(0.0f, 1.0f - Length(u - light[0], v - light[1]) * (10.0f - size));
+				return sampler.Texel(x, y) * (attenuation * intensity);
+			});
+		}
+
+		void Swirling(const cv::Mat& src, cv::Mat& dst, const Parameters& parameters, LibCore::Async::ThreadPool& pool)
+		{
+			const Value center = parameters.Vec("uCenter");
+			const float strength = parameters.Float("uStrength");
+			const float time = parameters.Float("uTime");
+			Shade(src, dst, pool, [center, strength, time](const Sampler& sampler, float u, float v, int, int) {
+				const float offsetX = u - center[0], offsetY = v - center[1];
+				float angle = std::atan2(offsetY, offsetX);
+				angle += strength * std::sin(angle + time * 3.0f);
+				const float radius = Length(offsetX, offsetY);
+				return sampler.Sample(center[0] + std::cos(angle) * radius, center[1] + std::sin(angle) * radius);
+			});
+		}
+
+		void GradientOverlay(const cv::Mat& src, cv::Mat& dst, const Parameters& parameters, LibCore::Async::ThreadPool& pool)
+		{
+			const Value from = parameters.Vec("uColor1"), to = parameters.Vec("uColor2");
+			Shade(src, dst, pool, [from, to](const Sampler& sampler, float, float v, int x, int y) {
+				const Color gradient = Mix(Color{ from[0], from[1], from[2] }, Color{ to[0], to[1], to[2] }, v);
+				return Mix(sampler.Texel(x, y), gradient, 0.5f);
+			});
+		}
+
+		void DynamicRipple(const cv::Mat& src, cv::Mat& dst, const Parameters& parameters, LibCore::Async::ThreadPool& pool)
+		{
+			const Value center = parameters.Vec("uCenter");
+			const float time = parameters.Float("uTime");
+			const float amplitude = parameters.Float("uAmplitude");
+			const float frequency = parameters.Float("uFrequency");
+			Shade(src, dst, pool, [center, time, amplitude, frequency](const Sampler& sampler, float u, float v, int, int) {
+				const float offsetX = u - center[0], offsetY = v - center[1];
+				const float ripple = std::sin(Length(offsetX, offsetY) * frequency - time) * amplitude;
+				float dirX = 0.0f, dirY = 0.0f;
+				Direction(offsetX, offsetY, dirX, dirY);
+				return sampler.Sample(u + dirX * ripple, v + dirY * ripple);
+			});
+		}
+
+		void Emboss(const cv::Mat& src, cv::Mat& dst, const Parameters& parameters, LibCore::Async::ThreadPool& pool)
+		{
+			const Value texelSize = parameters.Vec("uTexelSize");
+			const float stepU = texelSize[0] / src.cols, stepV = texelSize[1] / src.rows;
+			Shade(src, dst, pool, [stepU, stepV](const Sampler& sampler, float u, float v, int, int) {
+				return sampler.Sample(u + stepU, v) - sampler.Sample(u, v + stepV) + Grey(0.5f);
+			});
+		}
+
+		void GlitchLines(const cv::Mat& src, cv::Mat& dst, const Parameters& parameters, LibCore::Async::ThreadPool& pool)
+		{
+			const float time = parameters.Float("uTime");
+			const float glitchSize = parameters.Float("uGlitchSize");
+			Shade(src, dst, pool, [time, glitchSize](const Sampler& sampler, float u, float v, int, int y) {
+				const float fragY = y + 0.5f;
+				if (Fract(fragY * 0.1f + time) < glitchSize)
+					u += std::sin(time + fragY * 0.1f) * 0.02f;
+				return sampler.Sample(u, v);
+			});
+		}
+
+		void LensDistortion(const cv::Mat& src, cv::Mat& dst, const Parameters& parameters, LibCore::Async::ThreadPool& pool)
+		{
+			const float distortion = parameters.Float("uDistortion");
+			Shade(src, dst, pool, [distortion](const Sampler& sampler, float u, float v, int, int) {
+				const float x = u * 2.0f - 1.0f, y = v * 2.0f - 1.0f;
+				const float radius = Length(x, y);
+				const float scale = 1.0f + distortion * radius * radius;
+				return sampler.Sample(x * scale * 0.5f + 0.5f, y * scale * 0.5f + 0.5f);
+			});
+		}
+
+		void FishEye(const cv::Mat& src, cv::Mat& dst, const Parameters& parameters, LibCore::Async::ThreadPool& pool)
+		{
+			const float strength = parameters.Float("uStrength");
+			Shade(src, dst, pool, [strength](const Sampler& sampler, float u, float v, int, int) {
+				const float x = u * 2.0f - 1.0f, y = v * 2.0f - 1.0f;
+				const float scale = 1.0f / (1.0f + strength * Length(x, y));
+				return sampler.Sample(x * scale * 0.5f + 0.5f, y * scale * 0.5f + 0.5f);
+			});
+		}
+
+		void ASCII(const cv::Mat& src, cv::Mat& dst, const Parameters& parameters, LibCore::Async::ThreadPool& pool)
+		{
+			static const float levels[10] = { 0.0f, 0.1f, 0.2f, 0.4f, 0.5f, 0.6f, 0.7f, 0.8f, 0.9f, 1.0f };
+			const float blockSize = static_cast<float>(parameters.Int("blockSize"));
+			const float width = static_cast<float>(src.cols), height = static_cast<float>(src.rows);
+			Shade(src, dst, pool, [blockSize, width, height](const Sampler& sampler, float u, float v, int, int) {
+				const float intensity = sampler.Sample(std::floor(u * width / blockSize) * blockSize / width, std::floor(v * height / blockSize) * blockSize / height).r;
+				// white would index past the table in the shader, it gets the last level here
+				return Grey(levels[std::clamp(static_cast<int>(intensity * 10.0f), 0, 9)]);
+			});
+		}
+
+		void PolarCoords(const cv::Mat& src, cv::Mat& dst, const Parameters&, LibCore::Async::ThreadPool& pool)
+		{
+			Shade(src, dst, pool, [](const Sampler& sampler, float u, float v, int, int) {
+				const float x = u * 2.0f - 1.0f, y = v * 2.0f - 1.0f;
+				return sampler.Sample(std::atan2(y, x) / 3.14159265f, Length(x, y));
+			});
+		}
+
+		void DoubleVision(const cv::Mat& src, cv::Mat& dst, const Parameters& parameters, LibCore::Async::ThreadPool& pool)
+		{
+			const Value offset = parameters.Vec("offset");
+			Shade(src, dst, pool, [offset](const Sampler& sampler, float u, float v, int x, int y) {
+				return Mix(sampler.Texel(x, y), sampler.Sample(u + offset[0], v + offset[1]), 0.5f);
+			});
+		}
+
+		void Sharpen(const cv::Mat& src, cv::Mat& dst, const Parameters& parameters, LibCore::Async::ThreadPool& pool)
+		{
+			// mix(original, convolved, s) is one kernel: s * sharpen + (1 - s) * identity
+			const float sharpness = parameters.Float("uSharpness");
+			const cv::Mat kernel = (cv::Mat_<float>(3, 3) <<
+				0.0f, -sharpness, 0.0f,
+				-sharpness, 1.0f + 4.0f * sharpness, -sharpness,
+				0.0f, -sharpness, 0.0f);
+			Convolve(src, dst, pool, kernel);
+		}
+
+		void SnowFall(const cv::Mat& src, cv::Mat& dst, const Parameters& parameters, LibCore::Async::ThreadPool& pool)
+		{
+			const float time = parameters.Float("uTime");
+			Shade(src, dst, pool, [time](const Sampler& sampler, float u, float v, int x, int y) {
+				const float snow = HashNoise(u, v, 10.0f, time);
+				return snow >= 0.9f ? Grey(1.0f) : sampler.Texel(x, y);
+			});
+		}
+
+		void HexagonalPixel(const cv::Mat& src, cv::Mat& dst, const Parameters& parameters, LibCore::Async::ThreadPool& pool)
+		{
+			const float size = parameters.Float("uSize");
+			auto glslMod = [](float x, float y) { return x - y * std::floor(x / y); };
+			Shade(src, dst, pool, [size, glslMod](const Sampler& sampler, float u, float v, int, int) {
+				const float hexX = u / size, hexY = v / size;
+				float qx = hexX - hexY / 2.0f, qy = hexY;
+				qx = std::floor(qx + 0.5f) - glslMod(std::floor(qx), 2.0f) / 2.0f;
+				qy = std::floor(qy + 0.5f) - glslMod(std::floor(qy), 2.0f) / 2.0f;
+				return sampler.Sample((qx + qy / 2.0f) * size, qy * size);
+			});
+		}
+
+		void DoorTransparency(const cv::Mat& src, cv::Mat& dst, const Parameters& parameters, LibCore::Async::ThreadPool& pool)
+		{
+			const float alpha = parameters.Float("alpha");
+			Shade(src, dst, pool, [alpha](const Sampler& sampler, float, float, int x, int y) {
+				const float threshold = Fract((x + 0.5f) + (y + 0.5f) * 0.5f);
+				return alpha < threshold ? sampler.Texel(x, y) : Color{};
+			});
+		}
+
+		void Toon(const cv::Mat& src, cv::Mat& dst, const Parameters& parameters, LibCore::Async::ThreadPool& pool)
+		{
+			const float factor = 1.0f / static_cast<float>(parameters.Int("uLevels"));
+			ApplyLUT(src, dst, pool, [factor](float value, int) { return std::floor(value / factor) * factor; });
+		}
+
+		void XRay(const cv::Mat& src, cv::Mat& dst, const Parameters&, LibCore::Async::ThreadPool& pool)
+		{
+			const float matrix[3][4] = {
+				{ -0.299f, -0.587f, -0.114f, 1.0f },
+				{ 0.299f, 0.587f, 0.114f, 0.0f },
+				{ -0.299f, -0.587f, -0.114f, 1.0f } };
+			ApplyColorMatrix(src, dst, pool, matrix);
+		}
+
+		void NeonGlow(const cv::Mat& src, cv::Mat& dst, const Parameters& parameters, LibCore::Async::ThreadPool& pool)
+		{
+			const Value glow = parameters.Vec("uGlowColor");
+			Shade(src, dst, pool, [glow](const Sampler& sampler, float, float, int x, int y) {
+				const Color color = sampler.Texel(x, y);
+				return color + Color{ glow[0], glow[1], glow[2] } * (Length(color) * 2.0f);
+			});
+		}
+
+		void NightVision(const cv::Mat& src, cv::Mat& dst, const Parameters& parameters, LibCore::Async::ThreadPool& pool)
+		{
+			const Value tint = parameters.Vec("uNightVisionColor");
+			float matrix[3][4] = {};
+			for (int row = 0; row < 3; ++row)
+			{
+				matrix[row][0] = tint[row] * 2.0f * 0.299f;
+				matrix[row][1] = tint[row] * 2.0f * 0.587f;
+				matrix[row][2] = tint[row] * 2.0f * 0.114f;
+			}
+			ApplyColorMatrix(src, dst, pool, matrix);
+		}
+
+		void ExplosionDistortion(const cv::Mat& src, cv::Mat& dst, const Parameters& parameters, LibCore::Async::ThreadPool& pool)
+		{
+			const Value center = parameters.Vec("uCenter");
+			const float time = parameters.Float("uTime");
+			const float intensity = parameters.Float("uIntensity");
+			Shade(src, dst, pool, [center, time, intensity](const Sampler& sampler, float u, float v, int, int) {
+				const float dirX = u - center[0], dirY = v - center[1];
+				const float distortion = std::sin(Length(dirX, dirY) * 10.0f - time * 5.0f) * intensity;
+				float normalX = 0.0f, normalY = 0.0f;
+				Direction(dirX, dirY, normalX, normalY);
+				return sampler.Sample(u + normalX * distortion, v + normalY * distortion);
+			});
+		}
+
+		void Contrast(const cv::Mat& src, cv::Mat& dst, const Parameters& parameters, LibCore::Async::ThreadPool& pool)
+		{
+			const float contrast = parameters.Float("uContrast");
+			ApplyLUT(src, dst, pool, [contrast](float value, int) { return (value - 0.5f) * contrast + 0.5f; });
+		}
+
+		void Brightness(const cv::Mat& src, cv::Mat& dst, const Parameters& parameters, LibCore::Async::ThreadPool& pool)
+		{
+			const float brightness = parameters.Float("uBrightness");
+			ApplyLUT(src, dst, pool, [brightness](float value, int) { return value + brightness; });
+		}
+
+		void Temperature(const cv::Mat& src, cv::Mat& dst, const Parameters& parameters, LibCore::Async::ThreadPool& pool)
+		{
+			const float shift = parameters.Float("uTemperature") * 0.1f;
+			ApplyLUT(src, dst, pool, [shift](float value, int channel) {
+				return channel == 0 ? value + shift : channel == 2 ? value - shift : value;
+			});
+		}
+
+		void Gamma(const cv::Mat& src, cv::Mat& dst, const Parameters& parameters, LibCore::Async::ThreadPool& pool)
+		{
+			const float exponent = 1.0f / parameters.Float("uGamma");
+			ApplyLUT(src, dst, pool, [exponent](float value, int) { return std::pow(value, exponent); });
+		}
+
+		void Vignette(const cv::Mat& src, cv::Mat& dst, const Parameters& parameters, LibCore::Async::ThreadPool& pool)
+		{
+			const float strength = parameters.Float("uVignetteStrength");
+			Shade(src, dst, pool, [strength](const Sampler& sampler, float u, float v, int x, int y) {
+				const float edge = 1.0f - strength * Length(u - 0.5f, v - 0.5f);
+				const float t = std::clamp((edge - 0.5f) / (0.9f - 0.5f), 0.0f, 1.0f);
+				return sampler.Texel(x, y) * (t * t * (3.0f - 2.0f * t));
+			});
+		}
+
+		// ---- CannyShaders.h ---------------------------------------------------------------------------------
+
+		void CannyBlur(const cv::Mat& src, cv::Mat& dst, const Parameters&, LibCore::Async::ThreadPool& pool)
+		{
+			const cv::Mat kernel = (cv::Mat_<float>(5, 5) <<
+				1, 4, 6, 4, 1,
+				4, 16, 24, 16, 4,
+				6, 24, 36, 24, 6,
+				4, 16, 24, 16, 4,
+				1, 4, 6, 4, 1) / 256.0f;
+			Convolve(src, dst, pool, kernel);
+		}
+
+		void CannySobel(const cv::Mat& src, cv::Mat& dst, const Parameters&, LibCore::Async::ThreadPool& pool)
+		{
+			// the shader's mat3 constants are column major and indexed [i + 1][j + 1], kept as written
+			static const float gx[9] = { -1, 0, 1, -2, 0, 2, -1, 0, 1 };
+			static const float gy[9] = { -1, -2, -1, 0, 0, 0, 1, 2, 1 };
+			Shade(src, dst, pool, [](const Sampler& sampler, float, float, int x, int y) {
+				float sobelX = 0.0f, sobelY = 0.0f;
+				for (int i = -1; i <= 1; ++i)
+				{
+					for (int j = -1; j <= 1; ++j)
+					{
+						const float red = sampler.Texel(x + i, y + j).r;
+						sobelX += red * gx[(i + 1) * 3 + j + 1];
+						sobelY += red * gy[(i + 1) * 3 + j + 1];
+					}
+				}
+				return Color{ Length(sobelX, sobelY), std::atan2(sobelY, sobelX), 0.0f };
+			});
+		}
+
+		void CannyThreshold(const cv::Mat& src, cv::Mat& dst, const Parameters& parameters, LibCore::Async::ThreadPool& pool)
+		{
+			const float low = parameters.Float("uEdgeThresholdLow");
+			const float high = parameters.Float("uEdgeThresholdHigh");
+			Shade(src, dst, pool, [low, high](const Sampler& sampler, float, float, int x, int y) {
+				const float magnitude = sampler.Texel(x, y).r;
+				return Grey(magnitude >= high ? 1.0f : magnitude >= low ? 0.5f : 0.0f);
+			});
+		}
+
+		void CannyHysteresis(const cv::Mat& src, cv::Mat& dst, const Parameters&, LibCore::Async::ThreadPool& pool)
+		{
+			// compares exactly like the shader: a stored 0.5 reads back as 128 / 255, so weak edges never match
+			Shade(src, dst, pool, [](const Sampler& sampler, float, float, int x, int y) {
+				const float center = sampler.Texel(x, y).r;
+				if (center == 1.0f)
+					return Grey(1.0f);
+				if (center != 0.5f)
+					return Grey(0.0f);
+
+				static const int offsets[8][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 }, { 1, 1 }, { -1, -1 }, { 1, -1 }, { -1, 1 } };
+				for (auto& offset : offsets)
+				{
+					if (sampler.Texel(x + offset[0], y + offset[1]).r == 1.0f)
+						return Grey(1.0f);
+				}
+				return Grey(0.0f);
+			});
+		}
+
+		// ---- BlurShaders.h -----------------------------------------------------------------------------------
+		// TextureFilter drives the pyramids' passes itself, here each pyramid is one kernel over the whole list
+
+		// widths of three stacked box blurs with the variance of a gaussian of sigma, as radii
+		std::array<int, 3> BoxRadii(float sigma)
+		{
+			const float boxes = 3.0f, variance = sigma * sigma;
+			int lower = static_cast<int>(std::floor(std::sqrt(12.0f * variance / boxes + 1.0f)));
+			if (lower % 2 == 0)
+				--lower;
+			const int lowerCount = static_cast<int>(std::round((12.0f * variance - boxes * lower * lower - 4.0f * boxes * lower - 3.0f * boxes) / (-4.0f * lower - 4.0f)));
+
+			std::array<int, 3> results{};
+			for (int i = 0; i < 3; ++i)
+				results[i] = ((i < lowerCount ? lower : lower + 2) - 1) / 2;
+			return results;
+		}
+
+		// running sums, one add and one subtract per texel whatever the radius; edges wrap like GL_REPEAT
+		void BoxBlurRows(const cv::Mat& src, cv::Mat& dst, int radius, LibCore::Async::ThreadPool& pool)
+		{
+			const int width = src.cols;
+			const double scale = 1.0 / (2 * radius + 1);
+			ForEachRows(pool, src.rows, width, [&](int begin, int end) {
+				for (int y = begin; y < end; ++y)
+				{
+					const float* in = src.ptr<float>(y);
+					float* out = dst.ptr<float>(y);
+
+					double sums[3] = {};
+					for (int x = -radius; x <= radius; ++x)
+					{
+						for (int c = 0; c < 3; ++c)
+							sums[c] += in[3 * Wrap(x, width) + c];
+					}
+					for (int x = 0; x < width; ++x)
+					{
+						const float* add = in + 3 * Wrap(x + radius + 1, width);
+						const float* remove = in + 3 * Wrap(x - radius, width);
+						for (int c = 0; c < 3; ++c)
+						{
+							out[3 * x + c] = static_cast<float>(sums[c] * scale);
+							sums[c] += add[c] - remove[c];
+						}
+					}
+				}
+			});
+		}
+
+		// whole rows at a time over a band of interleaved channel columns, so the reads stay sequential
+		void BoxBlurColumns(const cv::Mat& src, cv::Mat& dst, int radius, LibCore::Async::ThreadPool& pool)
+		{
+			const int height = src.rows;
+			const double scale = 1.0 / (2 * radius + 1);
+			const LibCore::Async::Range columns{ 0, static_cast<size_t>(src.cols) * 3 };
+			LibCore::Async::ParallelFor(pool, columns, CPU_FILTER_COLUMN_GRAIN, [&](const LibCore::Async::Range& band) {
+				const size_t begin = band.Begin, count = band.Size();
+
+				std::vector<double> sums(count, 0.0);
+				for (int y = -radius; y <= radius; ++y)
+				{
+					const float* in = src.ptr<float>(Wrap(y, height)) + begin;
+					for (size_t i = 0; i < count; ++i)
+						sums[i] += in[i];
+				}
+				for (int y = 0; y < height; ++y)
+				{
+					const float* add = src.ptr<float>(Wrap(y + radius + 1, height)) + begin;
+					const float* remove = src.ptr<float>(Wrap(y - radius, height)) + begin;
+					float* out = dst.ptr<float>(y) + begin;
+					for (size_t i = 0; i < count; ++i)
+					{
+						out[i] = static_cast<float>(sums[i] * scale);
+						sums[i] += add[i] - remove[i];
+					}
+				}
+			});
+		}
+
+		// the GPU pyramid rounds to 8 bits between passes, this stays in float until the end
+		void PyramidBlur(const cv::Mat& src, cv::Mat& dst, const Parameters& parameters, LibCore::Async::ThreadPool& pool)
+		{
+			cv::Mat work, scratch(src.size(), CV_32FC3);
+			src.convertTo(work, CV_32FC3, 1.0 / 255.0);
+			for (int radius : BoxRadii(std::max(parameters.Float("uBlurRadius"), 0.0f)))
+			{
+				if (radius == 0)
+					continue;
+				BoxBlurRows(work, scratch, radius, pool);
+				BoxBlurColumns(scratch, work, radius, pool);
+			}
+			work.convertTo(dst, CV_8UC3, 255.0);
+		}
+
+		// same levels as TextureFilter::PyramidBloomPasses; cv::resize area and bilinear filters stand in for
+		// the 2x2 average and the tent, so the glow matches in shape rather than to the level
+		void PyramidBloom(const cv::Mat& src, cv::Mat& dst, const Parameters& parameters, LibCore::Async::ThreadPool& pool)
+		{
+			const float threshold = parameters.Float("uThreshold");
+			const double spread = parameters.Float("uBloomSpread");
+			const double intensity = parameters.Float("uBloomIntensity");
+
+			int levels = std::clamp(parameters.Int("uBloomLevels"), 1, 8);
+			while (levels > 1 && ((src.cols >> levels) == 0 || (src.rows >> levels) == 0))
+				--levels;
+			auto levelSize = [&src](int level) { return cv::Size{ std::max(1, src.cols >> level), std::max(1, src.rows >> level) }; };
+
+			std::vector<cv::Mat> pyramid(1, cv::Mat(src.size(), CV_8UC3));
+			ApplyLUT(src, pyramid[0], pool, [threshold](float value, int) { return std::max(value - threshold, 0.0f); });
+			for (int level = 1; level <= levels; ++level)
+			{
+				pyramid.emplace_back();
+				cv::resize(pyramid[level - 1], pyramid[level], levelSize(level), 0.0, 0.0, cv::INTER_AREA);
+			}
+
+			cv::Mat glow = pyramid.back(), coarse;
+			for (int level = levels - 1; level >= 1; --level)
+			{
+				cv::resize(glow, coarse, levelSize(level), 0.0, 0.0, cv::INTER_LINEAR);
+				cv::addWeighted(pyramid[level], 1.0 - spread, coarse, spread, 0.0, glow);
+			}
+
+			cv::resize(glow, coarse, src.size(), 0.0, 0.0, cv::INTER_LINEAR);
+			cv::addWeighted(src, 1.0, coarse, intensity, 0.0, dst);
+		}
+
+		// the whole list at once, like TextureFilter's compute path: the red channel padded with wrapped texels,
+		// the same 5x5 binomial blur (OpenCV's fixed kernel for ksize 5), then cv::Canny with the L2 gradient,
+		// which also thins the edges and runs hysteresis over the whole image; thresholds are in 8 bit units
+		void CannyEdgeDetect(const cv::Mat& src, cv::Mat& dst, const Parameters& parameters, LibCore::Async::ThreadPool&)
+		{
+			const int padding = 4;	// 2 for the blur, 1 for the gradient, 1 for the suppression
+			cv::Mat red, padded, edges;
+			cv::extractChannel(src, red, 2);
+			cv::copyMakeBorder(red, padded, padding, padding, padding, padding, cv::BORDER_WRAP);
+			cv::GaussianBlur(padded, padded, cv::Size{ 5, 5 }, 0.0);
+			cv::Canny(padded, edges, parameters.Float("uEdgeThresholdLow") * 255.0, parameters.Float("uEdgeThresholdHigh") * 255.0, 3, true);
+			cv::cvtColor(edges(cv::Rect{ padding, padding, src.cols, src.rows }), dst, cv::COLOR_GRAY2BGR);
+		}
+
+		using Kernel = std::function<void(const cv::Mat& src, cv::Mat& dst, const Parameters& parameters, LibCore::Async::ThreadPool& pool)>;
+
+		struct BuiltInKernel
+		{
+			const char* Source;
+			Kernel Run;
+		};
+
+		const std::vector<BuiltInKernel>& BuiltInKernels()
+		{
+			static const std::vector<BuiltInKernel> kernels = {
+				{ LibGraphics::GAUSSIAN_BLUR_SHADER, GaussianBlur },
+				{ LibGraphics::RADIAL_BLUR_SHADER, RadialBlur },
+				{ LibGraphics::OUTLINE_SHADER, Outline },
+				{ LibGraphics::CHROMATIC_ABERRATION_SHADER, ChromaticAberration },
+				{ LibGraphics::HSL_ADJUSTMENT_SHADER, HSLAdjustment },
+				{ LibGraphics::GRAY_SCALE_SHADER, GrayScale },
+				{ LibGraphics::SEPIA_TONE_SHADER, SepiaTone },
+				{ LibGraphics::SOBEL_EDGE_DETECT_SHADER, SobelEdgeDetect },
+				{ LibGraphics::PREWITT_EDGE_DETECT_SHADER, PrewittEdgeDetect },
+				{ LibGraphics::ROBERTS_CROSS_EDGE_DETECT_SHADER, RobertsCrossEdgeDetect },
+				{ LibGraphics::DISTORTION_SHADER, Distortion },
+				{ LibGraphics::POSTERISATION_SHADER, Posterisation },
+				{ LibGraphics::NOISE_SHADER, Noise },
+				{ LibGraphics::BLOOM_SHADER, Bloom },
+				{ LibGraphics::HALF_TONE_SHADER, HalfTone },
+				{ LibGraphics::VHS_SHADER, VHS },
+				{ LibGraphics::MOSIAC_SHADER, Mosaic },
+				{ LibGraphics::GODS_RAY_SHADER, GodsRay },
+				{ LibGraphics::SWIRLING_SHADER, Swirling },
+				{ LibGraphics::GRADIENT_OVERLAY_SHADER, GradientOverlay },
+				{ LibGraphics::DYNAMIC_RIPPLE_SHADER, DynamicRipple },
+				{ LibGraphics::EMBOSS_SHADER, Emboss },
+				{ LibGraphics::GLITCH_LINES_SHADER, GlitchLines },
+				{ LibGraphics::LENS_DISTORTION_SHADER, LensDistortion },
+				{ LibGraphics::FISH_EYE_SHADER, FishEye },
+				{ LibGraphics::ASCII_SHADER, ASCII },
+				{ LibGraphics::POLAR_COORDS_SHADER, PolarCoords },
+				{ LibGraphics::DOUBLE_VISION_SHADER, DoubleVision },
+				{ LibGraphics::SHARPEN_SHADER, Sharpen },
+				{ LibGraphics::SNOW_FALL_SHADER, SnowFall },
+				{ LibGraphics::HEXAGONAL_PIXEL_SHADER, HexagonalPixel },
+				{ LibGraphics::DOOR_TRANSPARENCY_SHADER, DoorTransparency },
+				{ LibGraphics::TOON_SHADER, Toon },
+				{ LibGraphics::XRAY_SHADER, XRay },
+				{ LibGraphics::NEON_GLOW_SHADER, NeonGlow },
+				{ LibGraphics::NIGHT_VISION_SHADER, NightVision },
+				{ LibGraphics::EXPLOSION_DISTORTION_SHADER, ExplosionDistortion },
+				{ LibGraphics::CONTRAST_SHADER, Contrast },
+				{ LibGraphics::BRIGHTNESS_SHADER, Brightness },
+				{ LibGraphics::TEMPERATURE_SHADER, Temperature },
+				{ LibGraphics::GAMMA_SHADER, Gamma },
+				{ LibGraphics::VIGNETTE_SHADER, Vignette },
+				{ LibGraphics::CANNY_EDGE_DETECT_BLUR_SHADER, CannyBlur },
+				{ LibGraphics::CANNY_EDGE_DETECT_SOBEL_SHADER, CannySobel },
+				{ LibGraphics::CANNY_EDGE_DETECT_THRESHOLD_SHADER, CannyThreshold },
+				{ LibGraphics::CANNY_EDGE_DETECT_HYSTERIESIS_SHADER, CannyHysteresis },
+			};
+			return kernels;
+		}
+
+		// filters whose passes only make sense together, keyed by their whole source list
+		struct BuiltInFilter
+		{
+			std::vector<const char*> Sources;
+			Kernel Run;
+		};
+
+		const std::vector<BuiltInFilter>& BuiltInFilters()
+		{
+			static const std::vector<BuiltInFilter> filters = {
+				{ { LibGraphics::SEPARABLE_GAUSSIAN_BLUR_SHADER, LibGraphics::SEPARABLE_GAUSSIAN_BLUR_SHADER, LibGraphics::BLUR_RESAMPLE_SHADER }, PyramidBlur },
+				{ { LibGraphics::BLOOM_BRIGHT_PASS_SHADER, LibGraphics::BLUR_RESAMPLE_SHADER, LibGraphics::BLOOM_UPSAMPLE_SHADER, LibGraphics::BLOOM_COMPOSITE_SHADER }, PyramidBloom },
+				{ { LibGraphics::CANNY_EDGE_DETECT_BLUR_SHADER, LibGraphics::CANNY_EDGE_DETECT_SOBEL_SHADER, LibGraphics::CANNY_EDGE_DETECT_THRESHOLD_SHADER, LibGraphics::CANNY_EDGE_DETECT_HYSTERIESIS_SHADER }, CannyEdgeDetect },
+			};
+			return filters;
+		}
+
+		// whitespace never changes what a shader does, but does change with line endings and indentation
+		std::string NormaliseSource(const std::string& source)
+		{
+			std::string results;
+			results.reserve(source.size());
+			for (char c : source)
+			{
+				if (!std::isspace(static_cast<unsigned char>(c)))
+					results += c;
+			}
+			return results;
+		}
+
+		// `uniform vec2 uCenter = vec2(0.5);` style initialisers, uniforms without one are zero like in GL
+		Parameters ParseDefaults(const std::string& source)
+		{
+			static const std::regex uniformPattern{ R"(uniform\s+(?:float|int|vec2|vec3|vec4)\s+(\w+)\s*=\s*([^;]+);)" };
+			static const std::regex numberPattern{ R"([-+]?(?:\d+\.?\d*|\.\d+)(?:[eE][-+]?\d+)?)" };
+
+			Parameters results;
+			for (auto uniform = std::sregex_iterator(source.begin(), source.end(), uniformPattern); uniform != std::sregex_iterator{}; ++uniform)
+			{
+				std::string initialiser = (*uniform)[2].str();
+				const size_t open = initialiser.find('('), close = initialiser.rfind(')');
+				if (open != std::string::npos && close != std::string::npos && close > open)
+					initialiser = initialiser.substr(open + 1, close - open - 1);
+
+				Value value{};
+				size_t components = 0;
+				for (auto number = std::sregex_iterator(initialiser.begin(), initialiser.end(), numberPattern); number != std::sregex_iterator{} && components < value.size(); ++number)
+					value[components++] = std::stof(number->str());
+				if (components == 1)
+					value.fill(value[0]);
+
+				results.Set((*uniform)[1].str(), value);
+			}
+			return results;
+		}
+	}
+
+	struct CPUFilter::Pass
+	{
+		Kernel Run;
+		Parameters Defaults;
+	};
+
+	namespace
+	{
+		std::shared_ptr<const CPUFilter::Pass> FindPass(const std::string& fragShader)
+		{
+			static const auto passes = []() {
+				std::unordered_map<std::string, std::shared_ptr<const CPUFilter::Pass>> results;
+				for (auto& kernel : BuiltInKernels())
+					results[NormaliseSource(kernel.Source)] = std::make_shared<const CPUFilter::Pass>(CPUFilter::Pass{ kernel.Run, ParseDefaults(kernel.Source) });
+				return results;
+			}();
+
+			auto found = passes.find(NormaliseSource(fragShader));
+			return found == passes.end() ? nullptr : found->second;
+		}
+
+		// the whole list as one pass, defaults gathered from every source
+		std::shared_ptr<const CPUFilter::Pass> FindFilter(const std::vector<std::string>& fragShaders)
+		{
+			static const auto filters = []() {
+				std::unordered_map<std::string, std::shared_ptr<const CPUFilter::Pass>> results;
+				for (auto& filter : BuiltInFilters())
+				{
+					std::string key, sources;
+					for (auto& source : filter.Sources)
+					{
+						key += NormaliseSource(source) + '\n';
+						sources += source;
+					}
+					results[key] = std::make_shared<const CPUFilter::Pass>(CPUFilter::Pass{ filter.Run, ParseDefaults(sources) });
+				}
+				return results;
+			}();
+
+			std::string key;
+			for (auto& source : fragShaders)
+				key += NormaliseSource(source) + '\n';
+			auto found = filters.find(key);
+			return found == filters.end() ? nullptr : found->second;
+		}
+	}
+
+	std::shared_ptr<CPUFilter> CPUFilter::CreateFromShader(const std::string& fragShader)
+	{
+		return CreateFromShaders({ fragShader });
+	}
+
+	std::shared_ptr<CPUFilter> CPUFilter::CreateFromShaders(const std::vector<std::string>& fragShaders)
+	{
+		auto results = std::shared_ptr<CPUFilter>{ new CPUFilter{} };
+		if (auto filter = FindFilter(fragShaders))
+		{
+			results->passes.push_back(std::move(filter));
+			return results;
+		}
+
+		for (auto& shader : fragShaders)
+		{
+			auto pass = FindPass(shader);
+			if (!pass)
+				return nullptr;
+			results->passes.push_back(std::move(pass));
+		}
+		return results;
+	}
+
+	bool CPUFilter::Supports(const std::string& fragShader)
+	{
+		return FindPass(fragShader) != nullptr;
+	}
+
+	std::shared_ptr<CPUFilter> CPUFilter::Deserialize(LibCore::Event::TraceReader& reader)
+	{
+		auto sources = LibCore::Utils::FilterParameters::DeserializeSources(reader);
+		if (sources.empty())
+			return nullptr;
+
+		auto results = CreateFromShaders(sources);
+		if (!results)
+			return nullptr;
+		return results->uniformValues.Deserialize(reader) ? results : nullptr;
+	}
+
+	std::shared_ptr<Image> CPUFilter::Apply(const std::shared_ptr<Image>& image, LibCore::Async::ThreadPool& pool) const
+	{
+		const cv::Mat& input = *(cv::Mat*)image->cvMatPtr;
+		if (passes.empty() || input.empty())
+			return image->Clone();
+
+		// the GL path uploads 8 bit colour and renders to RGB8, alpha never survives a pass
+		cv::Mat source = input;
+		if (input.channels() == 1)
+			cv::cvtColor(input, source, cv::COLOR_GRAY2BGR);
+		else if (input.channels() == 4)
+			cv::cvtColor(input, source, cv::COLOR_BGRA2BGR);
+
+		// set values over the source defaults, in the order TextureFilter::Apply sets them
+		Parameters overrides;
+		for (auto& p : uniformValues.Ints)   overrides.Set(p.first, Value{ static_cast<float>(p.second) });
+		for (auto& p : uniformValues.Floats) overrides.Set(p.first, Value{ p.second });
+		for (auto& p : uniformValues.Vec2s)  overrides.Set(p.first, Value{ p.second.x, p.second.y });
+		for (auto& p : uniformValues.Vec3s)  overrides.Set(p.first, Value{ p.second.x, p.second.y, p.second.z });
+		for (auto& p : uniformValues.Vec4s)  overrides.Set(p.first, Value{ p.second.x, p.second.y, p.second.z, p.second.w });
+
+		// two buffers like the framebuffer ping-pong, the input is never written
+		cv::Mat buffers[2] = { cv::Mat(source.size(), CV_8UC3), cv::Mat(source.size(), CV_8UC3) };
+		for (size_t i = 0; i < passes.size(); ++i)
+		{
+			Parameters parameters = passes[i]->Defaults;
+			parameters.Override(overrides);
+			auto& target = buffers[i % 2];
+			passes[i]->Run(i == 0 ? source : buffers[(i + 1) % 2], target, parameters, pool);
+		}
+
+		auto results = std::shared_ptr<Image>{ new Image{} };
+		results->cvMatPtr = new cv::Mat{ buffers[(passes.size() - 1) % 2] };
+		return results;
+	}
+
+	std::shared_ptr<CPUFilter> CPUFilter::Clone() const
+	{
+		return std::shared_ptr<CPUFilter>{ new CPUFilter{ *this } };
+	}
+
+	void CPUFilter::SetInt(const char* location, int data)
+	{
+		uniformValues.Ints[location] = data;
+	}
+
+	void CPUFilter::SetFloat(const char* location, float data)
+	{
+		uniformValues.Floats[location] = data;
+	}
+
+	void CPUFilter::SetVec4(const char* location, const LibCore::Math::Vec4& data)
+	{
+		uniformValues.Vec4s[location] = data;
+	}
+
+	void CPUFilter::SetVec3(const char* location, const LibCore::Math::Vec3& data)
+	{
+		uniformValues.Vec3s[location] = data;
+	}
+
+	void CPUFilter::SetVec2(const char* location, const LibCore::Math::Vec2& data)
+	{
+		uniformValues.Vec2s[location] = data;
+	}
+
+	bool CPUFilter::GetInt(const char* location, int& data) const
+	{
+		auto it = uniformValues.Ints.find(location);
+		if (it == uniformValues.Ints.end())
+			return false;
+		data = it->second;
+		return true;
+	}
+
+	bool CPUFilter::GetFloat(const char* location, float& data) const
+	{
+		auto it = uniformValues.Floats.find(location);
+		if (it == uniformValues.Floats.end())
+			return false;
+		data = it->second;
+		return true;
+	}
+
+	bool CPUFilter::GetVec4(const char* location, LibCore::Math::Vec4& data) const
+	{
+		auto it = uniformValues.Vec4s.find(location);
+		if (it == uniformValues.Vec4s.end())
+			return false;
+		data = it->second;
+		return true;
+	}
+
+	bool CPUFilter::GetVec3(const char* location, LibCore::Math::Vec3& data) const
+	{
+		auto it = uniformValues.Vec3s.find(location);
+		if (it == uniformValues.Vec3s.end())
+			return false;
+		data = it->second;
+		return true;
+	}
+
+	bool CPUFilter::GetVec2(const char* location, LibCore::Math::Vec2& data) const
+	{
+		auto it = uniformValues.Vec2s.find(location);
+		if (it == uniformValues.Vec2s.end())
+			return false;
+		data = it->second;
+		return true;
+	}
+
+	uint64_t CPUFilter::ParameterHash(uint64_t seed) const
+	{
+		return uniformValues.Hash(seed);
+	}
+
+	CPUFilter::CPUFilter()
+	{
+
+	}
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "Image.h"
+#include "LibCore/Vec2.h"
+#include "LibCore/Vec3.h"
+#include "LibCore/Vec4.h"
+#include "LibCore/ThreadPool.h"
+#include "LibCore/EventTrace.h"
+#include "LibCore/FilterParameters.h"
+
+namespace LibCV
+{
+	// CPU counterpart of LibGraphics::TextureFilter for the built-in shaders (DefaultShaders.h, CannyShaders.h,
+	// BlurShaders.h), for machines without a GL context. Shaders are recognised by their source, uniforms keep their names and
+	// source defaults, and every pass is rounded to 8 bits like the GL framebuffers, so the output matches the
+	// GPU within a few levels. Shaders hashing noise with sin() (Noise, Snow Fall, VHS) only match in character,
+	// GPUs evaluate sin() of large arguments with less precision. The pyramids of BlurShaders.h run as one
+	// kernel each, stacked box blurs for the blur, and match in shape rather than to the level; the Canny list
+	// runs through cv::Canny like the compute path on the GPU.
+	class CPUFilter
+	{
+	public:
+		// nullptr if a pass is not a built-in shader
+		static std::shared_ptr<CPUFilter> CreateFromShader(const std::string& fragShader);
+		static std::shared_ptr<CPUFilter> CreateFromShaders(const std::vector<std::string>& fragShaders);
+		static bool Supports(const std::string& fragShader);
+
+		// reads what TextureFilter::Serialize wrote, e.g. the filters of a preset; nullptr like CreateFromShaders
+		static std::shared_ptr<CPUFilter> Deserialize(LibCore::Event::TraceReader& reader);
+
+		// rows are split across the pool, the calling thread helps
+		std::shared_ptr<Image> Apply(const std::shared_ptr<Image>& image, LibCore::Async::ThreadPool& pool) const;
+		std::shared_ptr<CPUFilter> Clone() const;
+
+		void SetInt(const char* location, int data);
+		void SetFloat(const char* location, float data);
+		void SetVec4(const char* location, const LibCore::Math::Vec4& data);
+		void SetVec3(const char* location, const LibCore::Math::Vec3& data);
+		void SetVec2(const char* location, const LibCore::Math::Vec2& data);
+
+		bool GetInt(const char* location, int& data) const;
+		bool GetFloat(const char* location, float& data) const;
+		bool GetVec4(const char* location, LibCore::Math::Vec4& data) const;
+		bool GetVec3(const char* location, LibCore::Math::Vec3& data) const;
+		bool GetVec2(const char* location, LibCore::Math::Vec2& data) const;
+
+		// same value as TextureFilter::ParameterHash for the same uniform values
+		uint64_t ParameterHash(uint64_t seed = 0) const;
+
+		struct Pass;
+
+	private:
+		CPUFilter();
+
+		std::vector<std::shared_ptr<const Pass>> passes;
+
+		// variables
+		LibCore::Utils::FilterParameters uniformValues;
+	};
+}
\ No newline at end of file
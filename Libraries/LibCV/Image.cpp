@@ -3,16 +3,124 @@
 #include "opencv2/highgui.hpp"
 #include "opencv2/imgcodecs.hpp"
 #include "opencv2/imgproc.hpp"
+#include "LibCore/MappedFile.h"
+
+#include <algorithm>
 
 namespace LibCV
 {
-	std::shared_ptr<Image> Image::Create(const LibCore::Filesystem::File& path)
+	static cv::Mat DecodeMat(const uint8_t* data, size_t size, int flags)
+	{
+		if (!data || size == 0)
+			return {};
+
+		// header over the caller's bytes, imdecode reads them in place
+		const cv::Mat encoded{ 1, static_cast<int>(size), CV_8UC1, const_cast<uint8_t*>(data) };
+		return cv::imdecode(encoded, flags);
+	}
+
+	std::shared_ptr<Image> Image::Create(const LibCore::Filesystem::File& path, LibCore::Filesystem::MAP_MODE mode)
+	{
+		// decoded from the mapping, the file is never copied into a buffer of our own unless mode asks for it
+		const auto mapped = path.Map(mode);
+		std::shared_ptr<Image> results = std::shared_ptr<Image>{ new Image{} };
+		results->cvMatPtr = new cv::Mat{ mapped ? DecodeMat(mapped->Data(), mapped->Size(), cv::IMREAD_COLOR) : cv::Mat{} };
+		return results;
+	}
+
+	std::shared_ptr<Image> Image::Decode(const uint8_t* data, size_t size)
+	{
+		std::shared_ptr<Image> results = std::shared_ptr<Image>{ new Image{} };
+		results->cvMatPtr = new cv::Mat{ DecodeMat(data, size, cv::IMREAD_COLOR) };
+		return results;
+	}
+
+	std::shared_ptr<Image> Image::CreateThumbnail(const LibCore::Filesystem::File& path, unsigned maxSize)
 	{
+		const auto mapped = path.Map();
+		if (!mapped)
+		{
+			// unreadable or locked, empty like a failed decode
+			std::shared_ptr<Image> results = std::shared_ptr<Image>{ new Image{} };
+			results->cvMatPtr = new cv::Mat{};
+			return results;
+		}
+
+		// pick the largest reduction that still leaves the longest side at or above maxSize
+		int flags = cv::IMREAD_COLOR;
+		unsigned width = 0, height = 0;
+		if (ReadDimensions(mapped->Data(), mapped->Size(), width, height))
+		{
+			const unsigned longest = std::max(width, height);
+			if (longest >= maxSize * 8)
+				flags = cv::IMREAD_REDUCED_COLOR_8;
+			else if (longest >= maxSize * 4)
+				flags = cv::IMREAD_REDUCED_COLOR_4;
+			else if (longest >= maxSize * 2)
+				flags = cv::IMREAD_REDUCED_COLOR_2;
+		}
+
 		std::shared_ptr<Image> results = std::shared_ptr<Image>{ new Image{} };
-		results->cvMatPtr = new cv::Mat{ cv::imread(path.FilePath().String()) };
+		results->cvMatPtr = new cv::Mat{ DecodeMat(mapped->Data(), mapped->Size(), flags) };
+
+		const unsigned w = results->Width(), h = results->Height();
+		if (w > maxSize || h > maxSize)
+			results = results->Resize(w > h ? ((float)maxSize / w) : ((float)maxSize / h));
 		return results;
 	}
 
+	bool Image::ReadDimensions(const uint8_t* data, size_t size, unsigned& width, unsigned& height)
+	{
+		static const uint8_t PNG_SIGNATURE[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+		auto readBE16 = [data](size_t offset) { return (unsigned(data[offset]) << 8) | data[offset + 1]; };
+		auto readBE32 = [data](size_t offset) { return (unsigned(data[offset]) << 24) | (unsigned(data[offset + 1]) << 16) | (unsigned(data[offset + 2]) << 8) | data[offset + 3]; };
+
+		if (!data)
+			return false;
+
+		// PNG: signature then the IHDR chunk, which must come first
+		if (size >= 24 && std::equal(std::begin(PNG_SIGNATURE), std::end(PNG_SIGNATURE), data))
+		{
+			width = readBE32(16);
+			height = readBE32(20);
+			return true;
+		}
+
+		// JPEG: walk the marker segments up to the first start-of-frame
+		if (size < 4 || data[0] != 0xFF || data[1] != 0xD8)
+			return false;
+
+		size_t offset = 2;
+		while (offset + 4 <= size)
+		{
+			if (data[offset] != 0xFF)
+				return false;
+
+			const uint8_t marker = data[offset + 1];
+			if (marker == 0xFF)
+			{
+				++offset;	// fill byte
+				continue;
+			}
+
+			const size_t length = readBE16(offset + 2);
+			const bool startOfFrame = marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC;
+			if (startOfFrame)
+			{
+				if (offset + 9 > size)
+					return false;
+				height = readBE16(offset + 5);
+				width = readBE16(offset + 7);
+				return true;
+			}
+
+			if (marker == 0xD9 || marker == 0xDA)
+				return false;	// end of image or scan data before any frame header
+			offset += 2 + length;
+		}
+		return false;
+	}
+
 	std::shared_ptr<Image> Image::Create(const std::filesystem::path& path)
 	{
 		return Create(LibCore::Filesystem::File{ path.string().c_str()});
@@ -23,6 +131,20 @@ namespace LibCV
 		return Create(LibCore::Filesystem::File{ path });
 	}
 
+	std::shared_ptr<Image> Image::Create(const ImageData& data)
+	{
+		std::shared_ptr<Image> results = std::shared_ptr<Image>{ new Image{} };
+		if (data.Pixels.size() != static_cast<size_t>(data.ImageWidth) * data.ImageHeight * data.ImageChannels || data.ImageChannels == 0)
+		{
+			results->cvMatPtr = new cv::Mat{};
+			return results;
+		}
+
+		const cv::Mat pixels{ static_cast<int>(data.ImageHeight), static_cast<int>(data.ImageWidth), CV_8UC(data.ImageChannels), const_cast<char*>(data.Pixels.data()) };
+		results->cvMatPtr = new cv::Mat{ pixels.clone() };
+		return results;
+	}
+
 	std::shared_ptr<Image> Image::Clone() const
 	{
 		std::shared_ptr<Image> results = std::shared_ptr<Image>{ new Image{} };
@@ -197,6 +319,11 @@ namespace LibCV
 		return ((cv::Mat*)cvMatPtr)->channels();
 	}
 
+	bool Image::Empty() const
+	{
+		return ((cv::Mat*)cvMatPtr)->empty();
+	}
+
 	LibCore::Math::Vec4 Image::Pixel(unsigned x, unsigned y) const
 	{
 		LibCore::Math::Vec4 results;
@@ -2,6 +2,7 @@
 
 #include <memory>
 #include <vector>
+#include <cstdint>
 #include <filesystem>
 
 #include "LibCore/Vec4.h"
@@ -10,6 +11,7 @@
 namespace LibCV
 {
 	class ImageFX;
+	class CPUFilter;
 	struct ImageData
 	{
 		unsigned ImageWidth, ImageHeight, ImageChannels;
@@ -19,9 +21,21 @@ namespace LibCV
 	class Image
 	{
 	public:
-		static std::shared_ptr<Image> Create(const LibCore::Filesystem::File& path);
+		static std::shared_ptr<Image> Create(const LibCore::Filesystem::File& path, LibCore::Filesystem::MAP_MODE mode = LibCore::Filesystem::MAP_MODE::MAPPED);
 		static std::shared_ptr<Image> Create(const std::filesystem::path& path);
 		static std::shared_ptr<Image> Create(const char* path);
+		// copies tightly packed 8 bit rows, as returned by GetImageData
+		static std::shared_ptr<Image> Create(const ImageData& data);
+
+		// Decodes an encoded image (jpg, png, ...) straight from memory, e.g. a mapped file
+		static std::shared_ptr<Image> Decode(const uint8_t* data, size_t size);
+
+		// Decodes at 1/2, 1/4 or 1/8 scale when the image is large enough (JPEG scales in the DCT,
+		// so the full image is never built) and then resizes so the longest side is at most maxSize
+		static std::shared_ptr<Image> CreateThumbnail(const LibCore::Filesystem::File& path, unsigned maxSize);
+
+		// Reads width and height from a JPEG or PNG header without decoding
+		static bool ReadDimensions(const uint8_t* data, size_t size, unsigned& width, unsigned& height);
 		std::shared_ptr<Image> Clone() const;
 		~Image();
 
@@ -39,6 +53,7 @@ namespace LibCV
 		unsigned Width() const;
 		unsigned Height() const;
 		unsigned Channels() const;
+		bool Empty() const;
 		LibCore::Math::Vec4 Pixel(unsigned x, unsigned y) const;
 
 		ImageData GetImageData() const;
@@ -47,6 +62,7 @@ namespace LibCV
 		Image();
 
 		friend class ImageFX;
+		friend class CPUFilter;
 		void* cvMatPtr;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,486 @@
+#include "AsyncFileIO.h"
+
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <unordered_set>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define LIBCORE_IO_URING 1
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <cerrno>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/eventfd.h>
+#include <linux/io_uring.h>
+#endif
+
+#define IO_THREAD_COUNT 2
+#define MAX_TRANSFER_SIZE (1u << 30)
+#define WAKE_USER_DATA 0
+
+namespace LibCore
+{
+	namespace Filesystem
+	{
+#if defined(LIBCORE_IO_URING)
+		// Minimal io_uring setup over the raw syscalls: one SQ, one CQ, no SQ polling.
+		struct AsyncFileIO::Ring
+		{
+			int RingFd = -1;
+			int WakeFd = -1;
+			unsigned Entries = 0;
+
+			void* SqRing = MAP_FAILED;
+			size_t SqRingSize = 0;
+			void* CqRing = MAP_FAILED;
+			size_t CqRingSize = 0;
+			io_uring_sqe* Sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+			size_t SqesSize = 0;
+
+			unsigned *SqHead = nullptr, *SqTail = nullptr, *SqMask = nullptr, *SqArray = nullptr;
+			unsigned *CqHead = nullptr, *CqTail = nullptr, *CqMask = nullptr;
+			io_uring_cqe* Cqes = nullptr;
+
+			bool Init(unsigned entries)
+			{
+				io_uring_params params;
+				std::memset(&params, 0, sizeof(params));
+				RingFd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+				if (RingFd < 0)
+					return false;
+
+				Entries = params.sq_entries;
+				SqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+				CqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+				if (params.features & IORING_FEAT_SINGLE_MMAP)
+					SqRingSize = CqRingSize = std::max(SqRingSize, CqRingSize);
+
+				SqRing = mmap(nullptr, SqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, RingFd, IORING_OFF_SQ_RING);
+				if (SqRing == MAP_FAILED)
+					return false;
+
+				if (params.features & IORING_FEAT_SINGLE_MMAP)
+					CqRing = SqRing;
+				else if ((CqRing = mmap(nullptr, CqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, RingFd, IORING_OFF_CQ_RING)) == MAP_FAILED)
+					return false;
+
+				SqesSize = params.sq_entries * sizeof(io_uring_sqe);
+				Sqes = static_cast<io_uring_sqe*>(mmap(nullptr, SqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, RingFd, IORING_OFF_SQES));
+				if (Sqes == MAP_FAILED)
+					return false;
+
+				auto* sq = static_cast<uint8_t*>(SqRing);
+				SqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+				SqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+				SqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+				SqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+				auto* cq = static_cast<uint8_t*>(CqRing);
+				CqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+				CqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+				CqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+				Cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+				WakeFd = eventfd(0, EFD_CLOEXEC);
+				return WakeFd >= 0;
+			}
+
+			~Ring()
+			{
+				if (Sqes != MAP_FAILED)
+					munmap(Sqes, SqesSize);
+				if (CqRing != MAP_FAILED && CqRing != SqRing)
+					munmap(CqRing, CqRingSize);
+				if (SqRing != MAP_FAILED)
+					munmap(SqRing, SqRingSize);
+				if (RingFd >= 0)
+					close(RingFd);
+				if (WakeFd >= 0)
+					close(WakeFd);
+			}
+
+			// The caller guarantees a free slot (in-flight requests are capped below Entries)
+			io_uring_sqe* NextSqe()
+			{
+				const unsigned tail = *SqTail;	// only this thread writes the tail
+				const unsigned index = tail & *SqMask;
+				io_uring_sqe* sqe = &Sqes[index];
+				std::memset(sqe, 0, sizeof(*sqe));
+				SqArray[index] = index;
+				return sqe;
+			}
+
+			void Publish()
+			{
+				std::atomic_ref<unsigned>{ *SqTail }.fetch_add(1, std::memory_order_release);
+			}
+
+			bool Enter(unsigned toSubmit, unsigned waitFor)
+			{
+				while (true)
+				{
+					const long result = syscall(__NR_io_uring_enter, RingFd, toSubmit, waitFor, waitFor ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+					if (result >= 0)
+						return true;
+					// nothing was submitted when the call fails, retry the same batch
+					if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+						return false;
+				}
+			}
+
+			template<typename F>
+			void Reap(F&& onCompletion)
+			{
+				std::atomic_ref<unsigned> head{ *CqHead };
+				unsigned current = head.load(std::memory_order_relaxed);
+				const unsigned tail = std::atomic_ref<unsigned>{ *CqTail }.load(std::memory_order_acquire);
+				for (; current != tail; ++current)
+				{
+					const io_uring_cqe cqe = Cqes[current & *CqMask];
+					onCompletion(cqe.user_data, cqe.res);
+				}
+				head.store(current, std::memory_order_release);
+			}
+		};
+#else
+		struct AsyncFileIO::Ring {};
+#endif
+
+		std::shared_ptr<AsyncFileIO> AsyncFileIO::Create(unsigned queueDepth)
+		{
+			auto results = std::shared_ptr<AsyncFileIO>(new AsyncFileIO{});
+
+#if defined(LIBCORE_IO_URING)
+			auto ring = std::make_unique<Ring>();
+			if (ring->Init(std::max(queueDepth, 4U)))
+			{
+				results->ring = std::move(ring);
+				results->ringThread = std::thread{ [fileIO = results.get()]() { fileIO->RingLoop(); } };
+				return results;
+			}
+			std::cout << "io_uring unavailable, using I/O threads" << std::endl;
+#endif
+
+			results->ioThreads = std::make_unique<Async::ThreadPool>(IO_THREAD_COUNT);
+			results->ioThreads->SetName("FileIO");
+			return results;
+		}
+
+		AsyncFileIO::AsyncFileIO()
+			: ring{ nullptr }
+			, ioThreads{ nullptr }
+			, stopped{ false }
+			, pendingRequests{ 0 }
+		{
+
+		}
+
+		AsyncFileIO::~AsyncFileIO()
+		{
+			Shutdown();
+		}
+
+		void AsyncFileIO::Shutdown()
+		{
+			{
+				std::lock_guard<std::mutex> lock{ mutex };
+				stopped = true;
+			}
+
+			if (ringThread.joinable())
+			{
+				WakeRing();
+				ringThread.join();
+			}
+
+			if (ioThreads)
+				ioThreads->Shutdown();
+		}
+
+		void AsyncFileIO::Read(const File& file, ReadCallback onComplete)
+		{
+			auto request = std::unique_ptr<Request>(new Request{ TYPE::READ, std::filesystem::path{ file.FilePath().String() }, {}, 0, -1, std::move(onComplete), nullptr });
+			Submit(std::move(request));
+		}
+
+		void AsyncFileIO::Write(const File& file, IOBuffer&& data, WriteCallback onComplete)
+		{
+			auto request = std::unique_ptr<Request>(new Request{ TYPE::WRITE, std::filesystem::path{ file.FilePath().String() }, std::move(data), 0, -1, nullptr, std::move(onComplete) });
+			Submit(std::move(request));
+		}
+
+		Async::Future<IOBuffer> AsyncFileIO::Read(const File& file)
+		{
+			auto promise = std::make_shared<std::promise<IOBuffer>>();
+			auto future = Async::Future<IOBuffer>{ promise->get_future() };
+			Read(file, [promise](IOBuffer&& data, bool succeeded) {
+				succeeded
+					? promise->set_value(std::move(data))
+					: promise->set_exception(std::make_exception_ptr(std::runtime_error{ "read failed" }));
+			});
+			return future;
+		}
+
+		Async::Future<bool> AsyncFileIO::Write(const File& file, IOBuffer&& data)
+		{
+			auto promise = std::make_shared<std::promise<bool>>();
+			auto future = Async::Future<bool>{ promise->get_future() };
+			Write(file, std::move(data), [promise](bool succeeded) {
+				promise->set_value(succeeded);
+			});
+			return future;
+		}
+
+		bool AsyncFileIO::UsingIoUring() const
+		{
+			return ring != nullptr;
+		}
+
+		size_t AsyncFileIO::PendingRequests() const
+		{
+			return pendingRequests.load(std::memory_order_relaxed);
+		}
+
+		void AsyncFileIO::Submit(std::unique_ptr<Request> request)
+		{
+			std::unique_lock<std::mutex> lock{ mutex };
+			if (stopped)
+			{
+				lock.unlock();
+				Complete(*request, false);
+				return;
+			}
+
+			pendingRequests.fetch_add(1, std::memory_order_relaxed);
+			if (ring)
+			{
+				queued.push_back(std::move(request));
+				lock.unlock();
+				WakeRing();
+				return;
+			}
+
+			// submitted under the lock so Shutdown() cannot stop the pool in between
+			ioThreads->Submit([this, shared = std::shared_ptr<Request>{ std::move(request) }]() {
+				const bool succeeded = Transfer(*shared);
+				pendingRequests.fetch_sub(1, std::memory_order_relaxed);
+				Complete(*shared, succeeded);
+			});
+		}
+
+		void AsyncFileIO::Complete(Request& request, bool succeeded)
+		{
+			try
+			{
+				if (request.Type == TYPE::READ)
+				{
+					if (!succeeded)
+						request.Buffer.Clear();
+					request.OnRead ? request.OnRead(std::move(request.Buffer), succeeded) : void();
+				}
+				else
+				{
+					request.OnWrite ? request.OnWrite(succeeded) : void();
+				}
+			}
+			catch (const std::exception& e)
+			{
+				std::cout << "File I/O callback failed: " << e.what() << std::endl;
+			}
+		}
+
+		bool AsyncFileIO::Transfer(Request& request)
+		{
+			if (request.Type == TYPE::READ)
+			{
+				std::ifstream file{ request.FilePath, std::ios::binary | std::ios::ate };
+				if (!file.is_open())
+					return false;
+
+				request.Buffer.Resize(static_cast<size_t>(file.tellg()));
+				file.seekg(0, std::ios::beg);
+				file.read(reinterpret_cast<char*>(request.Buffer.Data()), static_cast<std::streamsize>(request.Buffer.Size()));
+				return file.good() || file.eof();
+			}
+
+			std::ofstream file{ request.FilePath, std::ios::out | std::ios::binary | std::ios::trunc };
+			if (!file.is_open())
+				return false;
+
+			file.write(reinterpret_cast<const char*>(request.Buffer.Data()), static_cast<std::streamsize>(request.Buffer.Size()));
+			file.close();
+			return !file.fail();
+		}
+
+		void AsyncFileIO::WakeRing()
+		{
+#if defined(LIBCORE_IO_URING)
+			const uint64_t value = 1;
+			if (write(ring->WakeFd, &value, sizeof(value)) < 0)
+				std::cerr << "Failed to wake the I/O ring" << std::endl;
+#endif
+		}
+
+		bool AsyncFileIO::OpenRequest(Request& request)
+		{
+#if defined(LIBCORE_IO_URING)
+			// opening stays synchronous, the transfers are what the ring batches
+			if (request.Type == TYPE::READ)
+			{
+				request.Handle = open(request.FilePath.c_str(), O_RDONLY | O_CLOEXEC);
+				struct stat fileStat;
+				if (request.Handle < 0 || fstat(request.Handle, &fileStat) != 0)
+					return false;
+				request.Buffer.Resize(static_cast<size_t>(fileStat.st_size));
+			}
+			else
+			{
+				request.Handle = open(request.FilePath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+				if (request.Handle < 0)
+					return false;
+			}
+			return true;
+#else
+			return false;
+#endif
+		}
+
+		void AsyncFileIO::QueueTransfer(Request& request)
+		{
+#if defined(LIBCORE_IO_URING)
+			io_uring_sqe* sqe = ring->NextSqe();
+			sqe->opcode = request.Type == TYPE::READ ? IORING_OP_READ : IORING_OP_WRITE;
+			sqe->fd = request.Handle;
+			sqe->addr = reinterpret_cast<uint64_t>(request.Buffer.Data() + request.Transferred);
+			sqe->len = static_cast<uint32_t>(std::min<size_t>(request.Buffer.Size() - request.Transferred, MAX_TRANSFER_SIZE));
+			sqe->off = request.Transferred;
+			sqe->user_data = reinterpret_cast<uint64_t>(&request);
+			ring->Publish();
+#endif
+		}
+
+		void AsyncFileIO::RingLoop()
+		{
+#if defined(LIBCORE_IO_URING)
+			// one slot is kept for the wake-up poll, so the submission queue can never overflow
+			const unsigned maxInFlight = ring->Entries - 1;
+			unsigned inFlight = 0, toSubmit = 0;
+			bool wakeArmed = false;
+			std::vector<std::unique_ptr<Request>> incoming;
+			std::unordered_set<Request*> submitted;		// owned by the ring until their last transfer completes
+
+			auto finish = [this, &submitted](Request* request, bool succeeded) {
+				submitted.erase(request);
+				if (request->Handle >= 0)
+				{
+					succeeded = close(request->Handle) == 0 && succeeded;
+					request->Handle = -1;
+				}
+				const std::unique_ptr<Request> owned{ request };
+				pendingRequests.fetch_sub(1, std::memory_order_relaxed);
+				Complete(*owned, succeeded);
+			};
+
+			while (true)
+			{
+				if (!wakeArmed)
+				{
+					io_uring_sqe* sqe = ring->NextSqe();
+					sqe->opcode = IORING_OP_POLL_ADD;
+					sqe->fd = ring->WakeFd;
+					sqe->poll_events = POLLIN;
+					sqe->user_data = WAKE_USER_DATA;
+					ring->Publish();
+					wakeArmed = true;
+					++toSubmit;
+				}
+
+				{
+					std::lock_guard<std::mutex> lock{ mutex };
+					const size_t count = std::min<size_t>(queued.size(), maxInFlight - inFlight);
+					std::move(queued.begin(), queued.begin() + count, std::back_inserter(incoming));
+					queued.erase(queued.begin(), queued.begin() + count);
+					if (stopped && queued.empty() && incoming.empty() && inFlight == 0)
+						break;
+				}
+
+				// the whole batch goes to the kernel in the single Enter below
+				for (auto& request : incoming)
+				{
+					Request* raw = request.release();
+					if (!OpenRequest(*raw))
+						finish(raw, false);
+					else if (raw->Buffer.Empty())
+						finish(raw, true);
+					else
+					{
+						submitted.insert(raw);
+						QueueTransfer(*raw);
+						++inFlight;
+						++toSubmit;
+					}
+				}
+				incoming.clear();
+
+				if (!ring->Enter(toSubmit, 1))
+				{
+					std::cerr << "io_uring_enter failed: " << std::strerror(errno) << std::endl;
+					break;
+				}
+				toSubmit = 0;
+
+				ring->Reap([&](uint64_t userData, int result) {
+					if (userData == WAKE_USER_DATA)
+					{
+						uint64_t value;
+						if (read(ring->WakeFd, &value, sizeof(value)) < 0 && errno != EAGAIN)
+							std::cerr << "Failed to drain the I/O ring wake-up" << std::endl;
+						wakeArmed = false;
+						return;
+					}
+
+					auto* request = reinterpret_cast<Request*>(userData);
+					--inFlight;
+					if (result == -EINTR || result == -EAGAIN)
+						result = 0;		// retried below from the same offset
+					else if (result <= 0)
+					{
+						// errors, a file that shrank while being read, or a write that made no progress
+						finish(request, false);
+						return;
+					}
+
+					request->Transferred += static_cast<size_t>(result);
+					if (request->Transferred < request->Buffer.Size())
+					{
+						QueueTransfer(*request);
+						++inFlight;
+						++toSubmit;
+					}
+					else
+					{
+						finish(request, true);
+					}
+				});
+			}
+
+			// only reached early if the ring itself failed, fail whatever is left, submitted or not
+			std::vector<std::unique_ptr<Request>> remaining;
+			{
+				std::lock_guard<std::mutex> lock{ mutex };
+				stopped = true;
+				std::swap(remaining, queued);
+			}
+			for (auto& request : remaining)
+				finish(request.release(), false);
+			for (auto* request : std::vector<Request*>{ submitted.begin(), submitted.end() })
+				finish(request, false);
+#endif
+		}
+	}
+}
\ No newline at end of file
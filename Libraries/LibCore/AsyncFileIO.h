@@ -0,0 +1,108 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <coroutine>
+#include <filesystem>
+
+#include "File.h"
+#include "Future.h"
+#include "IOBuffer.h"
+#include "ThreadPool.h"
+
+namespace LibCore
+{
+	namespace Filesystem
+	{
+		// Whole-file reads and writes completed off the calling thread. On Linux requests are batched
+		// into an io_uring owned by one service thread, elsewhere (or when io_uring is unavailable)
+		// a couple of I/O threads do blocking transfers. Callbacks run on the service / I/O thread.
+		class AsyncFileIO
+		{
+		public:
+			using ReadCallback = std::function<void(IOBuffer&& data, bool succeeded)>;
+			using WriteCallback = std::function<void(bool succeeded)>;
+
+			static std::shared_ptr<AsyncFileIO> Create(unsigned queueDepth = 64);
+			~AsyncFileIO();
+
+			void Read(const File& file, ReadCallback onComplete);
+			void Write(const File& file, IOBuffer&& data, WriteCallback onComplete);
+
+			Async::Future<IOBuffer> Read(const File& file);
+			Async::Future<bool> Write(const File& file, IOBuffer&& data);
+
+			// co_await WriteAsync(...) suspends the coroutine until the data is written and resumes it on resumeOn
+			auto WriteAsync(const File& file, IOBuffer&& data, Async::Executor& resumeOn)
+			{
+				struct Awaiter
+				{
+					AsyncFileIO& fileIO;
+					File file;
+					IOBuffer data;
+					Async::Executor& resumeOn;
+					bool succeeded;
+
+					bool await_ready() const { return false; }
+					void await_suspend(std::coroutine_handle<> handle)
+					{
+						// nothing may touch the awaiter after Write(), the coroutine can resume before it returns
+						fileIO.Write(file, std::move(data), [this, handle](bool result) {
+							succeeded = result;
+							resumeOn.Submit([handle]() { handle.resume(); });
+						});
+					}
+					bool await_resume() const { return succeeded; }
+				};
+				return Awaiter{ *this, file, std::move(data), resumeOn, false };
+			}
+
+			// Completes every queued request, later requests fail immediately
+			void Shutdown();
+
+			bool UsingIoUring() const;
+			size_t PendingRequests() const;
+
+		private:
+			enum class TYPE { READ, WRITE };
+			struct Request
+			{
+				TYPE Type;
+				std::filesystem::path FilePath;
+				IOBuffer Buffer;
+				size_t Transferred;
+				int Handle;
+				ReadCallback OnRead;
+				WriteCallback OnWrite;
+			};
+			struct Ring;
+
+			AsyncFileIO();
+			AsyncFileIO(const AsyncFileIO&) = delete;
+			AsyncFileIO& operator=(const AsyncFileIO&) = delete;
+
+			void Submit(std::unique_ptr<Request> request);
+			static void Complete(Request& request, bool succeeded);
+			static bool Transfer(Request& request);
+
+			// io_uring backend
+			void RingLoop();
+			bool OpenRequest(Request& request);
+			void QueueTransfer(Request& request);
+			void WakeRing();
+
+			std::unique_ptr<Ring> ring;
+			std::thread ringThread;
+			std::unique_ptr<Async::ThreadPool> ioThreads;
+
+			std::mutex mutex;
+			std::vector<std::unique_ptr<Request>> queued;
+			bool stopped;
+			std::atomic<size_t> pendingRequests;
+		};
+	}
+}
\ No newline at end of file
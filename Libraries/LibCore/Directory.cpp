@@ -1,7 +1,12 @@
 #include "Directory.h"
-#include <shobjidl.h>   // For IFileDialog
 #include "StringUtils.h"
 
+#include <stdexcept>
+
+#if defined(_WIN32)
+#include <shobjidl.h>   // For IFileDialog
+#endif
+
 namespace LibCore 
 {
 	namespace Filesystem
@@ -29,14 +34,28 @@ namespace LibCore
 			return std::filesystem::exists(path);
 		}
 
+		template<typename Iterator, typename F>
+		static void ForEachEntry(const std::filesystem::path& path, F&& func)
+		{
+			std::error_code ec;
+			for (Iterator it{ path, std::filesystem::directory_options::skip_permission_denied, ec }; !ec && it != Iterator{}; it.increment(ec))
+				func(*it);
+		}
+
 		std::vector<File> Directory::ListFiles(bool recursive) const
 		{
+			// the entry caches the file type from the directory read, no extra stat per file
 			std::vector<File> files;
-			for (auto& p : ListPaths(recursive))
-			{
-				if (p.IsFile())
-					files.emplace_back(File{ p.String().c_str() });
-			}
+			auto addFile = [&files](const std::filesystem::directory_entry& entry) {
+				std::error_code ec;
+				if (entry.is_regular_file(ec))
+					files.emplace_back(File{ entry.path().string().c_str() });
+			};
+
+			if (recursive)
+				ForEachEntry<std::filesystem::recursive_directory_iterator>(path, addFile);
+			else
+				ForEachEntry<std::filesystem::directory_iterator>(path, addFile);
 			return files;
 		}
 		
@@ -66,11 +85,16 @@ namespace LibCore
 		std::vector<Directory> Directory::ListDirectories(bool recursive) const
 		{
 			std::vector<Directory> directories;
-			for (auto& p : ListPaths(recursive))
-			{
-				if (p.IsDirectory())
-					directories.emplace_back(Directory{ p.String().c_str() });
-			}
+			auto addDirectory = [&directories](const std::filesystem::directory_entry& entry) {
+				std::error_code ec;
+				if (entry.is_directory(ec))
+					directories.emplace_back(Directory{ entry.path().string().c_str() });
+			};
+
+			if (recursive)
+				ForEachEntry<std::filesystem::recursive_directory_iterator>(path, addDirectory);
+			else
+				ForEachEntry<std::filesystem::directory_iterator>(path, addDirectory);
 			return directories;
 		}
 
@@ -98,6 +122,7 @@ namespace LibCore
 
 		Directory Directory::OpenDirectoryDialog()
 		{
+#if defined(_WIN32)
 			IFileDialog* pFileDialog = nullptr;
 			std::wstring folderPath;
 
@@ -138,10 +163,13 @@ namespace LibCore
 
 			if (folderPath.empty())
 			{
-				throw std::exception{ "User cancelled" };
+				throw std::runtime_error{ "User cancelled" };
 			}
 
 			return Directory{ Utils::String::WStringToString(folderPath).c_str() };
+#else
+			throw std::runtime_error{ "No directory dialog on this platform" };
+#endif
 		}
 	}
 }
\ No newline at end of file
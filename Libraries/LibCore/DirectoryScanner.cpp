@@ -0,0 +1,169 @@
+#include "DirectoryScanner.h"
+
+#include <cctype>
+#include <iostream>
+
+namespace LibCore
+{
+	namespace Filesystem
+	{
+		std::shared_ptr<DirectoryScanner> DirectoryScanner::Start(
+			const std::vector<Path>& roots,
+			const Options& options,
+			Async::ThreadPool& threadPool)
+		{
+			auto results = std::shared_ptr<DirectoryScanner>(new DirectoryScanner{ options, threadPool });
+
+			// keeps the scan from finishing while roots are still being queued
+			results->pendingDirectories = 1;
+
+			std::vector<ScanEntry> files;
+			for (auto& root : roots)
+			{
+				std::error_code ec;
+				const std::filesystem::directory_entry entry{ std::filesystem::path{ root.String() }, ec };
+				if (ec)
+					continue;
+
+				std::string extension;
+				if (entry.is_directory(ec))
+					results->QueueDirectory(entry.path());
+				else if (entry.is_regular_file(ec) && results->Accept(entry.path(), extension))
+					files.push_back(ScanEntry{ File{ entry.path().string().c_str() }, std::move(extension), entry.file_size(ec) });
+			}
+
+			results->Publish(std::move(files));
+			results->DirectoryDone();
+			return results;
+		}
+
+		std::vector<ScanEntry> DirectoryScanner::Scan(const Path& root, const Options& options, Async::ThreadPool& threadPool)
+		{
+			auto scanner = Start({ root }, options, threadPool);
+			scanner->Wait();
+			return scanner->TakeResults();
+		}
+
+		DirectoryScanner::DirectoryScanner(const Options& options, Async::ThreadPool& threadPool)
+			: options{ options }
+			, threadPool{ threadPool }
+			, pendingDirectories{ 0 }
+			, scannedDirectories{ 0 }
+			, foundFiles{ 0 }
+			, cancelled{ false }
+		{
+
+		}
+
+		void DirectoryScanner::QueueDirectory(const std::filesystem::path& directory)
+		{
+			pendingDirectories.fetch_add(1, std::memory_order_relaxed);
+			threadPool.Submit([self = shared_from_this(), directory]() {
+				self->ScanDirectory(directory);
+			});
+		}
+
+		void DirectoryScanner::ScanDirectory(const std::filesystem::path& directory)
+		{
+			if (!cancelled)
+			{
+				std::vector<ScanEntry> files;
+				std::error_code ec;
+				std::filesystem::directory_iterator it{ directory, std::filesystem::directory_options::skip_permission_denied, ec };
+				for (; !ec && it != std::filesystem::directory_iterator{}; it.increment(ec))
+				{
+					const auto& entry = *it;
+					std::error_code entryEc;
+
+					// is_directory / is_regular_file use the type cached by the iterator
+					if (entry.is_directory(entryEc))
+					{
+						if (options.Recursive && !entry.is_symlink(entryEc))
+							QueueDirectory(entry.path());
+						continue;
+					}
+
+					std::string extension;
+					if (!entry.is_regular_file(entryEc) || !Accept(entry.path(), extension))
+						continue;
+
+					files.push_back(ScanEntry{ File{ entry.path().string().c_str() }, std::move(extension), entry.file_size(entryEc) });
+					if (cancelled)
+						break;
+				}
+
+				if (ec)
+					std::cout << "Failed to scan " << directory.string() << ": " << ec.message() << std::endl;
+
+				scannedDirectories.fetch_add(1, std::memory_order_relaxed);
+				Publish(std::move(files));
+			}
+			DirectoryDone();
+		}
+
+		bool DirectoryScanner::Accept(const std::filesystem::path& filePath, std::string& extension) const
+		{
+			// only the extension is converted, rejected entries never build a full path string
+			extension = filePath.extension().string();
+			for (auto& c : extension)
+				c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+			return options.Extensions.empty() || options.Extensions.count(extension) != 0;
+		}
+
+		void DirectoryScanner::Publish(std::vector<ScanEntry>&& entries)
+		{
+			if (entries.empty())
+				return;
+
+			foundFiles.fetch_add(entries.size(), std::memory_order_relaxed);
+			std::lock_guard<std::mutex> lock{ mutex };
+			if (results.empty())
+				results = std::move(entries);
+			else
+				results.insert(results.end(), std::make_move_iterator(entries.begin()), std::make_move_iterator(entries.end()));
+		}
+
+		void DirectoryScanner::DirectoryDone()
+		{
+			if (pendingDirectories.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				std::lock_guard<std::mutex> lock{ mutex };
+				finishedCond.notify_all();
+			}
+		}
+
+		std::vector<ScanEntry> DirectoryScanner::TakeResults()
+		{
+			std::vector<ScanEntry> entries;
+			std::lock_guard<std::mutex> lock{ mutex };
+			std::swap(entries, results);
+			return entries;
+		}
+
+		bool DirectoryScanner::Finished() const
+		{
+			return pendingDirectories.load(std::memory_order_acquire) == 0;
+		}
+
+		void DirectoryScanner::Wait()
+		{
+			std::unique_lock<std::mutex> lock{ mutex };
+			finishedCond.wait(lock, [this] { return Finished(); });
+		}
+
+		void DirectoryScanner::Cancel()
+		{
+			cancelled = true;
+		}
+
+		size_t DirectoryScanner::ScannedDirectories() const
+		{
+			return scannedDirectories.load(std::memory_order_relaxed);
+		}
+
+		size_t DirectoryScanner::FoundFiles() const
+		{
+			return foundFiles.load(std::memory_order_relaxed);
+		}
+	}
+}
\ No newline at end of file
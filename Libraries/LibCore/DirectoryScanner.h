@@ -0,0 +1,83 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <filesystem>
+#include <unordered_set>
+#include <condition_variable>
+
+#include "File.h"
+#include "Path.h"
+#include "ThreadPool.h"
+
+namespace LibCore
+{
+	namespace Filesystem
+	{
+		struct ScanEntry
+		{
+			File EntryFile;
+			std::string Extension;	// lower case, with the dot
+			uint64_t Size;
+		};
+
+		// Walks directories on a thread pool, one task per directory, so sibling subdirectories are read
+		// in parallel. File type comes from the directory entry itself (d_type / find data) instead of a
+		// stat per entry, and entries are filtered by extension before anything is converted to strings.
+		// Results stream out through TakeResults() while the scan is still running.
+		class DirectoryScanner : public std::enable_shared_from_this<DirectoryScanner>
+		{
+		public:
+			struct Options
+			{
+				bool Recursive = false;
+				std::unordered_set<std::string> Extensions;	// lower case with the dot, empty accepts everything
+			};
+
+			// roots may mix directories and files, files are filtered and reported directly
+			static std::shared_ptr<DirectoryScanner> Start(
+				const std::vector<Path>& roots,
+				const Options& options,
+				Async::ThreadPool& threadPool);
+
+			// Blocking helper for callers that want the whole list
+			static std::vector<ScanEntry> Scan(const Path& root, const Options& options, Async::ThreadPool& threadPool);
+
+			// Entries found since the previous call, safe from any thread
+			std::vector<ScanEntry> TakeResults();
+			bool Finished() const;
+			void Wait();
+			void Cancel();
+
+			size_t ScannedDirectories() const;
+			size_t FoundFiles() const;
+
+		private:
+			DirectoryScanner(const Options& options, Async::ThreadPool& threadPool);
+			DirectoryScanner(const DirectoryScanner&) = delete;
+			DirectoryScanner& operator=(const DirectoryScanner&) = delete;
+
+			void ScanDirectory(const std::filesystem::path& directory);
+			void QueueDirectory(const std::filesystem::path& directory);
+			bool Accept(const std::filesystem::path& filePath, std::string& extension) const;
+			void Publish(std::vector<ScanEntry>&& entries);
+			void DirectoryDone();
+
+			Options options;
+			Async::ThreadPool& threadPool;
+
+			mutable std::mutex mutex;
+			std::condition_variable finishedCond;
+			std::vector<ScanEntry> results;
+
+			std::atomic<size_t> pendingDirectories;
+			std::atomic<size_t> scannedDirectories;
+			std::atomic<size_t> foundFiles;
+			std::atomic<bool> cancelled;
+		};
+	}
+}
\ No newline at end of file
@@ -0,0 +1,277 @@
+#include "DirectoryWatcher.h"
+
+#include <chrono>
+#include <cctype>
+#include <iostream>
+#include <algorithm>
+
+#if defined(__linux__)
+#include <poll.h>
+#include <unistd.h>
+#include <sys/vfs.h>
+#include <sys/inotify.h>
+#endif
+
+#define WATCH_TICK_MS 100
+
+// statfs f_type of the network filesystems inotify cannot see remote writes on
+#define WATCH_NFS_MAGIC 0x6969
+#define WATCH_SMB_MAGIC 0x517B
+#define WATCH_CIFS_MAGIC 0xFF534D42
+#define WATCH_SMB2_MAGIC 0xFE534D42
+
+namespace LibCore
+{
+	namespace Filesystem
+	{
+		uint64_t DirectoryWatcher::NowMicros()
+		{
+			return std::chrono::duration_cast<std::chrono::microseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+		std::shared_ptr<DirectoryWatcher> DirectoryWatcher::Create(const Directory& directory, const Options& options)
+		{
+			if (!directory.Exists())
+			{
+				std::cerr << "Cannot watch missing directory " << directory.String() << std::endl;
+				return nullptr;
+			}
+
+			auto results = std::shared_ptr<DirectoryWatcher>(new DirectoryWatcher{ directory, options });
+			const bool notifications = results->InitNotifications();
+			results->watcher = std::thread{ [watcher = results.get(), notifications]() { watcher->WatchLoop(notifications); } };
+			return results;
+		}
+
+		DirectoryWatcher::DirectoryWatcher(const Directory& directory, const Options& options)
+			: directory{ directory.String() }
+			, options{ options }
+			, notifyHandle{ -1 }
+			, watchHandle{ -1 }
+			, stopFlag{ false }
+		{
+
+		}
+
+		DirectoryWatcher::~DirectoryWatcher()
+		{
+			Stop();
+		}
+
+		void DirectoryWatcher::Stop()
+		{
+			stopFlag = true;
+			if (watcher.joinable())
+				watcher.join();
+
+#if defined(__linux__)
+			if (notifyHandle >= 0)
+			{
+				close(notifyHandle);
+				notifyHandle = -1;
+			}
+#endif
+		}
+
+		std::vector<DirectoryWatcher::ReadyFile> DirectoryWatcher::TakeReadyFiles()
+		{
+			std::vector<ReadyFile> results;
+			std::lock_guard<std::mutex> lock{ mutex };
+			std::swap(results, readyFiles);
+			return results;
+		}
+
+		bool DirectoryWatcher::UsingNotifications() const
+		{
+			return notifyHandle >= 0;
+		}
+
+		void DirectoryWatcher::WatchLoop(bool notifications)
+		{
+			// files already there are either reported (as if just written) or remembered as seen
+			std::error_code ec;
+			for (std::filesystem::directory_iterator it{ directory, ec }; !ec && it != std::filesystem::directory_iterator{}; it.increment(ec))
+			{
+				std::error_code entryEc;
+				if (!it->is_regular_file(entryEc) || !Accept(it->path()))
+					continue;
+
+				if (options.ReportExisting)
+					MarkCandidate(it->path());
+				else
+					reported[it->path().string()] = it->last_write_time(entryEc);
+			}
+
+			uint64_t lastPollMicros = NowMicros();
+			while (!stopFlag)
+			{
+				bool rescan = false;
+				if (notifications)
+				{
+					rescan = !ReadNotifications(WATCH_TICK_MS) || NowMicros() - lastPollMicros >= options.RescanIntervalMs * 1000ull;
+				}
+				else
+				{
+					std::this_thread::sleep_for(std::chrono::milliseconds{ WATCH_TICK_MS });
+					rescan = NowMicros() - lastPollMicros >= options.PollIntervalMs * 1000ull;
+				}
+
+				if (rescan)
+				{
+					PollDirectory();
+					lastPollMicros = NowMicros();
+				}
+
+				CheckCandidates();
+			}
+		}
+
+		bool DirectoryWatcher::InitNotifications()
+		{
+#if defined(__linux__)
+			struct statfs info{};
+			if (statfs(directory.c_str(), &info) == 0)
+			{
+				const auto type = static_cast<unsigned long>(info.f_type);
+				if (type == WATCH_NFS_MAGIC || type == WATCH_SMB_MAGIC || type == WATCH_CIFS_MAGIC || type == WATCH_SMB2_MAGIC)
+					return false;
+			}
+
+			notifyHandle = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+			if (notifyHandle < 0)
+				return false;
+
+			watchHandle = inotify_add_watch(notifyHandle, directory.c_str(), IN_CREATE | IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_TO);
+			if (watchHandle < 0)
+			{
+				// e.g. watch limit reached, or a filesystem without inotify support
+				close(notifyHandle);
+				notifyHandle = -1;
+				return false;
+			}
+			return true;
+#else
+			return false;
+#endif
+		}
+
+		bool DirectoryWatcher::ReadNotifications(unsigned timeoutMs)
+		{
+			bool complete = true;
+#if defined(__linux__)
+			pollfd pfd{ notifyHandle, POLLIN, 0 };
+			if (poll(&pfd, 1, static_cast<int>(timeoutMs)) <= 0)
+				return complete;
+
+			alignas(inotify_event) char buffer[16 * 1024];
+			ssize_t length = 0;
+			while ((length = read(notifyHandle, buffer, sizeof(buffer))) > 0)
+			{
+				for (char* ptr = buffer; ptr < buffer + length;)
+				{
+					const auto* evt = reinterpret_cast<const inotify_event*>(ptr);
+					if (evt->mask & IN_Q_OVERFLOW)
+						complete = false;
+					else if (evt->len > 0 && !(evt->mask & IN_ISDIR))
+						MarkCandidate(directory / evt->name);
+					ptr += sizeof(inotify_event) + evt->len;
+				}
+			}
+#endif
+			return complete;
+		}
+
+		void DirectoryWatcher::PollDirectory()
+		{
+			std::error_code ec;
+			for (std::filesystem::directory_iterator it{ directory, ec }; !ec && it != std::filesystem::directory_iterator{}; it.increment(ec))
+			{
+				std::error_code entryEc;
+				if (!it->is_regular_file(entryEc) || !Accept(it->path()))
+					continue;
+
+				// pending files are re-checked by CheckCandidates, marking them again would restart the settle time
+				const auto key = it->path().string();
+				if (candidates.count(key))
+					continue;
+
+				auto found = reported.find(key);
+				if (found == reported.end() || found->second != it->last_write_time(entryEc))
+					MarkCandidate(it->path());
+			}
+		}
+
+		void DirectoryWatcher::MarkCandidate(const std::filesystem::path& path)
+		{
+			if (!Accept(path))
+				return;
+
+			const uint64_t now = NowMicros();
+			auto key = path.string();
+			auto it = candidates.find(key);
+			if (it == candidates.end())
+				candidates.emplace(std::move(key), Candidate{ ~0ull, {}, now, now });
+			else
+				it->second.LastChangeMicros = now;
+		}
+
+		void DirectoryWatcher::CheckCandidates()
+		{
+			const uint64_t now = NowMicros();
+			std::vector<ReadyFile> ready;
+
+			for (auto it = candidates.begin(); it != candidates.end();)
+			{
+				std::error_code ec;
+				const std::filesystem::path path{ it->first };
+				const uint64_t size = std::filesystem::file_size(path, ec);
+				const auto lastWrite = ec ? std::filesystem::file_time_type{} : std::filesystem::last_write_time(path, ec);
+				if (ec)
+				{
+					// deleted or renamed away before it settled
+					it = candidates.erase(it);
+					continue;
+				}
+
+				auto& candidate = it->second;
+				if (size != candidate.Size || lastWrite != candidate.LastWrite)
+				{
+					candidate.Size = size;
+					candidate.LastWrite = lastWrite;
+					candidate.LastChangeMicros = now;
+				}
+
+				if (size > 0 && now - candidate.LastChangeMicros >= options.SettleMs * 1000ull)
+				{
+					auto found = reported.find(it->first);
+					if (found == reported.end() || found->second != lastWrite)
+					{
+						reported[it->first] = lastWrite;
+						ready.push_back(ReadyFile{ File{ it->first.c_str() }, size, candidate.DetectedMicros, now });
+					}
+					it = candidates.erase(it);
+					continue;
+				}
+				++it;
+			}
+
+			if (!ready.empty())
+			{
+				std::lock_guard<std::mutex> lock{ mutex };
+				readyFiles.insert(readyFiles.end(), std::make_move_iterator(ready.begin()), std::make_move_iterator(ready.end()));
+			}
+		}
+
+		bool DirectoryWatcher::Accept(const std::filesystem::path& path) const
+		{
+			if (options.Extensions.empty())
+				return true;
+
+			auto extension = path.extension().string();
+			for (auto& c : extension)
+				c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+			return options.Extensions.count(extension) != 0;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <cstdint>
+#include <filesystem>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "File.h"
+#include "Directory.h"
+
+namespace LibCore
+{
+	namespace Filesystem
+	{
+		// Reports files that appear (or change) in a directory once they have stopped growing.
+		// Uses inotify on Linux and falls back to periodic polling elsewhere, if inotify fails, or on network shares
+		// (NFS, CIFS/SMB) where writes from other machines raise no events. With inotify the directory is still
+		// rescanned now and then, and at once when the kernel reports its event queue overflowed. Not recursive.
+		class DirectoryWatcher
+		{
+		public:
+			struct Options
+			{
+				unsigned PollIntervalMs = 1000;		// polling backend only
+				unsigned RescanIntervalMs = 10000;	// inotify backend, catches whatever raised no event
+				unsigned SettleMs = 750;			// size and mtime must be unchanged this long
+				bool ReportExisting = false;		// report files already present when watching starts
+				std::unordered_set<std::string> Extensions;	// lower case with the dot, empty accepts everything
+			};
+
+			struct ReadyFile
+			{
+				File WatchedFile;
+				uint64_t Size;
+				uint64_t DetectedMicros;	// steady clock, when the file was first seen
+				uint64_t ReadyMicros;		// steady clock, when it was considered complete
+			};
+
+			static std::shared_ptr<DirectoryWatcher> Create(const Directory& directory, const Options& options);
+			~DirectoryWatcher();
+
+			void Stop();
+			std::vector<ReadyFile> TakeReadyFiles();
+			bool UsingNotifications() const;
+
+			static uint64_t NowMicros();
+
+		private:
+			DirectoryWatcher(const Directory& directory, const Options& options);
+			DirectoryWatcher(const DirectoryWatcher&) = delete;
+			DirectoryWatcher& operator=(const DirectoryWatcher&) = delete;
+
+			struct Candidate
+			{
+				uint64_t Size;
+				std::filesystem::file_time_type LastWrite;
+				uint64_t DetectedMicros;
+				uint64_t LastChangeMicros;
+			};
+
+			void WatchLoop(bool notifications);
+			bool InitNotifications();
+			// false if events were lost and the directory needs a rescan
+			bool ReadNotifications(unsigned timeoutMs);
+			void PollDirectory();
+			void MarkCandidate(const std::filesystem::path& path);
+			void CheckCandidates();
+			bool Accept(const std::filesystem::path& path) const;
+
+			std::filesystem::path directory;
+			Options options;
+
+			// watcher thread only
+			std::unordered_map<std::string, Candidate> candidates;
+			std::unordered_map<std::string, std::filesystem::file_time_type> reported;
+			int notifyHandle;
+			int watchHandle;
+
+			std::mutex mutex;
+			std::vector<ReadyFile> readyFiles;
+			std::atomic<bool> stopFlag;
+			std::thread watcher;
+		};
+	}
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+#include "EventQueue.h"
+
+#include <bit>
+#include <algorithm>
+
+namespace LibCore
+{
+	namespace Event
+	{
+		EventQueue::EventQueue(size_t capacity)
+			: slots{ nullptr }
+			, mask{ std::bit_ceil(std::max<size_t>(capacity, 2)) - 1 }
+			, enqueuePos{ 0 }
+			, dequeuePos{ 0 }
+		{
+			slots = std::make_unique<Slot[]>(mask + 1);
+			for (size_t i = 0; i <= mask; ++i)
+				slots[i].Sequence.store(i, std::memory_order_relaxed);
+		}
+
+		EventQueue::~EventQueue()
+		{
+			while (TryPop([](const EventVTable&, const Event&, size_t) {}));
+		}
+
+		size_t EventQueue::Capacity() const
+		{
+			return mask + 1;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <typeindex>
+#include <type_traits>
+
+namespace LibCore
+{
+	namespace Event
+	{
+		struct Event;
+
+		inline size_t NextEventTypeId()
+		{
+			static std::atomic<size_t> nextId{ 0 };
+			return nextId.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		// Small dense id per event type, assigned on first use, for indexing flat tables
+		template<typename T>
+		size_t EventTypeId()
+		{
+			static const size_t id = NextEventTypeId();
+			return id;
+		}
+
+		// Per-type operations for an event stored inline in a queue slot
+		struct EventVTable
+		{
+			size_t TypeId;
+			std::type_index Type;
+			const Event& (*AsEvent)(const void* storage);
+			void (*Destroy)(void* storage);
+
+			template<typename T>
+			static const EventVTable* Of()
+			{
+				static const EventVTable vtable{
+					EventTypeId<T>(),
+					std::type_index{ typeid(T) },
+					[](const void* storage) -> const Event& { return *static_cast<const T*>(storage); },
+					[](void* storage) { static_cast<T*>(storage)->~T(); }
+				};
+				return &vtable;
+			}
+		};
+
+		// Bounded multi-producer single-consumer ring buffer. Events are constructed in place in
+		// fixed-size slots allocated up front, so pushing never allocates or locks; producers only
+		// race on a CAS of the enqueue position. Pop must always be called from the same thread.
+		class EventQueue
+		{
+		public:
+			static const size_t SLOT_SIZE = 128;
+
+			explicit EventQueue(size_t capacity);
+			~EventQueue();
+
+			// Returns false when the queue is full, the event is not stored in that case.
+			// position receives the event's place in the overall push order.
+			template<typename T>
+			bool TryPush(T&& event, size_t* position = nullptr)
+			{
+				using EventType = std::decay_t<T>;
+				static_assert(sizeof(EventType) <= SLOT_SIZE, "Event type too large for EventQueue::SLOT_SIZE");
+				static_assert(alignof(EventType) <= alignof(std::max_align_t), "Event type over-aligned for EventQueue");
+
+				Slot* slot = nullptr;
+				size_t pos = enqueuePos.load(std::memory_order_relaxed);
+				while (true)
+				{
+					slot = &slots[pos & mask];
+					const size_t sequence = slot->Sequence.load(std::memory_order_acquire);
+					const auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+					if (diff == 0)
+					{
+						if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+							break;
+					}
+					else if (diff < 0)
+					{
+						return false;
+					}
+					else
+					{
+						pos = enqueuePos.load(std::memory_order_relaxed);
+					}
+				}
+
+				new (slot->Storage) EventType(std::forward<T>(event));
+				slot->VTable = EventVTable::Of<EventType>();
+				slot->Sequence.store(pos + 1, std::memory_order_release);
+				if (position)
+					*position = pos;
+				return true;
+			}
+
+			// Calls visit(const EventVTable&, const Event&, size_t position) on the oldest event and destroys it.
+			// Returns false when the queue is empty.
+			template<typename F>
+			bool TryPop(F&& visit)
+			{
+				Slot& slot = slots[dequeuePos & mask];
+				if (slot.Sequence.load(std::memory_order_acquire) != dequeuePos + 1)
+					return false;
+
+				// release the slot even if a listener throws
+				struct SlotRelease
+				{
+					EventQueue& queue;
+					Slot& slot;
+					~SlotRelease()
+					{
+						slot.VTable->Destroy(slot.Storage);
+						slot.Sequence.store(queue.dequeuePos + queue.mask + 1, std::memory_order_release);
+						++queue.dequeuePos;
+					}
+				} release{ *this, slot };
+
+				visit(*slot.VTable, slot.VTable->AsEvent(slot.Storage), dequeuePos);
+				return true;
+			}
+
+			size_t Capacity() const;
+
+		private:
+			EventQueue(const EventQueue&) = delete;
+			EventQueue& operator=(const EventQueue&) = delete;
+
+			struct Slot
+			{
+				std::atomic<size_t> Sequence;
+				const EventVTable* VTable;
+				alignas(std::max_align_t) unsigned char Storage[SLOT_SIZE];
+			};
+
+			std::unique_ptr<Slot[]> slots;
+			size_t mask;
+			alignas(64) std::atomic<size_t> enqueuePos;
+			alignas(64) size_t dequeuePos;	// consumer only
+		};
+	}
+}
\ No newline at end of file
@@ -0,0 +1,175 @@
+#include "EventReplay.h"
+
+#include <chrono>
+#include <thread>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+namespace LibCore
+{
+	namespace Event
+	{
+		static uint64_t ReplayNowMicros()
+		{
+			return std::chrono::duration_cast<std::chrono::microseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+		std::shared_ptr<EventReplayer> EventReplayer::Create(const std::string& tracePath)
+		{
+			std::ifstream file{ tracePath, std::ios::in | std::ios::binary };
+			if (!file)
+			{
+				std::cerr << "Failed to open event trace " << tracePath << std::endl;
+				return nullptr;
+			}
+
+			auto results = std::shared_ptr<EventReplayer>(new EventReplayer{});
+			results->trace.assign(std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{});
+			if (!results->Parse())
+			{
+				std::cerr << "Invalid event trace " << tracePath << std::endl;
+				return nullptr;
+			}
+			return results;
+		}
+
+		EventReplayer::EventReplayer()
+			: nextEvent{ 0 }
+			, speed{ 1.0f }
+			, startMicros{ 0 }
+		{
+
+		}
+
+		bool EventReplayer::Parse()
+		{
+			TraceReader reader{ trace.data(), trace.size() };
+
+			char magic[sizeof(TRACE_MAGIC)];
+			if (!reader.ReadBytes(magic, sizeof(magic)) || std::memcmp(magic, TRACE_MAGIC, sizeof(magic)) != 0)
+				return false;
+			if (reader.Read<uint8_t>() != TRACE_VERSION)
+				return false;
+
+			while (reader.Good() && !reader.AtEnd())
+			{
+				const uint8_t kind = reader.Read<uint8_t>();
+				if (kind == 0)
+				{
+					const uint16_t typeIndex = reader.Read<uint16_t>();
+					typeNames[typeIndex] = reader.ReadString();
+				}
+				else if (kind == 1)
+				{
+					TracedEvent evt;
+					evt.Micros = reader.Read<uint64_t>();
+					evt.TypeIndex = reader.Read<uint16_t>();
+					evt.PayloadSize = reader.Read<uint32_t>();
+					evt.PayloadOffset = reader.Offset();
+
+					// the payload is decoded when emitted
+					if (!reader.Skip(evt.PayloadSize))
+						break;
+					events.push_back(evt);
+				}
+				else
+				{
+					return false;
+				}
+			}
+
+			// a trace cut short by a crash still replays up to the last complete event
+			return true;
+		}
+
+		void EventReplayer::SetSpeed(float playbackSpeed)
+		{
+			speed = playbackSpeed;
+		}
+
+		float EventReplayer::GetSpeed() const
+		{
+			return speed;
+		}
+
+		uint64_t EventReplayer::PlaybackMicros() const
+		{
+			return static_cast<uint64_t>((ReplayNowMicros() - startMicros) * static_cast<double>(speed));
+		}
+
+		bool EventReplayer::EmitEvent(const TracedEvent& evt, EventSystem& system)
+		{
+			const auto& typeName = typeNames[evt.TypeIndex];
+			auto it = emitters.find(typeName);
+			if (it == emitters.end())
+			{
+				if (skippedTypes.insert(typeName).second)
+					std::cout << "Replay skipping unregistered event type " << typeName << std::endl;
+				return true;
+			}
+
+			TraceReader reader{ trace.data() + evt.PayloadOffset, evt.PayloadSize };
+			return it->second(reader, system);
+		}
+
+		bool EventReplayer::Update(EventSystem& system)
+		{
+			if (startMicros == 0)
+				startMicros = ReplayNowMicros();
+
+			const bool maxSpeed = speed <= 0.0f;
+			const uint64_t playbackMicros = maxSpeed ? 0 : PlaybackMicros();
+
+			while (nextEvent < events.size())
+			{
+				const auto& evt = events[nextEvent];
+				if (!maxSpeed && evt.Micros > playbackMicros)
+					break;
+				if (!EmitEvent(evt, system))
+					break;
+				++nextEvent;
+			}
+			return Finished();
+		}
+
+		size_t EventReplayer::Replay(EventSystem& system)
+		{
+			while (!Update(system))
+			{
+				system.ProcessEvents(-1.0f);
+
+				if (speed > 0.0f && nextEvent < events.size())
+				{
+					const uint64_t playbackMicros = PlaybackMicros();
+					const uint64_t dueMicros = events[nextEvent].Micros;
+					if (dueMicros > playbackMicros)
+						std::this_thread::sleep_for(std::chrono::microseconds{ static_cast<uint64_t>((dueMicros - playbackMicros) / speed) });
+				}
+			}
+			system.ProcessEvents(-1.0f);
+			return nextEvent;
+		}
+
+		bool EventReplayer::Finished() const
+		{
+			return nextEvent >= events.size();
+		}
+
+		size_t EventReplayer::EmittedEvents() const
+		{
+			return nextEvent;
+		}
+
+		size_t EventReplayer::TotalEvents() const
+		{
+			return events.size();
+		}
+
+		double EventReplayer::ElapsedSeconds() const
+		{
+			return startMicros ? (ReplayNowMicros() - startMicros) / 1e6 : 0.0;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "EventTrace.h"
+#include "EventSystem.h"
+
+namespace LibCore
+{
+	namespace Event
+	{
+		// Re-emits the events of a trace written by EventRecorder, either at the recorded pace
+		// (scaled by the speed) or as fast as the event queue accepts them.
+		class EventReplayer
+		{
+		public:
+			static std::shared_ptr<EventReplayer> Create(const std::string& tracePath);
+
+			// Only registered types are replayed, others are skipped
+			template<typename T>
+				requires TraceableEvent<T>
+			void Register()
+			{
+				emitters[T::TRACE_NAME] = [](TraceReader& reader, EventSystem& system) {
+					return system.Emit(T::Deserialize(reader));
+				};
+			}
+
+			// speed 1 replays at the recorded pace, 0 (or less) as fast as possible
+			void SetSpeed(float playbackSpeed);
+			float GetSpeed() const;
+
+			// Non-blocking, call once per frame: emits every event that is due. If the queue is full
+			// the remaining events wait for the next call. Returns true once the whole trace is emitted.
+			bool Update(EventSystem& system);
+
+			// Headless replay: emits and processes every event on the calling thread, sleeping
+			// between them when replaying at the recorded pace. Returns the number of events emitted.
+			size_t Replay(EventSystem& system);
+
+			bool Finished() const;
+			size_t EmittedEvents() const;
+			size_t TotalEvents() const;
+			double ElapsedSeconds() const;
+
+		private:
+			EventReplayer();
+			EventReplayer(const EventReplayer&) = delete;
+			EventReplayer& operator=(const EventReplayer&) = delete;
+
+			struct TracedEvent
+			{
+				uint64_t Micros;
+				uint16_t TypeIndex;
+				size_t PayloadOffset;
+				uint32_t PayloadSize;
+			};
+
+			bool Parse();
+			bool EmitEvent(const TracedEvent& evt, EventSystem& system);
+			uint64_t PlaybackMicros() const;
+
+			std::vector<char> trace;
+			std::vector<TracedEvent> events;
+			std::unordered_map<uint16_t, std::string> typeNames;
+			std::unordered_map<std::string, std::function<bool(TraceReader&, EventSystem&)>> emitters;
+			std::unordered_set<std::string> skippedTypes;
+			size_t nextEvent;
+			float speed;
+			uint64_t startMicros;	// 0 until the first Update
+		};
+	}
+}
\ No newline at end of file
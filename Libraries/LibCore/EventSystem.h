@@ -1,11 +1,15 @@
 #pragma once
 #include <functional>
-#include <unordered_map>
-#include <concurrent_queue.h>
+#include <array>
 #include <vector>
-#include <typeindex>
 #include <memory>
 #include <mutex>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+
+#include "EventQueue.h"
+#include "EventTrace.h"
 
 namespace LibCore
 {
@@ -16,32 +20,116 @@ namespace LibCore
 			virtual ~Event() = default;
 		};
 
+        // Event types opt into coalescing with a COALESCE member. When several events of such a type are
+        // queued, only the latest one is delivered, including when the queue is full and they wait in the
+        // overflow list, so listeners always end up with the newest value, e.g.
+        //     struct SliderChanged : LibCore::Event::Event { static constexpr bool COALESCE = true; float Value; };
+        template<typename T>
+        concept CoalescedEvent = T::COALESCE;
+
         class EventSystem {
         public:
-            using EventCallback = std::function<void(const Event&)>;
+            static const size_t DEFAULT_QUEUE_CAPACITY = 1024;
+            static const size_t MAX_COALESCED_TYPES = 64;   // coalescing is skipped for type ids beyond this
+            static const size_t BUDGET_CHECK_INTERVAL = 32; // events dispatched between clock reads
 
-            EventSystem() = default;
+            explicit EventSystem(size_t queueCapacity = DEFAULT_QUEUE_CAPACITY)
+                : queuedEvents{ queueCapacity }
+                , overflowedEvents{ 0 }
+                , overflowCoalesced{ 0 }
+                , overflowing{ false }
+                , coalescedEvents{ 0 }
+                , activeRecorder{ nullptr }
+            {
+                for (auto& position : latestPositions)
+                    position.store(0, std::memory_order_relaxed);
+            }
             ~EventSystem() = default;
 
             // Register listener for a specific event type
-            template<typename T>
-            void AddListener(std::function<void(const T&)> cb) 
+            template<typename T, typename F>
+            void AddListener(F&& cb) 
             {
+                using Callback = std::decay_t<F>;
+
                 std::lock_guard<std::mutex> lock{ mutex };
-                auto& vec = listeners[typeid(T)];
+                const size_t typeId = EventTypeId<T>();
+                if (listeners.size() <= typeId)
+                    listeners.resize(typeId + 1);
 
-                // wrap type-safe callback into base type
-                vec.push_back([cb = std::move(cb)](const Event& e) {
-                    cb(static_cast<const T&>(e));
+                // one indirect call per listener, the callback itself is invoked directly
+                listeners[typeId].push_back(Listener{
+                    [](void* self, const Event& e) { (*static_cast<Callback*>(self))(static_cast<const T&>(e)); },
+                    std::make_shared<Callback>(std::forward<F>(cb))
                 });
             }
 
-            // Emit an event of specific type
+            // Emit an event of specific type, safe from any thread. The event is stored inline in the queue,
+            // so this neither locks nor allocates beyond what copying/moving T itself does.
+            // When the queue is full the event is held in an allocated overflow list and delivered once the queue
+            // has drained, so none is lost; a coalesced event there replaces the pending one of its type.
             template<typename T>
-            void Emit(const T& event)  
+            bool Emit(T&& event)  
+            {
+                using EventType = std::decay_t<T>;
+                static_assert(std::is_base_of_v<Event, EventType>, "Events must derive from LibCore::Event::Event");
+
+                // serialized up front as the event is moved into the queue, recorded only once it was queued
+                EventRecorder* eventRecorder = nullptr;
+                TraceWriter payload;
+                if constexpr (TraceableEvent<EventType>)
+                {
+                    if ((eventRecorder = activeRecorder.load(std::memory_order_acquire)) != nullptr)
+                        event.Serialize(payload);
+                }
+
+                // behind events already in the overflow list rather than ahead of them
+                // (TryPush leaves the event untouched when it fails)
+                size_t position = 0;
+                if (!overflowing.load(std::memory_order_acquire) && queuedEvents.TryPush(std::forward<T>(event), &position))
+                {
+                    if constexpr (CoalescedEvent<EventType>)
+                    {
+                        // only published after the push succeeded, so a newer position always refers to a queued event
+                        const size_t typeId = EventTypeId<EventType>();
+                        if (typeId < MAX_COALESCED_TYPES)
+                        {
+                            size_t latest = latestPositions[typeId].load(std::memory_order_relaxed);
+                            while (latest < position && !latestPositions[typeId].compare_exchange_weak(latest, position, std::memory_order_relaxed));
+                        }
+                    }
+                }
+                else
+                    PushOverflow(std::forward<T>(event));
+
+                if constexpr (TraceableEvent<EventType>)
+                {
+                    if (eventRecorder)
+                        eventRecorder->RecordPayload(EventType::TRACE_NAME, payload.Data());
+                }
+                return true;
+            }
+
+            // events that went to the overflow list on a full queue
+            uint64_t OverflowedEvents() const
+            {
+                return overflowedEvents.load(std::memory_order_relaxed);
+            }
+
+            uint64_t CoalescedEvents() const
+            {
+                return coalescedEvents;
+            }
+
+            // Records every traceable event emitted from now on, nullptr stops recording.
+            // Set it before other threads start emitting; the recorder is kept alive until replaced.
+            void SetRecorder(const std::shared_ptr<EventRecorder>& eventRecorder)
             {
                 std::lock_guard<std::mutex> lock{ mutex };
-                queuedEvents.push(std::make_shared<T>(event));
+                activeRecorder.store(eventRecorder.get(), std::memory_order_release);
+                if (recorder)
+                    recorder->Flush();
+                recorder = eventRecorder;
             }
 
             // Remove all listeners of a given event type
@@ -49,7 +137,9 @@ namespace LibCore
             void RemoveListeners() 
             {
                 std::lock_guard<std::mutex> lock{ mutex };
-                listeners.erase(typeid(T));
+                const size_t typeId = EventTypeId<T>();
+                if (typeId < listeners.size())
+                    listeners[typeId].clear();
             }
 
             void RemoveAllListeners()
@@ -59,28 +149,103 @@ namespace LibCore
 
             void ProcessEvents(float maxSeconds)
             {
-                auto now = std::chrono::high_resolution_clock::now();
+                const auto timeBeg = std::chrono::steady_clock::now();
 
-                std::shared_ptr<Event> evt;
-                while (queuedEvents.try_pop(evt))
-                {
-                    auto it = listeners.find(std::type_index(typeid(*evt)));
-                    if (it != listeners.end()) 
+                auto dispatch = [this](const EventVTable& vtable, const Event& evt, size_t position) {
+                    if (vtable.TypeId < MAX_COALESCED_TYPES && latestPositions[vtable.TypeId].load(std::memory_order_relaxed) > position)
                     {
-                        for (auto& cb : it->second)
-                            cb(*evt);
+                        // a newer event of this type is further along the queue
+                        ++coalescedEvents;
+                        return;
                     }
+                    Dispatch(vtable.TypeId, evt);
+                };
+
+                size_t dispatched = 0;
+                while (queuedEvents.TryPop(dispatch))
+                {
+                    if (maxSeconds < 0.0f || ++dispatched % BUDGET_CHECK_INTERVAL != 0)
+                        continue;
 
-                    const auto diffTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - now).count() / 1000.0f;
-                    if (maxSeconds >= 0.0f && diffTime >= maxSeconds)
-                        break;
+                    // the overflow list waits for the queue to drain, it holds the newer events
+                    if (std::chrono::duration<float>{ std::chrono::steady_clock::now() - timeBeg }.count() >= maxSeconds)
+                        return;
+                }
+
+                if (overflowing.load(std::memory_order_acquire))
+                {
+                    std::vector<OverflowEvent> pending;
+                    {
+                        std::lock_guard<std::mutex> lock{ overflowMutex };
+                        pending.swap(overflow);
+                        overflowing.store(false, std::memory_order_release);
+                        coalescedEvents += overflowCoalesced;
+                        overflowCoalesced = 0;
+                    }
+                    for (auto& evt : pending)
+                        Dispatch(evt.TypeId, *evt.Evt);
                 }
             }
 
         private:
+            struct Listener
+            {
+                void (*Invoke)(void* self, const Event& evt);
+                std::shared_ptr<void> Self;
+            };
+
+            struct OverflowEvent
+            {
+                size_t TypeId;
+                std::shared_ptr<Event> Evt;
+            };
+
+            template<typename T>
+            void PushOverflow(T&& event)
+            {
+                using EventType = std::decay_t<T>;
+
+                std::lock_guard<std::mutex> lock{ overflowMutex };
+                if (overflowedEvents.fetch_add(1, std::memory_order_relaxed) == 0)
+                    std::cerr << "EventSystem queue full, holding events until it drains" << std::endl;
+
+                // the newest value moves to the back, in emission order with the events around it
+                if constexpr (CoalescedEvent<EventType>)
+                {
+                    overflowCoalesced += std::erase_if(overflow, [](const OverflowEvent& evt) { return evt.TypeId == EventTypeId<EventType>(); });
+                }
+                overflow.push_back(OverflowEvent{ EventTypeId<EventType>(), std::make_shared<EventType>(std::forward<T>(event)) });
+                overflowing.store(true, std::memory_order_release);
+            }
+
+            void Dispatch(size_t typeId, const Event& evt)
+            {
+                if (typeId >= listeners.size())
+                    return;
+
+                // indexed rather than iterated, listeners may add listeners
+                for (size_t i = 0; i < listeners[typeId].size(); ++i)
+                {
+                    // hold a reference in case the listener removes itself
+                    const auto listener = listeners[typeId][i];
+                    listener.Invoke(listener.Self.get(), evt);
+                }
+            }
+
             mutable std::mutex mutex;
-            concurrency::concurrent_queue<std::shared_ptr<Event>> queuedEvents;
-            std::unordered_map<std::type_index, std::vector<EventCallback>> listeners;
+            EventQueue queuedEvents;
+            std::atomic<uint64_t> overflowedEvents;
+            // events that found the queue full, delivered after it; the flag keeps later ones behind them
+            std::mutex overflowMutex;
+            std::vector<OverflowEvent> overflow;
+            std::atomic<bool> overflowing;
+            uint64_t overflowCoalesced;     // replaced in the overflow list, guarded by overflowMutex
+            // highest queue position emitted per coalesced type id, only events at it are delivered
+            std::array<std::atomic<size_t>, MAX_COALESCED_TYPES> latestPositions;
+            uint64_t coalescedEvents;   // consumer only
+            std::vector<std::vector<Listener>> listeners;   // indexed by EventTypeId
+            std::shared_ptr<EventRecorder> recorder;
+            std::atomic<EventRecorder*> activeRecorder;
         };
 	}
 }
\ No newline at end of file
@@ -0,0 +1,88 @@
+#include "EventTrace.h"
+
+#include <chrono>
+#include <iostream>
+
+#define TRACE_FLUSH_BYTES (64 * 1024)
+
+namespace LibCore
+{
+	namespace Event
+	{
+		static uint64_t TraceNowMicros()
+		{
+			return std::chrono::duration_cast<std::chrono::microseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+		std::shared_ptr<EventRecorder> EventRecorder::Create(const std::string& tracePath)
+		{
+			auto results = std::shared_ptr<EventRecorder>(new EventRecorder{});
+			results->file.open(tracePath, std::ios::out | std::ios::binary | std::ios::trunc);
+			if (!results->file)
+			{
+				std::cerr << "Failed to open event trace " << tracePath << std::endl;
+				return nullptr;
+			}
+
+			results->file.write(TRACE_MAGIC, sizeof(TRACE_MAGIC));
+			results->file.put(static_cast<char>(TRACE_VERSION));
+			return results;
+		}
+
+		EventRecorder::EventRecorder()
+			: startMicros{ TraceNowMicros() }
+			, recordedEvents{ 0 }
+		{
+
+		}
+
+		EventRecorder::~EventRecorder()
+		{
+			Flush();
+		}
+
+		void EventRecorder::RecordPayload(const char* typeName, const std::vector<char>& payload)
+		{
+			const uint64_t micros = TraceNowMicros() - startMicros;
+
+			std::lock_guard<std::mutex> lock{ mutex };
+			auto it = typeIndices.find(typeName);
+			if (it == typeIndices.end())
+			{
+				it = typeIndices.emplace(typeName, static_cast<uint16_t>(typeIndices.size())).first;
+				pending.Write(uint8_t{ 0 });
+				pending.Write(it->second);
+				pending.WriteString(typeName);
+			}
+
+			pending.Write(uint8_t{ 1 });
+			pending.Write(micros);
+			pending.Write(it->second);
+			pending.Write(static_cast<uint32_t>(payload.size()));
+			pending.WriteBytes(payload.data(), payload.size());
+			recordedEvents.fetch_add(1, std::memory_order_relaxed);
+
+			if (pending.Data().size() >= TRACE_FLUSH_BYTES)
+				FlushLocked();
+		}
+
+		void EventRecorder::Flush()
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			FlushLocked();
+		}
+
+		void EventRecorder::FlushLocked()
+		{
+			file.write(pending.Data().data(), pending.Data().size());
+			file.flush();
+			pending.Clear();
+		}
+
+		uint64_t EventRecorder::RecordedEvents() const
+		{
+			return recordedEvents.load(std::memory_order_relaxed);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstring>
+#include <fstream>
+#include <cstdint>
+#include <concepts>
+#include <type_traits>
+#include <unordered_map>
+
+namespace LibCore
+{
+	namespace Event
+	{
+		// Trace layout (native endianness):
+		//   header  "PETRACE" + u8 version
+		//   TYPE    u8 0, u16 type index, string name        (once per type, before its first event)
+		//   EVENT   u8 1, u64 micros since start, u16 type index, u32 payload size, payload
+		// strings are u32 length + bytes
+		static const char TRACE_MAGIC[7] = { 'P', 'E', 'T', 'R', 'A', 'C', 'E' };
+		static const uint8_t TRACE_VERSION = 1;
+
+		class TraceWriter
+		{
+		public:
+			void WriteBytes(const void* data, size_t size)
+			{
+				const char* bytes = static_cast<const char*>(data);
+				buffer.insert(buffer.end(), bytes, bytes + size);
+			}
+
+			template<typename T>
+			void Write(const T& value)
+			{
+				static_assert(std::is_trivially_copyable_v<T>, "TraceWriter::Write needs a trivially copyable type");
+				WriteBytes(&value, sizeof(T));
+			}
+
+			void WriteString(const std::string& str)
+			{
+				Write(static_cast<uint32_t>(str.size()));
+				WriteBytes(str.data(), str.size());
+			}
+
+			const std::vector<char>& Data() const { return buffer; }
+			void Clear() { buffer.clear(); }
+
+		private:
+			std::vector<char> buffer;
+		};
+
+		// Reads back what TraceWriter wrote. Reading past the end leaves values zeroed and Good() false.
+		class TraceReader
+		{
+		public:
+			TraceReader(const char* data, size_t size) : data{ data }, size{ size }, offset{ 0 }, good{ true } {}
+
+			bool ReadBytes(void* dst, size_t count)
+			{
+				if (!good || size - offset < count)
+				{
+					good = false;
+					return false;
+				}
+				std::memcpy(dst, data + offset, count);
+				offset += count;
+				return true;
+			}
+
+			bool Skip(size_t count)
+			{
+				if (!good || size - offset < count)
+				{
+					good = false;
+					return false;
+				}
+				offset += count;
+				return true;
+			}
+
+			template<typename T>
+			T Read()
+			{
+				static_assert(std::is_trivially_copyable_v<T>, "TraceReader::Read needs a trivially copyable type");
+				T value{};
+				ReadBytes(&value, sizeof(T));
+				return value;
+			}
+
+			std::string ReadString()
+			{
+				const uint32_t length = Read<uint32_t>();
+				if (!good || size - offset < length)
+				{
+					good = false;
+					return {};
+				}
+				std::string results{ data + offset, length };
+				offset += length;
+				return results;
+			}
+
+			bool Good() const { return good; }
+			bool AtEnd() const { return offset >= size; }
+			size_t Offset() const { return offset; }
+
+		private:
+			const char* data;
+			size_t size;
+			size_t offset;
+			bool good;
+		};
+
+		// Event types opt into tracing with a stable name plus Serialize/Deserialize, e.g.
+		//     static constexpr const char* TRACE_NAME = "SliderChanged";
+		//     void Serialize(LibCore::Event::TraceWriter& writer) const;
+		//     static SliderChanged Deserialize(LibCore::Event::TraceReader& reader);
+		template<typename T>
+		concept TraceableEvent = requires(const T& evt, TraceWriter& writer, TraceReader& reader)
+		{
+			{ T::TRACE_NAME } -> std::convertible_to<const char*>;
+			evt.Serialize(writer);
+			{ T::Deserialize(reader) } -> std::convertible_to<T>;
+		};
+
+		// Appends traceable events with their emit time to a binary trace. Record is safe from any thread.
+		class EventRecorder
+		{
+		public:
+			static std::shared_ptr<EventRecorder> Create(const std::string& tracePath);
+			~EventRecorder();
+
+			template<typename T>
+			void Record(const T& evt)
+			{
+				TraceWriter payload;
+				evt.Serialize(payload);
+				RecordPayload(T::TRACE_NAME, payload.Data());
+			}
+
+			// an event serialized by the caller, for recording it only once it was actually queued
+			void RecordPayload(const char* typeName, const std::vector<char>& payload);
+			void Flush();
+			uint64_t RecordedEvents() const;
+
+		private:
+			EventRecorder();
+			EventRecorder(const EventRecorder&) = delete;
+			EventRecorder& operator=(const EventRecorder&) = delete;
+
+			void FlushLocked();
+
+			std::mutex mutex;
+			std::ofstream file;
+			TraceWriter pending;
+			std::unordered_map<std::string, uint16_t> typeIndices;
+			uint64_t startMicros;
+			std::atomic<uint64_t> recordedEvents;
+		};
+	}
+}
\ No newline at end of file
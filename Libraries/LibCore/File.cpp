@@ -1,4 +1,6 @@
 #include "File.h"
+#include "MappedFile.h"
+#include "Hash.h"
 #include <fstream>
 
 namespace LibCore
@@ -100,6 +102,20 @@ namespace LibCore
 			return buffer;
 		}
 
+		std::shared_ptr<MappedFile> File::Map(MAP_MODE mode) const
+		{
+			return MappedFile::Open(*this, mode);
+		}
+
+		ContentFingerprint File::Fingerprint(MAP_MODE mode) const
+		{
+			const auto mapped = Map(mode);
+			if (!mapped)
+				return {};
+
+			return ContentFingerprint{ mapped->Size(), Utils::Hash::XXHash64(mapped->Data(), mapped->Size()), true };
+		}
+
 		bool File::Write(const std::string& content) const
 		{
 			return Write((const uint8_t*)content.data(), content.size());
@@ -112,11 +128,12 @@ namespace LibCore
 
 		bool File::Write(const uint8_t* data, size_t size) const
 		{
-			std::ofstream file{ path.string(), std::ios::out | std::ios::trunc };
+			std::ofstream file{ path, std::ios::out | std::ios::binary | std::ios::trunc };
 			if (!file.is_open()) return false;
 
 			file.write((const char*)data, static_cast<std::streamsize>(size));
-			return true;
+			file.close();
+			return !file.fail();
 		}
 	}
 }
\ No newline at end of file
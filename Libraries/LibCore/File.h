@@ -1,5 +1,9 @@
 #pragma once
 
+#include <string>
+#include <memory>
+#include <vector>
+#include <cstdint>
 #include <filesystem>
 #include "Path.h"
 
@@ -7,6 +11,28 @@ namespace LibCore
 {
 	namespace Filesystem
 	{
+		class MappedFile;
+
+		// How a file is brought into memory: MAPPED faults pages in as they are touched, READ copies it with
+		// regular reads. READ is for files another process may still truncate or replace, where touching a
+		// mapped page past the new end raises SIGBUS.
+		enum class MAP_MODE { MAPPED, READ };
+
+		// Size + XXH64 of the whole file, equal fingerprints mean byte-identical contents in practice
+		struct ContentFingerprint
+		{
+			uint64_t Size = 0;
+			uint64_t Hash = 0;
+			bool Valid = false;
+
+			bool operator==(const ContentFingerprint& rhs) const = default;
+
+			struct Hasher
+			{
+				size_t operator()(const ContentFingerprint& fingerprint) const { return static_cast<size_t>(fingerprint.Hash ^ fingerprint.Size); }
+			};
+		};
+
 		class File 
 		{
 		public:
@@ -23,6 +49,8 @@ namespace LibCore
 
 			std::string ReadText() const;
 			std::vector<uint8_t> ReadBinary() const;
+			std::shared_ptr<MappedFile> Map(MAP_MODE mode = MAP_MODE::MAPPED) const;	// null if the file cannot be opened
+			ContentFingerprint Fingerprint(MAP_MODE mode = MAP_MODE::MAPPED) const;	// invalid if the file cannot be read
 
 			bool Write(const std::string& content) const;
 			bool Write(const std::vector<uint8_t>& data) const;
@@ -0,0 +1,85 @@
+#include "FilterParameters.h"
+#include "Hash.h"
+
+namespace LibCore
+{
+	namespace Utils
+	{
+		uint64_t FilterParameters::Hash(uint64_t seed) const
+		{
+			auto hashValue = [&seed](const std::string& name, const void* data, size_t size) {
+				seed = Hash::XXHash64(name.data(), name.size(), seed);
+				seed = Hash::XXHash64(data, size, seed);
+			};
+
+			for (auto& p : Ints)   hashValue(p.first, &p.second, sizeof(int));
+			for (auto& p : Floats) hashValue(p.first, &p.second, sizeof(float));
+			for (auto& p : Vec2s)  { const float v[] = { p.second.x, p.second.y };                         hashValue(p.first, v, sizeof(v)); }
+			for (auto& p : Vec3s)  { const float v[] = { p.second.x, p.second.y, p.second.z };             hashValue(p.first, v, sizeof(v)); }
+			for (auto& p : Vec4s)  { const float v[] = { p.second.x, p.second.y, p.second.z, p.second.w }; hashValue(p.first, v, sizeof(v)); }
+			return seed;
+		}
+
+		void FilterParameters::SerializeSources(LibCore::Event::TraceWriter& writer, const std::vector<std::string>& sources)
+		{
+			writer.Write(static_cast<uint32_t>(sources.size()));
+			for (auto& source : sources)
+				writer.WriteString(source);
+		}
+
+		std::vector<std::string> FilterParameters::DeserializeSources(LibCore::Event::TraceReader& reader)
+		{
+			std::vector<std::string> sources(reader.Read<uint32_t>());
+			for (auto& source : sources)
+				source = reader.ReadString();
+			return reader.Good() ? sources : std::vector<std::string>{};
+		}
+
+		void FilterParameters::Serialize(LibCore::Event::TraceWriter& writer) const
+		{
+			writer.Write(static_cast<uint32_t>(Ints.size()));
+			for (auto& p : Ints)   { writer.WriteString(p.first); writer.Write(p.second); }
+			writer.Write(static_cast<uint32_t>(Floats.size()));
+			for (auto& p : Floats) { writer.WriteString(p.first); writer.Write(p.second); }
+			writer.Write(static_cast<uint32_t>(Vec2s.size()));
+			for (auto& p : Vec2s)  { writer.WriteString(p.first); writer.Write(p.second.x); writer.Write(p.second.y); }
+			writer.Write(static_cast<uint32_t>(Vec3s.size()));
+			for (auto& p : Vec3s)  { writer.WriteString(p.first); writer.Write(p.second.x); writer.Write(p.second.y); writer.Write(p.second.z); }
+			writer.Write(static_cast<uint32_t>(Vec4s.size()));
+			for (auto& p : Vec4s)  { writer.WriteString(p.first); writer.Write(p.second.x); writer.Write(p.second.y); writer.Write(p.second.z); writer.Write(p.second.w); }
+		}
+
+		bool FilterParameters::Deserialize(LibCore::Event::TraceReader& reader)
+		{
+			for (uint32_t i = reader.Read<uint32_t>(); i > 0 && reader.Good(); --i)
+			{
+				auto name = reader.ReadString();
+				Ints[name] = reader.Read<int>();
+			}
+			for (uint32_t i = reader.Read<uint32_t>(); i > 0 && reader.Good(); --i)
+			{
+				auto name = reader.ReadString();
+				Floats[name] = reader.Read<float>();
+			}
+			for (uint32_t i = reader.Read<uint32_t>(); i > 0 && reader.Good(); --i)
+			{
+				auto name = reader.ReadString();
+				const float x = reader.Read<float>(), y = reader.Read<float>();
+				Vec2s[name] = LibCore::Math::Vec2{ x, y };
+			}
+			for (uint32_t i = reader.Read<uint32_t>(); i > 0 && reader.Good(); --i)
+			{
+				auto name = reader.ReadString();
+				const float x = reader.Read<float>(), y = reader.Read<float>(), z = reader.Read<float>();
+				Vec3s[name] = LibCore::Math::Vec3{ x, y, z };
+			}
+			for (uint32_t i = reader.Read<uint32_t>(); i > 0 && reader.Good(); --i)
+			{
+				auto name = reader.ReadString();
+				const float x = reader.Read<float>(), y = reader.Read<float>(), z = reader.Read<float>(), w = reader.Read<float>();
+				Vec4s[name] = LibCore::Math::Vec4{ x, y, z, w };
+			}
+			return reader.Good();
+		}
+	}
+}
\ No newline at end of file
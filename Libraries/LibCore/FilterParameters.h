@@ -0,0 +1,38 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "Vec2.h"
+#include "Vec3.h"
+#include "Vec4.h"
+#include "EventTrace.h"
+
+namespace LibCore
+{
+	namespace Utils
+	{
+		// Uniform values of a filter by name, shared by LibGraphics::TextureFilter and LibCV::CPUFilter so a preset
+		// reads, writes and hashes the same whichever backend holds it.
+		struct FilterParameters
+		{
+			std::map<std::string, int> Ints;
+			std::map<std::string, float> Floats;
+			std::map<std::string, LibCore::Math::Vec2> Vec2s;
+			std::map<std::string, LibCore::Math::Vec3> Vec3s;
+			std::map<std::string, LibCore::Math::Vec4> Vec4s;
+
+			// the maps are ordered, so equal parameters always hash in the same sequence
+			uint64_t Hash(uint64_t seed = 0) const;
+
+			// a filter is written as its shader sources followed by the values
+			static void SerializeSources(LibCore::Event::TraceWriter& writer, const std::vector<std::string>& sources);
+			static std::vector<std::string> DeserializeSources(LibCore::Event::TraceReader& reader);
+			void Serialize(LibCore::Event::TraceWriter& writer) const;
+			// false if the reader ran out
+			bool Deserialize(LibCore::Event::TraceReader& reader);
+		};
+	}
+}
\ No newline at end of file
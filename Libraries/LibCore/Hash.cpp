@@ -0,0 +1,113 @@
+#include "Hash.h"
+
+#include <cstring>
+
+#define XXH_PRIME64_1 0x9E3779B185EBCA87ULL
+#define XXH_PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define XXH_PRIME64_3 0x165667B19E3779F9ULL
+#define XXH_PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define XXH_PRIME64_5 0x27D4EB2F165667C5ULL
+
+namespace LibCore
+{
+	namespace Utils
+	{
+		static inline uint64_t RotateLeft(uint64_t value, int bits)
+		{
+			return (value << bits) | (value >> (64 - bits));
+		}
+
+		// unaligned little-endian reads, every supported target is little-endian
+		static inline uint64_t Read64(const uint8_t* ptr)
+		{
+			uint64_t value;
+			std::memcpy(&value, ptr, sizeof(value));
+			return value;
+		}
+
+		static inline uint32_t Read32(const uint8_t* ptr)
+		{
+			uint32_t value;
+			std::memcpy(&value, ptr, sizeof(value));
+			return value;
+		}
+
+		static inline uint64_t Round(uint64_t accumulator, uint64_t input)
+		{
+			accumulator += input * XXH_PRIME64_2;
+			accumulator = RotateLeft(accumulator, 31);
+			return accumulator * XXH_PRIME64_1;
+		}
+
+		static inline uint64_t MergeRound(uint64_t accumulator, uint64_t value)
+		{
+			accumulator ^= Round(0, value);
+			return accumulator * XXH_PRIME64_1 + XXH_PRIME64_4;
+		}
+
+		uint64_t Hash::XXHash64(const void* data, size_t size, uint64_t seed)
+		{
+			const uint8_t* ptr = static_cast<const uint8_t*>(data);
+			const uint8_t* const end = ptr + size;
+			uint64_t hash;
+
+			if (size >= 32)
+			{
+				// four independent lanes over 32-byte stripes
+				uint64_t v1 = seed + XXH_PRIME64_1 + XXH_PRIME64_2;
+				uint64_t v2 = seed + XXH_PRIME64_2;
+				uint64_t v3 = seed;
+				uint64_t v4 = seed - XXH_PRIME64_1;
+
+				const uint8_t* const limit = end - 32;
+				do
+				{
+					v1 = Round(v1, Read64(ptr));
+					v2 = Round(v2, Read64(ptr + 8));
+					v3 = Round(v3, Read64(ptr + 16));
+					v4 = Round(v4, Read64(ptr + 24));
+					ptr += 32;
+				} while (ptr <= limit);
+
+				hash = RotateLeft(v1, 1) + RotateLeft(v2, 7) + RotateLeft(v3, 12) + RotateLeft(v4, 18);
+				hash = MergeRound(hash, v1);
+				hash = MergeRound(hash, v2);
+				hash = MergeRound(hash, v3);
+				hash = MergeRound(hash, v4);
+			}
+			else
+			{
+				hash = seed + XXH_PRIME64_5;
+			}
+
+			hash += static_cast<uint64_t>(size);
+
+			for (; ptr + 8 <= end; ptr += 8)
+			{
+				hash ^= Round(0, Read64(ptr));
+				hash = RotateLeft(hash, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+			}
+
+			if (ptr + 4 <= end)
+			{
+				hash ^= static_cast<uint64_t>(Read32(ptr)) * XXH_PRIME64_1;
+				hash = RotateLeft(hash, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+				ptr += 4;
+			}
+
+			for (; ptr < end; ++ptr)
+			{
+				hash ^= (*ptr) * XXH_PRIME64_5;
+				hash = RotateLeft(hash, 11) * XXH_PRIME64_1;
+			}
+
+			// avalanche
+			hash ^= hash >> 33;
+			hash *= XXH_PRIME64_2;
+			hash ^= hash >> 29;
+			hash *= XXH_PRIME64_3;
+			hash ^= hash >> 32;
+			return hash;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace LibCore
+{
+	namespace Utils
+	{
+		class Hash
+		{
+		public:
+			// XXH64, matches the reference implementation bit for bit
+			static uint64_t XXHash64(const void* data, size_t size, uint64_t seed = 0);
+		};
+	}
+}
\ No newline at end of file
@@ -0,0 +1,118 @@
+#include "IOBuffer.h"
+
+#include <new>
+#include <cstring>
+#include <utility>
+#include <algorithm>
+
+namespace LibCore
+{
+	namespace Filesystem
+	{
+		IOBuffer::IOBuffer()
+			: data{ nullptr }
+			, size{ 0 }
+			, capacity{ 0 }
+		{
+
+		}
+
+		IOBuffer::IOBuffer(size_t size)
+			: IOBuffer{}
+		{
+			Resize(size);
+		}
+
+		IOBuffer::IOBuffer(const uint8_t* data, size_t size)
+			: IOBuffer{}
+		{
+			Append(data, size);
+		}
+
+		IOBuffer::IOBuffer(IOBuffer&& other) noexcept
+			: data{ std::exchange(other.data, nullptr) }
+			, size{ std::exchange(other.size, 0) }
+			, capacity{ std::exchange(other.capacity, 0) }
+		{
+
+		}
+
+		IOBuffer& IOBuffer::operator=(IOBuffer&& other) noexcept
+		{
+			if (this != &other)
+			{
+				std::swap(data, other.data);
+				std::swap(size, other.size);
+				std::swap(capacity, other.capacity);
+			}
+			return *this;
+		}
+
+		IOBuffer::~IOBuffer()
+		{
+			if (data)
+				::operator delete(data, std::align_val_t{ ALIGNMENT });
+		}
+
+		uint8_t* IOBuffer::Data()
+		{
+			return data;
+		}
+
+		const uint8_t* IOBuffer::Data() const
+		{
+			return data;
+		}
+
+		size_t IOBuffer::Size() const
+		{
+			return size;
+		}
+
+		size_t IOBuffer::Capacity() const
+		{
+			return capacity;
+		}
+
+		bool IOBuffer::Empty() const
+		{
+			return size == 0;
+		}
+
+		void IOBuffer::Resize(size_t newSize)
+		{
+			if (newSize > capacity)
+				Reserve(std::max(newSize, capacity * 2));
+			size = newSize;
+		}
+
+		void IOBuffer::Append(const uint8_t* bytes, size_t count)
+		{
+			if (count == 0)
+				return;
+
+			const size_t offset = size;
+			Resize(size + count);
+			std::memcpy(data + offset, bytes, count);
+		}
+
+		void IOBuffer::Clear()
+		{
+			size = 0;
+		}
+
+		void IOBuffer::Reserve(size_t newCapacity)
+		{
+			// whole pages, so the tail of the last page is ours too
+			newCapacity = (newCapacity + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+			auto* newData = static_cast<uint8_t*>(::operator new(newCapacity, std::align_val_t{ ALIGNMENT }));
+			if (data)
+			{
+				std::memcpy(newData, data, size);
+				::operator delete(data, std::align_val_t{ ALIGNMENT });
+			}
+			data = newData;
+			capacity = newCapacity;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace LibCore
+{
+	namespace Filesystem
+	{
+		// Move-only byte buffer aligned to the page size, used for whole-file reads and writes
+		// so the kernel can copy (or DMA) page by page.
+		class IOBuffer
+		{
+		public:
+			static const size_t ALIGNMENT = 4096;
+
+			IOBuffer();
+			explicit IOBuffer(size_t size);
+			IOBuffer(const uint8_t* data, size_t size);
+			IOBuffer(IOBuffer&& other) noexcept;
+			IOBuffer& operator=(IOBuffer&& other) noexcept;
+			~IOBuffer();
+
+			uint8_t* Data();
+			const uint8_t* Data() const;
+			size_t Size() const;
+			size_t Capacity() const;
+			bool Empty() const;
+
+			// keeps the existing bytes, grows the allocation geometrically
+			void Resize(size_t size);
+			void Append(const uint8_t* data, size_t size);
+			void Clear();
+
+		private:
+			IOBuffer(const IOBuffer&) = delete;
+			IOBuffer& operator=(const IOBuffer&) = delete;
+
+			void Reserve(size_t capacity);
+
+			uint8_t* data;
+			size_t size, capacity;
+		};
+	}
+}
\ No newline at end of file
@@ -0,0 +1,244 @@
+#include "JobJournal.h"
+
+#include <chrono>
+#include <sstream>
+#include <iostream>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#define JOURNAL_HEADER "# job journal v1"
+
+namespace LibCore
+{
+	namespace Filesystem
+	{
+		std::shared_ptr<JobJournal> JobJournal::Open(const File& journalFile, const Options& options)
+		{
+			auto results = std::shared_ptr<JobJournal>(new JobJournal{ journalFile, options });
+			results->Load();
+			if (results->Forwarding())
+				return results;
+
+#if defined(_WIN32)
+			results->handle = _wfopen(results->journalPath.wstring().c_str(), L"ab");
+#else
+			results->handle = std::fopen(results->journalPath.string().c_str(), "ab");
+#endif
+			if (!results->handle)
+			{
+				std::cerr << "Cannot open job journal " << results->journalPath.string() << std::endl;
+				return nullptr;
+			}
+
+			std::error_code ec;
+			if (std::filesystem::file_size(results->journalPath, ec) == 0 && !ec)
+			{
+				std::lock_guard<std::mutex> lock{ results->pendingMutex };
+				results->pending = JOURNAL_HEADER "\n";
+			}
+
+			results->flusher = std::thread{ [journal = results.get()]() { journal->FlushLoop(); } };
+			return results;
+		}
+
+		JobJournal::JobJournal(const File& journalFile, const Options& options)
+			: journalPath{ journalFile.FilePath().String() }
+			, baseDirectory{ journalPath.parent_path() }
+			, options{ options }
+			, handle{ nullptr }
+			, loadedRecords{ 0 }
+			, pendingRecords{ 0 }
+			, stopped{ false }
+		{
+
+		}
+
+		JobJournal::~JobJournal()
+		{
+			{
+				std::lock_guard<std::mutex> lock{ pendingMutex };
+				stopped = true;
+			}
+			pendingCondition.notify_one();
+			if (flusher.joinable())
+				flusher.join();
+
+			Sync();
+			if (handle)
+				std::fclose(handle);
+		}
+
+		void JobJournal::Append(STATUS status, const ContentFingerprint& input, uint64_t presetHash, const std::string& output)
+		{
+			if (output.find_first_of("\r\n") != std::string::npos)
+				return;	// cannot be stored on one line, the output is just redone next time
+
+			uint64_t outputSize = 0;
+			if (status == STATUS::DONE)
+			{
+				std::error_code ec;
+				outputSize = std::filesystem::file_size(baseDirectory / output, ec);
+				if (ec)
+					status = STATUS::FAILED;
+			}
+
+			Record record{ status, input, presetHash, outputSize, output };
+			const std::string line = Format(record);
+			{
+				std::lock_guard<std::mutex> lock{ recordMutex };
+				records[output] = std::move(record);
+			}
+
+			if (Forwarding())
+			{
+				options.Forward(line.substr(0, line.size() - 1));
+				return;
+			}
+
+			bool syncNow = false;
+			{
+				std::lock_guard<std::mutex> lock{ pendingMutex };
+				pending += line;
+				syncNow = ++pendingRecords >= options.SyncBatch;
+			}
+			if (syncNow)
+				pendingCondition.notify_one();
+		}
+
+		bool JobJournal::IsCompleted(const std::string& output, const ContentFingerprint& input, uint64_t presetHash) const
+		{
+			uint64_t outputSize = 0;
+			{
+				std::lock_guard<std::mutex> lock{ recordMutex };
+				auto found = records.find(output);
+				if (found == records.end())
+					return false;
+
+				const auto& record = found->second;
+				if (record.Status != STATUS::DONE || !(record.Input == input) || record.PresetHash != presetHash)
+					return false;
+				outputSize = record.OutputSize;
+			}
+
+			// the record can outlive its output: deleted by the user, or lost with the page cache on a power cut
+			std::error_code ec;
+			return std::filesystem::file_size(baseDirectory / output, ec) == outputSize && !ec;
+		}
+
+		void JobJournal::Sync()
+		{
+			std::lock_guard<std::mutex> fileLock{ fileMutex };
+
+			std::string lines;
+			{
+				std::lock_guard<std::mutex> lock{ pendingMutex };
+				std::swap(lines, pending);
+				pendingRecords = 0;
+			}
+			if (lines.empty() || !handle)
+				return;
+
+			const bool written = std::fwrite(lines.data(), 1, lines.size(), handle) == lines.size() && std::fflush(handle) == 0;
+#if defined(_WIN32)
+			const bool synced = _commit(_fileno(handle)) == 0;
+#else
+			const bool synced = fsync(fileno(handle)) == 0;
+#endif
+			if (!written || !synced)
+				std::cerr << "Failed to write job journal " << journalPath.string() << std::endl;
+		}
+
+		size_t JobJournal::LoadedRecords() const
+		{
+			return loadedRecords;
+		}
+
+		bool JobJournal::Forwarding() const
+		{
+			return static_cast<bool>(options.Forward);
+		}
+
+		void JobJournal::FlushLoop()
+		{
+			std::unique_lock<std::mutex> lock{ pendingMutex };
+			while (!stopped)
+			{
+				pendingCondition.wait_for(lock, std::chrono::milliseconds{ options.SyncIntervalMs }, [this]() {
+					return stopped || pendingRecords >= options.SyncBatch;
+				});
+
+				if (pending.empty())
+					continue;
+
+				lock.unlock();
+				Sync();
+				lock.lock();
+			}
+		}
+
+		void JobJournal::Load()
+		{
+			if (!File{ journalPath.string().c_str() }.Exists())
+				return;
+
+			const std::string contents = File{ journalPath.string().c_str() }.ReadText();
+			size_t begin = 0;
+			for (size_t end = contents.find('\n'); end != std::string::npos; begin = end + 1, end = contents.find('\n', begin))
+			{
+				Record record;
+				if (!Parse(contents.substr(begin, end - begin), record))
+					continue;
+
+				records[record.Output] = std::move(record);
+				++loadedRecords;
+			}
+
+			// cut the torn record off, the next append would otherwise continue its line
+			if (begin != contents.size() && !Forwarding())
+			{
+				std::error_code ec;
+				std::filesystem::resize_file(journalPath, begin, ec);
+			}
+		}
+
+		bool JobJournal::Parse(const std::string& line, Record& record)
+		{
+			if (line.empty() || line[0] == '#')
+				return false;
+
+			std::istringstream stream{ line };
+			std::string status;
+			stream >> status;
+			if (status == "DONE")
+				record.Status = STATUS::DONE;
+			else if (status == "FAILED")
+				record.Status = STATUS::FAILED;
+			else
+				return false;
+
+			stream >> record.Input.Size >> std::hex >> record.Input.Hash >> record.PresetHash >> std::dec >> record.OutputSize;
+			if (!stream || stream.get() != '\t')
+				return false;
+
+			std::getline(stream, record.Output);
+			record.Input.Valid = true;
+			return !record.Output.empty();
+		}
+
+		std::string JobJournal::Format(const Record& record)
+		{
+			std::ostringstream stream;
+			stream << (record.Status == STATUS::DONE ? "DONE" : "FAILED") << '\t'
+				<< record.Input.Size << '\t'
+				<< std::hex << record.Input.Hash << '\t'
+				<< record.PresetHash << '\t'
+				<< std::dec << record.OutputSize << '\t'
+				<< record.Output << '\n';
+			return stream.str();
+		}
+	}
+}
\ No newline at end of file
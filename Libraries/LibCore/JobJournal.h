@@ -0,0 +1,92 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <memory>
+#include <thread>
+#include <functional>
+#include <cstdio>
+#include <cstdint>
+#include <filesystem>
+#include <unordered_map>
+#include <condition_variable>
+
+#include "File.h"
+
+namespace LibCore
+{
+	namespace Filesystem
+	{
+		// Append-only record of the outputs a batch job produced, one text line per output.
+		// Records are buffered and written + fsync'd in batches by a flusher thread, so a crash loses
+		// at most the last batch (those outputs are simply redone). A torn last line is ignored on load.
+		class JobJournal
+		{
+		public:
+			enum class STATUS { DONE, FAILED };
+
+			struct Options
+			{
+				unsigned SyncIntervalMs = 500;	// longest a record waits before it is made durable
+				unsigned SyncBatch = 32;		// records that trigger a sync without waiting
+				// if set, appended records go here (one journal line, no newline) instead of into the file, which is
+				// then only read; worker processes hand their records to the process that owns the journal
+				std::function<void(const std::string& line)> Forward;
+			};
+
+			struct Record
+			{
+				STATUS Status;
+				ContentFingerprint Input;
+				uint64_t PresetHash;
+				uint64_t OutputSize;
+				std::string Output;				// relative to the journal's directory
+			};
+
+			// loads the records already in the file, null if it cannot be opened for appending
+			static std::shared_ptr<JobJournal> Open(const File& journalFile, const Options& options);
+			~JobJournal();
+
+			// outputs are named relative to the journal's directory, the size of DONE outputs is recorded
+			void Append(STATUS status, const ContentFingerprint& input, uint64_t presetHash, const std::string& output);
+			// true if the last record for output is DONE for this input and preset and the file still has the recorded size
+			bool IsCompleted(const std::string& output, const ContentFingerprint& input, uint64_t presetHash) const;
+			// writes and syncs everything appended so far
+			void Sync();
+
+			size_t LoadedRecords() const;
+			bool Forwarding() const;
+
+			// one journal line, without the newline
+			static bool Parse(const std::string& line, Record& record);
+
+		private:
+			JobJournal(const File& journalFile, const Options& options);
+			JobJournal(const JobJournal&) = delete;
+			JobJournal& operator=(const JobJournal&) = delete;
+
+			void Load();
+			void FlushLoop();
+			static std::string Format(const Record& record);
+
+			std::filesystem::path journalPath, baseDirectory;
+			Options options;
+			std::FILE* handle;
+			size_t loadedRecords;
+
+			// latest record per output
+			mutable std::mutex recordMutex;
+			std::unordered_map<std::string, Record> records;
+
+			// pending lines, written by the flusher thread
+			std::mutex pendingMutex;
+			std::condition_variable pendingCondition;
+			std::string pending;
+			unsigned pendingRecords;
+			bool stopped;
+
+			std::mutex fileMutex;
+			std::thread flusher;
+		};
+	}
+}
\ No newline at end of file
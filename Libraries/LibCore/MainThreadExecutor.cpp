@@ -0,0 +1,115 @@
+#include "MainThreadExecutor.h"
+
+#include <chrono>
+
+namespace LibCore
+{
+	namespace Async
+	{
+		MainThreadExecutor::MainThreadExecutor()
+			: tasks{}
+			, nextSequence{ 0 }
+			, lastFrame{ 0, 0, 0.0f, 0.0f, 0 }
+		{
+
+		}
+
+		void MainThreadExecutor::Submit(std::function<void()> task)
+		{
+			Submit(std::move(task), PRIORITY::NORMAL);
+		}
+
+		void MainThreadExecutor::Submit(std::function<void()> task, PRIORITY priority)
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			tasks[static_cast<size_t>(priority)].push_back(QueuedTask{ nextSequence++, std::move(task) });
+		}
+
+		size_t MainThreadExecutor::ProcessTasks()
+		{
+			return ProcessTasks(0.0f);
+		}
+
+		size_t MainThreadExecutor::ProcessTasks(float budgetMillis)
+		{
+			using clock = std::chrono::steady_clock;
+			const auto timeBeg = clock::now();
+			const auto deadline = timeBeg + std::chrono::duration_cast<clock::duration>(std::chrono::duration<float, std::milli>{ budgetMillis });
+
+			uint64_t endSequence = 0;
+			{
+				std::lock_guard<std::mutex> lock{ mutex };
+				endSequence = nextSequence;
+			}
+
+			size_t executed = 0;
+			std::function<void()> task;
+			while (PopTask(endSequence, task))
+			{
+				task();
+				task = nullptr;
+				++executed;
+
+				if (budgetMillis > 0.0f && clock::now() >= deadline)
+					break;
+			}
+
+			std::lock_guard<std::mutex> lock{ mutex };
+			lastFrame.Executed = executed;
+			lastFrame.Deferred = 0;
+			for (auto& queue : tasks)
+				lastFrame.Deferred += queue.size();
+			lastFrame.SpentMillis = std::chrono::duration<float, std::milli>{ clock::now() - timeBeg }.count();
+			lastFrame.BudgetMillis = budgetMillis;
+			lastFrame.TotalDeferred += lastFrame.Deferred;
+			return executed;
+		}
+
+		bool MainThreadExecutor::PopTask(uint64_t endSequence, std::function<void()>& task)
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			for (auto& queue : tasks)
+			{
+				// sequences increase along each queue, so only the front needs checking
+				if (!queue.empty() && queue.front().Sequence < endSequence)
+				{
+					task = std::move(queue.front().Func);
+					queue.pop_front();
+					return true;
+				}
+			}
+			return false;
+		}
+
+		size_t MainThreadExecutor::PendingTasks() const
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			size_t results = 0;
+			for (auto& queue : tasks)
+				results += queue.size();
+			return results;
+		}
+
+		MainThreadExecutor::FrameStats MainThreadExecutor::GetLastFrameStats() const
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			return lastFrame;
+		}
+
+		MainThreadQueue::MainThreadQueue(const std::shared_ptr<MainThreadExecutor>& target, MainThreadExecutor::PRIORITY priority)
+			: target{ target }
+			, priority{ priority }
+			, alive{ std::make_shared<bool>(true) }
+		{
+
+		}
+
+		void MainThreadQueue::Submit(std::function<void()> task)
+		{
+			target->Submit([task = std::move(task), owner = std::weak_ptr<bool>{ alive }]() {
+				if (owner.lock())
+					task();
+			}, priority);
+		}
+	}
+}
\ No newline at end of file
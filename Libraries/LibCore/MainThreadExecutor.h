@@ -0,0 +1,91 @@
+#pragma once
+
+#include <array>
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <functional>
+
+#include "ThreadPool.h"
+
+namespace LibCore
+{
+	namespace Async
+	{
+		// Collects work from any thread and runs it on the thread that calls ProcessTasks(),
+		// typically the main/GL thread once per frame.
+		class MainThreadExecutor : public Executor
+		{
+		public:
+			enum class PRIORITY : int
+			{
+				HIGH = 0,	// interactive, e.g. the image being edited
+				NORMAL,		// visible UI, e.g. thumbnails
+				LOW,		// background, e.g. batch export
+				COUNT
+			};
+
+			struct FrameStats
+			{
+				size_t Executed;		// tasks run in the last ProcessTasks call
+				size_t Deferred;		// tasks left queued when it returned
+				float SpentMillis;
+				float BudgetMillis;		// 0 when unbounded
+				uint64_t TotalDeferred;	// sum of Deferred over all calls
+			};
+
+			MainThreadExecutor();
+			~MainThreadExecutor() override = default;
+
+			void Submit(std::function<void()> task) override;
+			void Submit(std::function<void()> task, PRIORITY priority);
+
+			// Runs the tasks queued before this call. Tasks submitted while running wait for the next call,
+			// so a task that re-posts itself cannot starve the caller. Returns the number of tasks run.
+			size_t ProcessTasks();
+			// Same as above, highest priority first, stopping once budgetMillis is spent (0 for no limit).
+			// At least one task is run per call so a single long job cannot stall forever.
+			size_t ProcessTasks(float budgetMillis);
+
+			size_t PendingTasks() const;
+			FrameStats GetLastFrameStats() const;
+
+		private:
+			MainThreadExecutor(const MainThreadExecutor&) = delete;
+			MainThreadExecutor& operator=(const MainThreadExecutor&) = delete;
+
+			struct QueuedTask
+			{
+				uint64_t Sequence;
+				std::function<void()> Func;
+			};
+
+			bool PopTask(uint64_t endSequence, std::function<void()>& task);
+
+			mutable std::mutex mutex;
+			std::array<std::deque<QueuedTask>, static_cast<size_t>(PRIORITY::COUNT)> tasks;
+			uint64_t nextSequence;
+			FrameStats lastFrame;
+		};
+
+		// Executor view over a MainThreadExecutor that posts at a fixed priority. Tasks still queued when
+		// the view is destroyed are dropped instead of run, so an owner can abandon its pending GL work
+		// (e.g. suspended coroutines) by destroying the view. Destroy it on the main thread.
+		class MainThreadQueue : public Executor
+		{
+		public:
+			MainThreadQueue(const std::shared_ptr<MainThreadExecutor>& target, MainThreadExecutor::PRIORITY priority);
+			~MainThreadQueue() override = default;
+
+			void Submit(std::function<void()> task) override;
+
+		private:
+			MainThreadQueue(const MainThreadQueue&) = delete;
+			MainThreadQueue& operator=(const MainThreadQueue&) = delete;
+
+			std::shared_ptr<MainThreadExecutor> target;
+			MainThreadExecutor::PRIORITY priority;
+			std::shared_ptr<bool> alive;
+		};
+	}
+}
\ No newline at end of file
@@ -0,0 +1,143 @@
+#include "MappedFile.h"
+
+#include <fstream>
+#include <iostream>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace LibCore
+{
+	namespace Filesystem
+	{
+		std::shared_ptr<MappedFile> MappedFile::Open(const File& file, MAP_MODE mode)
+		{
+			auto results = std::shared_ptr<MappedFile>(new MappedFile{});
+			const std::filesystem::path path{ file.FilePath().String() };
+
+			if (mode == MAP_MODE::READ)
+			{
+				std::ifstream stream{ path, std::ios::binary | std::ios::ate };
+				if (!stream.is_open())
+					return nullptr;
+
+				// a file cut short while being read keeps what was there, the decoder or hash sees the difference
+				results->copy.resize(static_cast<size_t>(stream.tellg()));
+				stream.seekg(0, std::ios::beg);
+				stream.read(reinterpret_cast<char*>(results->copy.data()), static_cast<std::streamsize>(results->copy.size()));
+				results->copy.resize(static_cast<size_t>(stream.gcount()));
+				results->size = results->copy.size();
+				results->data = results->size ? results->copy.data() : nullptr;
+				return results;
+			}
+
+#if defined(_WIN32)
+			results->fileHandle = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (results->fileHandle == INVALID_HANDLE_VALUE)
+			{
+				results->fileHandle = nullptr;
+				return nullptr;
+			}
+
+			LARGE_INTEGER fileSize;
+			if (!GetFileSizeEx(results->fileHandle, &fileSize))
+				return nullptr;
+
+			results->size = static_cast<size_t>(fileSize.QuadPart);
+			if (results->size == 0)
+				return results;	// empty files cannot be mapped, Data() stays null
+
+			results->mappingHandle = CreateFileMappingW(results->fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (!results->mappingHandle)
+				return nullptr;
+
+			results->data = MapViewOfFile(results->mappingHandle, FILE_MAP_READ, 0, 0, 0);
+			if (!results->data)
+				return nullptr;
+#else
+			const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+			if (fd < 0)
+				return nullptr;
+
+			struct stat fileStat;
+			if (fstat(fd, &fileStat) != 0)
+			{
+				close(fd);
+				return nullptr;
+			}
+
+			results->size = static_cast<size_t>(fileStat.st_size);
+			if (results->size == 0)
+			{
+				close(fd);
+				return results;	// empty files cannot be mapped, Data() stays null
+			}
+
+			void* mapping = mmap(nullptr, results->size, PROT_READ, MAP_PRIVATE, fd, 0);
+			close(fd);	// the mapping keeps its own reference to the file
+			if (mapping == MAP_FAILED)
+			{
+				std::cerr << "Failed to map " << path.string() << std::endl;
+				return nullptr;
+			}
+
+			// decoders walk the data front to back, let the kernel read ahead
+			madvise(mapping, results->size, MADV_SEQUENTIAL);
+			results->data = mapping;
+#endif
+			return results;
+		}
+
+		MappedFile::MappedFile()
+			: data{ nullptr }
+			, size{ 0 }
+#if defined(_WIN32)
+			, fileHandle{ nullptr }
+			, mappingHandle{ nullptr }
+#endif
+		{
+
+		}
+
+		MappedFile::~MappedFile()
+		{
+			if (!copy.empty())
+				return;
+
+#if defined(_WIN32)
+			if (data)
+				UnmapViewOfFile(data);
+			if (mappingHandle)
+				CloseHandle(mappingHandle);
+			if (fileHandle)
+				CloseHandle(fileHandle);
+#else
+			if (data)
+				munmap(data, size);
+#endif
+		}
+
+		const uint8_t* MappedFile::Data() const
+		{
+			return static_cast<const uint8_t*>(data);
+		}
+
+		size_t MappedFile::Size() const
+		{
+			return size;
+		}
+
+		std::span<const uint8_t> MappedFile::Bytes() const
+		{
+			return { Data(), size };
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <span>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include "File.h"
+
+namespace LibCore
+{
+	namespace Filesystem
+	{
+		// Read-only view of a whole file mapped into memory (mmap / MapViewOfFile).
+		// Nothing is read up front, pages are faulted in as the bytes are touched.
+		// With MAP_MODE::READ the view is a copy of what the file held when it was read instead.
+		class MappedFile
+		{
+		public:
+			static std::shared_ptr<MappedFile> Open(const File& file, MAP_MODE mode = MAP_MODE::MAPPED);
+			~MappedFile();
+
+			const uint8_t* Data() const;
+			size_t Size() const;
+			std::span<const uint8_t> Bytes() const;
+
+		private:
+			MappedFile();
+			MappedFile(const MappedFile&) = delete;
+			MappedFile& operator=(const MappedFile&) = delete;
+
+			void* data;
+			size_t size;
+			std::vector<uint8_t> copy;	// MAP_MODE::READ, data points into it
+#if defined(_WIN32)
+			void* fileHandle;
+			void* mappingHandle;
+#endif
+		};
+	}
+}
\ No newline at end of file
@@ -0,0 +1,111 @@
+#include "Parallel.h"
+
+#include <algorithm>
+#include <exception>
+
+namespace LibCore
+{
+	namespace Async
+	{
+		namespace
+		{
+			struct ParallelState
+			{
+				std::function<void(size_t)> runChunk;
+				size_t chunkCount = 0;
+				std::atomic<size_t> nextChunk{ 0 };
+				std::atomic<size_t> doneChunks{ 0 };
+				std::atomic<bool> failed{ false };
+				std::exception_ptr error;
+				std::mutex mutex;
+				std::condition_variable doneCond;
+
+				// Claims chunks until none are left. Only chunks claimed below chunkCount touch runChunk,
+				// and the caller does not return before all of them are done, so late helpers are harmless.
+				void Drain()
+				{
+					size_t chunk;
+					while ((chunk = nextChunk.fetch_add(1)) < chunkCount)
+					{
+						if (!failed.load(std::memory_order_relaxed))
+						{
+							try
+							{
+								runChunk(chunk);
+							}
+							catch (...)
+							{
+								std::lock_guard<std::mutex> lock{ mutex };
+								if (!error)
+									error = std::current_exception();
+								failed = true;
+							}
+						}
+
+						if (doneChunks.fetch_add(1) + 1 == chunkCount)
+						{
+							std::lock_guard<std::mutex> lock{ mutex };
+							doneCond.notify_all();
+						}
+					}
+				}
+			};
+		}
+
+		void ParallelFor(ThreadPool& pool, Range range, size_t grain, const std::function<void(const Range&)>& fn)
+		{
+			grain = std::max<size_t>(grain, 1);
+			const size_t chunkCount = (range.Size() + grain - 1) / grain;
+
+			if (chunkCount == 0)
+				return;
+
+			if (chunkCount == 1 || pool.Size() == 0)
+			{
+				fn(range);
+				return;
+			}
+
+			auto state = std::make_shared<ParallelState>();
+			state->chunkCount = chunkCount;
+			state->runChunk = [&fn, &range, grain](size_t chunk) {
+				const size_t begin = range.Begin + chunk * grain;
+				fn(Range{ begin, std::min(begin + grain, range.End) });
+			};
+
+			const size_t helpers = std::min(pool.Size(), chunkCount - 1);
+			for (size_t i = 0; i < helpers; ++i)
+				pool.Submit([state]() { state->Drain(); });
+
+			state->Drain();
+
+			{
+				std::unique_lock<std::mutex> lock{ state->mutex };
+				state->doneCond.wait(lock, [&state] { return state->doneChunks.load() == state->chunkCount; });
+			}
+
+			if (state->error)
+				std::rethrow_exception(state->error);
+		}
+
+		void ParallelForTiles(ThreadPool& pool, unsigned width, unsigned height, unsigned tileSize, const std::function<void(const Tile&)>& fn)
+		{
+			tileSize = std::max(tileSize, 1U);
+			const unsigned tilesX = (width + tileSize - 1) / tileSize;
+			const unsigned tilesY = (height + tileSize - 1) / tileSize;
+
+			ParallelFor(pool, Range{ 0, (size_t)tilesX * tilesY }, 1, [&](const Range& tiles) {
+				for (size_t i = tiles.Begin; i < tiles.End; ++i)
+				{
+					Tile tile;
+					tile.Index = i;
+					tile.X = static_cast<unsigned>(i % tilesX) * tileSize;
+					tile.Y = static_cast<unsigned>(i / tilesX) * tileSize;
+					tile.Width = std::min(tileSize, width - tile.X);
+					tile.Height = std::min(tileSize, height - tile.Y);
+					fn(tile);
+				}
+			});
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <functional>
+
+#include "ThreadPool.h"
+
+namespace LibCore
+{
+	namespace Async
+	{
+		struct Range
+		{
+			size_t Begin, End;
+			size_t Size() const { return End > Begin ? End - Begin : 0; }
+		};
+
+		struct Tile
+		{
+			size_t Index;
+			unsigned X, Y, Width, Height;
+		};
+
+		// Splits [range.Begin, range.End) into chunks of at most `grain` items and runs fn on every chunk.
+		// The calling thread works on chunks as well, so it is safe to call from inside a task of the same pool.
+		// Chunk boundaries depend only on range and grain, never on the number of threads.
+		void ParallelFor(ThreadPool& pool, Range range, size_t grain, const std::function<void(const Range&)>& fn);
+
+		// Covers a width x height image with tileSize x tileSize tiles (edge tiles are clipped) and runs fn on every tile.
+		void ParallelForTiles(ThreadPool& pool, unsigned width, unsigned height, unsigned tileSize, const std::function<void(const Tile&)>& fn);
+
+		// Maps every chunk to a partial result, then folds the partials in chunk order on the calling thread,
+		// so the result is identical from run to run regardless of scheduling.
+		template<typename T, typename MapFn, typename CombineFn>
+		T ParallelReduce(ThreadPool& pool, Range range, size_t grain, const T& identity, MapFn&& map, CombineFn&& combine)
+		{
+			grain = std::max<size_t>(grain, 1);
+			const size_t chunkCount = (range.Size() + grain - 1) / grain;
+
+			std::vector<T> partials(chunkCount, identity);
+			ParallelFor(pool, Range{ 0, chunkCount }, 1, [&](const Range& chunks) {
+				for (size_t i = chunks.Begin; i < chunks.End; ++i)
+				{
+					const size_t begin = range.Begin + i * grain;
+					partials[i] = map(Range{ begin, std::min(begin + grain, range.End) });
+				}
+			});
+
+			T results = identity;
+			for (auto& partial : partials)
+				results = combine(std::move(results), std::move(partial));
+			return results;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,215 @@
+#include "PoolMetrics.h"
+#include "ThreadPool.h"
+
+#include <bit>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+
+namespace LibCore
+{
+	namespace Async
+	{
+		static size_t BucketIndex(uint64_t micros)
+		{
+			if (micros < 2)
+				return 0;
+			return std::min<size_t>(std::bit_width(micros) - 1, LatencyHistogram::BUCKET_COUNT - 1);
+		}
+
+		LatencyHistogram::LatencyHistogram()
+			: buckets{}
+			, count{ 0 }
+			, totalMicros{ 0 }
+		{
+
+		}
+
+		void LatencyHistogram::Record(uint64_t micros)
+		{
+			++buckets[BucketIndex(micros)];
+			++count;
+			totalMicros += micros;
+		}
+
+		uint64_t LatencyHistogram::Count() const
+		{
+			return count;
+		}
+
+		double LatencyHistogram::MeanMillis() const
+		{
+			return count ? (totalMicros / 1000.0) / count : 0.0;
+		}
+
+		double LatencyHistogram::PercentileMillis(double percentile) const
+		{
+			if (count == 0)
+				return 0.0;
+
+			const uint64_t target = static_cast<uint64_t>(std::ceil(count * std::clamp(percentile, 0.0, 1.0)));
+			uint64_t accumulated = 0;
+			for (size_t i = 0; i < BUCKET_COUNT; ++i)
+			{
+				accumulated += buckets[i];
+				if (accumulated >= target)
+					return static_cast<double>(uint64_t{ 2 } << i) / 1000.0; // upper bound of the bucket
+			}
+			return static_cast<double>(uint64_t{ 1 } << BUCKET_COUNT) / 1000.0;
+		}
+
+		const std::array<uint64_t, LatencyHistogram::BUCKET_COUNT>& LatencyHistogram::Buckets() const
+		{
+			return buckets;
+		}
+
+		AtomicLatencyHistogram::AtomicLatencyHistogram()
+			: count{ 0 }
+			, totalMicros{ 0 }
+		{
+			Reset();
+		}
+
+		void AtomicLatencyHistogram::Record(uint64_t micros)
+		{
+			buckets[BucketIndex(micros)].fetch_add(1, std::memory_order_relaxed);
+			count.fetch_add(1, std::memory_order_relaxed);
+			totalMicros.fetch_add(micros, std::memory_order_relaxed);
+		}
+
+		void AtomicLatencyHistogram::Reset()
+		{
+			for (auto& bucket : buckets)
+				bucket.store(0, std::memory_order_relaxed);
+			count = 0;
+			totalMicros = 0;
+		}
+
+		LatencyHistogram AtomicLatencyHistogram::Snapshot() const
+		{
+			LatencyHistogram results;
+			for (size_t i = 0; i < buckets.size(); ++i)
+				results.buckets[i] = buckets[i].load(std::memory_order_relaxed);
+			results.count = count.load(std::memory_order_relaxed);
+			results.totalMicros = totalMicros.load(std::memory_order_relaxed);
+			return results;
+		}
+
+		std::string ThreadPoolMetrics::CSVHeader()
+		{
+			return "pool,elapsed_s,workers,queue_depth,submitted,completed,tasks_per_s,utilisation,"
+				"wait_mean_ms,wait_p95_ms,run_mean_ms,run_p95_ms,worker_busy";
+		}
+
+		std::string ThreadPoolMetrics::ToCSVRow() const
+		{
+			std::ostringstream oss;
+			oss << std::fixed << std::setprecision(3)
+				<< Name << ','
+				<< ElapsedSeconds << ','
+				<< WorkerCount << ','
+				<< QueueDepth << ','
+				<< TasksSubmitted << ','
+				<< TasksCompleted << ','
+				<< TasksPerSecond << ','
+				<< Utilisation << ','
+				<< WaitTime.MeanMillis() << ','
+				<< WaitTime.PercentileMillis(0.95) << ','
+				<< RunTime.MeanMillis() << ','
+				<< RunTime.PercentileMillis(0.95) << ',';
+
+			// per-worker ratios are packed in one column so rows stay aligned across pool sizes
+			for (size_t i = 0; i < WorkerBusyRatio.size(); ++i)
+				oss << (i ? ";" : "") << WorkerBusyRatio[i];
+
+			return oss.str();
+		}
+
+		std::string ThreadPoolMetrics::ToString() const
+		{
+			std::ostringstream oss;
+			oss << std::fixed << std::setprecision(2)
+				<< "[" << Name << "] "
+				<< WorkerCount << " workers, "
+				<< "queue " << QueueDepth << ", "
+				<< TasksCompleted << "/" << TasksSubmitted << " tasks, "
+				<< TasksPerSecond << " tasks/s, "
+				<< "busy " << Utilisation * 100.0 << "%, "
+				<< "wait " << WaitTime.MeanMillis() << "ms (p95 " << WaitTime.PercentileMillis(0.95) << "ms), "
+				<< "run " << RunTime.MeanMillis() << "ms (p95 " << RunTime.PercentileMillis(0.95) << "ms)";
+			return oss.str();
+		}
+
+		PoolMonitor::PoolMonitor(unsigned intervalMs, const std::string& csvPath)
+			: intervalMs{ std::max(intervalMs, 1U) }
+			, csvPath{ csvPath }
+			, stopFlag{ false }
+		{
+			if (!csvPath.empty())
+			{
+				std::ofstream file{ csvPath, std::ios::out | std::ios::trunc };
+				file << ThreadPoolMetrics::CSVHeader() << "\n";
+			}
+			else
+			{
+				std::cout << ThreadPoolMetrics::CSVHeader() << std::endl;
+			}
+
+			sampler = std::thread{ [this]() {
+				std::unique_lock<std::mutex> lock{ mutex };
+				while (!stopCond.wait_for(lock, std::chrono::milliseconds{ this->intervalMs }, [this] { return stopFlag; }))
+					Sample();
+			} };
+		}
+
+		PoolMonitor::~PoolMonitor()
+		{
+			Stop();
+		}
+
+		void PoolMonitor::Watch(const ThreadPool& pool)
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			pools.push_back(&pool);
+		}
+
+		void PoolMonitor::Unwatch(const ThreadPool& pool)
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			pools.erase(std::remove(pools.begin(), pools.end(), &pool), pools.end());
+		}
+
+		void PoolMonitor::Stop()
+		{
+			{
+				std::lock_guard<std::mutex> lock{ mutex };
+				stopFlag = true;
+			}
+			stopCond.notify_all();
+
+			if (sampler.joinable())
+				sampler.join();
+		}
+
+		// called with mutex held
+		void PoolMonitor::Sample()
+		{
+			std::ostringstream rows;
+			for (auto pool : pools)
+				rows << pool->GetMetrics().ToCSVRow() << "\n";
+
+			if (!csvPath.empty())
+			{
+				std::ofstream file{ csvPath, std::ios::out | std::ios::app };
+				file << rows.str();
+			}
+			else
+			{
+				std::cout << rows.str() << std::flush;
+			}
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace LibCore
+{
+	namespace Async
+	{
+		// Log2 histogram of durations in microseconds, bucket i holds samples in [2^i, 2^(i+1)).
+		class LatencyHistogram
+		{
+		public:
+			static const size_t BUCKET_COUNT = 32;
+
+			LatencyHistogram();
+			void Record(uint64_t micros);
+			uint64_t Count() const;
+			double MeanMillis() const;
+			double PercentileMillis(double percentile) const;
+			const std::array<uint64_t, BUCKET_COUNT>& Buckets() const;
+
+		private:
+			friend class AtomicLatencyHistogram;
+			std::array<uint64_t, BUCKET_COUNT> buckets;
+			uint64_t count, totalMicros;
+		};
+
+		// Lock-free variant written to by pool workers, converted with Snapshot().
+		class AtomicLatencyHistogram
+		{
+		public:
+			AtomicLatencyHistogram();
+			void Record(uint64_t micros);
+			void Reset();
+			LatencyHistogram Snapshot() const;
+
+		private:
+			std::array<std::atomic<uint64_t>, LatencyHistogram::BUCKET_COUNT> buckets;
+			std::atomic<uint64_t> count, totalMicros;
+		};
+
+		struct ThreadPoolMetrics
+		{
+			std::string Name;
+			size_t WorkerCount;
+			size_t QueueDepth;
+			uint64_t TasksSubmitted;
+			uint64_t TasksCompleted;
+			double ElapsedSeconds;
+			double TasksPerSecond;
+			double Utilisation;					// mean of WorkerBusyRatio
+			std::vector<float> WorkerBusyRatio;	// 0 ~ 1 per worker
+			LatencyHistogram WaitTime;			// enqueue -> start
+			LatencyHistogram RunTime;			// start -> end
+
+			static std::string CSVHeader();
+			std::string ToCSVRow() const;
+			std::string ToString() const;
+		};
+
+		class ThreadPool;
+
+		// Samples a set of pools at a fixed interval and appends a CSV row per pool,
+		// to the given file or to stdout when no path is given.
+		class PoolMonitor
+		{
+		public:
+			PoolMonitor(unsigned intervalMs, const std::string& csvPath = "");
+			~PoolMonitor();
+
+			void Watch(const ThreadPool& pool);
+			void Unwatch(const ThreadPool& pool);
+			void Stop();
+
+		private:
+			PoolMonitor(const PoolMonitor&) = delete;
+			PoolMonitor& operator=(const PoolMonitor&) = delete;
+			void Sample();
+
+			unsigned intervalMs;
+			std::string csvPath;
+			std::vector<const ThreadPool*> pools;
+			std::mutex mutex;
+			std::condition_variable stopCond;
+			bool stopFlag;
+			std::thread sampler;
+		};
+	}
+}
\ No newline at end of file
@@ -0,0 +1,239 @@
+#include "Process.h"
+#include "StringUtils.h"
+
+#include <cerrno>
+#include <iostream>
+#include <filesystem>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <spawn.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+extern char** environ;
+#endif
+
+#define PROCESS_READ_CHUNK 4096
+
+namespace LibCore
+{
+	namespace Utils
+	{
+		std::shared_ptr<Process> Process::Start(const std::string& executable, const std::vector<std::string>& arguments)
+		{
+			auto results = std::shared_ptr<Process>(new Process{});
+
+#if defined(_WIN32)
+			// CreateProcess takes one command line, quote everything so paths with spaces survive
+			std::wstring commandLine = L"\"" + std::filesystem::path{ executable }.wstring() + L"\"";
+			for (auto& argument : arguments)
+				commandLine += L" \"" + std::filesystem::path{ argument }.wstring() + L"\"";
+
+			SECURITY_ATTRIBUTES security{ sizeof(SECURITY_ATTRIBUTES), nullptr, TRUE };
+			HANDLE readPipe = nullptr, writePipe = nullptr;
+			if (!CreatePipe(&readPipe, &writePipe, &security, 0))
+				return nullptr;
+			SetHandleInformation(readPipe, HANDLE_FLAG_INHERIT, 0);
+
+			STARTUPINFOW startup{};
+			startup.cb = sizeof(startup);
+			startup.dwFlags = STARTF_USESTDHANDLES;
+			startup.hStdInput = GetStdHandle(STD_INPUT_HANDLE);
+			startup.hStdOutput = writePipe;
+			startup.hStdError = GetStdHandle(STD_ERROR_HANDLE);
+
+			PROCESS_INFORMATION info{};
+			const BOOL created = CreateProcessW(nullptr, commandLine.data(), nullptr, nullptr, TRUE, 0, nullptr, nullptr, &startup, &info);
+			CloseHandle(writePipe);
+			if (!created)
+			{
+				std::cerr << "Failed to start " << executable << std::endl;
+				CloseHandle(readPipe);
+				return nullptr;
+			}
+
+			CloseHandle(info.hThread);
+			results->processHandle = info.hProcess;
+			results->readHandle = readPipe;
+#else
+			int pipeHandles[2];
+			if (pipe2(pipeHandles, O_CLOEXEC) != 0)
+				return nullptr;
+
+			posix_spawn_file_actions_t actions;
+			posix_spawn_file_actions_init(&actions);
+			posix_spawn_file_actions_adddup2(&actions, pipeHandles[1], STDOUT_FILENO);
+
+			std::vector<char*> argv;
+			argv.push_back(const_cast<char*>(executable.c_str()));
+			for (auto& argument : arguments)
+				argv.push_back(const_cast<char*>(argument.c_str()));
+			argv.push_back(nullptr);
+
+			pid_t processId = -1;
+			const int error = posix_spawn(&processId, executable.c_str(), &actions, nullptr, argv.data(), environ);
+			posix_spawn_file_actions_destroy(&actions);
+			close(pipeHandles[1]);
+			if (error != 0)
+			{
+				std::cerr << "Failed to start " << executable << std::endl;
+				close(pipeHandles[0]);
+				return nullptr;
+			}
+
+			results->processId = processId;
+			results->readHandle = pipeHandles[0];
+#endif
+			results->running = true;
+			results->reader = std::thread{ [process = results.get()]() { process->ReadLoop(); } };
+			return results;
+		}
+
+		Process::Process()
+#if defined(_WIN32)
+			: processHandle{ nullptr }
+			, readHandle{ nullptr }
+#else
+			: processId{ -1 }
+			, readHandle{ -1 }
+#endif
+			, running{ false }
+			, exitCode{ -1 }
+		{
+
+		}
+
+		Process::~Process()
+		{
+			Kill();
+			if (reader.joinable())
+				reader.join();
+
+#if defined(_WIN32)
+			if (readHandle)
+				CloseHandle(readHandle);
+			if (processHandle)
+				CloseHandle(processHandle);
+#else
+			if (readHandle >= 0)
+				close(readHandle);
+#endif
+		}
+
+		std::vector<std::string> Process::TakeLines()
+		{
+			std::vector<std::string> results;
+			std::lock_guard<std::mutex> lock{ mutex };
+			std::swap(results, lines);
+			return results;
+		}
+
+		bool Process::Running() const
+		{
+			return running;
+		}
+
+		int Process::ExitCode() const
+		{
+			return exitCode;
+		}
+
+		void Process::Kill()
+		{
+			// under the mutex so a reaped process id is never signalled
+			std::lock_guard<std::mutex> lock{ mutex };
+			if (!running)
+				return;
+#if defined(_WIN32)
+			TerminateProcess(processHandle, 1);
+#else
+			kill(processId, SIGKILL);
+#endif
+		}
+
+		void Process::ReadLoop()
+		{
+			std::string partial;
+			char buffer[PROCESS_READ_CHUNK];
+			for (;;)
+			{
+#if defined(_WIN32)
+				DWORD length = 0;
+				if (!ReadFile(readHandle, buffer, sizeof(buffer), &length, nullptr) || length == 0)
+					break;
+#else
+				const ssize_t length = read(readHandle, buffer, sizeof(buffer));
+				if (length < 0 && errno == EINTR)
+					continue;
+				if (length <= 0)
+					break;
+#endif
+				partial.append(buffer, static_cast<size_t>(length));
+
+				std::vector<std::string> complete;
+				size_t begin = 0;
+				for (size_t end = partial.find('\n'); end != std::string::npos; begin = end + 1, end = partial.find('\n', begin))
+				{
+					const size_t lineEnd = end > begin && partial[end - 1] == '\r' ? end - 1 : end;
+					complete.push_back(partial.substr(begin, lineEnd - begin));
+				}
+				partial.erase(0, begin);
+
+				if (!complete.empty())
+				{
+					std::lock_guard<std::mutex> lock{ mutex };
+					lines.insert(lines.end(), std::make_move_iterator(complete.begin()), std::make_move_iterator(complete.end()));
+				}
+			}
+
+			if (!partial.empty())
+			{
+				std::lock_guard<std::mutex> lock{ mutex };
+				lines.push_back(std::move(partial));
+			}
+			Wait();
+		}
+
+		void Process::Wait()
+		{
+#if defined(_WIN32)
+			WaitForSingleObject(processHandle, INFINITE);
+			DWORD code = 0;
+			GetExitCodeProcess(processHandle, &code);
+			std::lock_guard<std::mutex> lock{ mutex };
+			exitCode = static_cast<int>(code);
+			running = false;
+#else
+			// wait without reaping first, the id stays reserved until Kill() can no longer use it
+			siginfo_t info{};
+			while (waitid(P_PID, processId, &info, WEXITED | WNOWAIT) < 0 && errno == EINTR) {}
+
+			std::lock_guard<std::mutex> lock{ mutex };
+			int status = 0;
+			while (waitpid(processId, &status, 0) < 0 && errno == EINTR) {}
+			exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+			running = false;
+#endif
+		}
+
+		std::string Process::CurrentExecutable()
+		{
+#if defined(_WIN32)
+			std::wstring path(MAX_PATH, L'\0');
+			DWORD length = 0;
+			while ((length = GetModuleFileNameW(nullptr, path.data(), static_cast<DWORD>(path.size()))) == path.size())
+				path.resize(path.size() * 2);
+			path.resize(length);
+			return String::WStringToString(path);
+#else
+			std::error_code ec;
+			return std::filesystem::read_symlink("/proc/self/exe", ec).string();
+#endif
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+
+namespace LibCore
+{
+	namespace Utils
+	{
+		// A child process whose stdout is read line by line on a reader thread, stderr and stdin are inherited.
+		// Used as a one-way channel: the child reports, the parent polls TakeLines().
+		class Process
+		{
+		public:
+			static std::shared_ptr<Process> Start(const std::string& executable, const std::vector<std::string>& arguments);
+			~Process();	// kills the child if it is still running
+
+			std::vector<std::string> TakeLines();
+			// false once the child closed its stdout and has exited, its lines may still be waiting in TakeLines()
+			bool Running() const;
+			int ExitCode() const;	// valid once Running() is false, a killed or crashed child never reports 0
+			void Kill();
+
+			static std::string CurrentExecutable();
+
+		private:
+			Process();
+			Process(const Process&) = delete;
+			Process& operator=(const Process&) = delete;
+
+			void ReadLoop();
+			void Wait();
+
+#if defined(_WIN32)
+			void* processHandle;
+			void* readHandle;
+#else
+			int processId;
+			int readHandle;
+#endif
+			std::mutex mutex;
+			std::vector<std::string> lines;
+			std::atomic<bool> running;
+			std::atomic<int> exitCode;
+			std::thread reader;
+		};
+	}
+}
\ No newline at end of file
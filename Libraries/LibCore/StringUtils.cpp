@@ -1,7 +1,11 @@
 #include "StringUtils.h"
 #include <locale>
 #include <codecvt>
+#include <cstdint>
+
+#if defined(_WIN32)
 #include <windows.h>
+#endif
 
 namespace LibCore
 {
@@ -17,10 +21,40 @@ namespace LibCore
 		std::string String::WStringToString(const std::wstring& wstr)
 		{
 			if (wstr.empty()) return {};
+#if defined(_WIN32)
 			int sizeNeeded = WideCharToMultiByte(CP_UTF8, 0, wstr.data(), (int)wstr.size(), NULL, 0, NULL, NULL);
 			std::string result(sizeNeeded, 0);
 			WideCharToMultiByte(CP_UTF8, 0, wstr.data(), (int)wstr.size(), result.data(), sizeNeeded, NULL, NULL);
 			return result;
+#else
+			// wchar_t holds UTF-32 everywhere else
+			std::string result;
+			for (wchar_t c : wstr)
+			{
+				const auto code = static_cast<uint32_t>(c);
+				if (code < 0x80)
+					result += static_cast<char>(code);
+				else if (code < 0x800)
+				{
+					result += static_cast<char>(0xC0 | (code >> 6));
+					result += static_cast<char>(0x80 | (code & 0x3F));
+				}
+				else if (code < 0x10000)
+				{
+					result += static_cast<char>(0xE0 | (code >> 12));
+					result += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+					result += static_cast<char>(0x80 | (code & 0x3F));
+				}
+				else
+				{
+					result += static_cast<char>(0xF0 | (code >> 18));
+					result += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+					result += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+					result += static_cast<char>(0x80 | (code & 0x3F));
+				}
+			}
+			return result;
+#endif
 		}
 	}
 }
\ No newline at end of file
@@ -0,0 +1,203 @@
+#pragma once
+
+#include <atomic>
+#include <optional>
+#include <coroutine>
+#include <exception>
+#include <stdexcept>
+
+#include "Future.h"
+#include "ThreadPool.h"
+
+namespace LibCore
+{
+	namespace Async
+	{
+		template<typename T>
+		class Task;
+
+		namespace Detail
+		{
+			enum TaskState : int
+			{
+				RUNNING = 0,
+				AWAITED,	// a continuation is waiting for the result
+				DONE
+			};
+
+			struct TaskPromiseBase
+			{
+				std::atomic<int> state{ RUNNING };
+				std::coroutine_handle<> continuation;
+				std::exception_ptr error;
+
+				struct FinalAwaiter
+				{
+					bool await_ready() const noexcept { return false; }
+					void await_resume() const noexcept {}
+
+					template<typename Promise>
+					std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+					{
+						auto& promise = handle.promise();
+						if (promise.state.exchange(DONE, std::memory_order_acq_rel) == AWAITED)
+							return promise.continuation;
+						return std::noop_coroutine();
+					}
+				};
+
+				// tasks start running straight away on the thread that created them
+				std::suspend_never initial_suspend() const noexcept { return {}; }
+				FinalAwaiter final_suspend() const noexcept { return {}; }
+				void unhandled_exception() { error = std::current_exception(); }
+			};
+
+			template<typename T>
+			struct TaskPromise : TaskPromiseBase
+			{
+				std::optional<T> value;
+				Task<T> get_return_object();
+				void return_value(T result) { value.emplace(std::move(result)); }
+			};
+
+			template<>
+			struct TaskPromise<void> : TaskPromiseBase
+			{
+				Task<void> get_return_object();
+				void return_void() {}
+			};
+		}
+
+		// Eagerly started coroutine. The owner must keep the Task alive until IsReady(),
+		// since a suspended task may be resumed by any executor it scheduled itself on.
+		template<typename T = void>
+		class Task
+		{
+		public:
+			using promise_type = Detail::TaskPromise<T>;
+
+			Task() : handle{ nullptr } {}
+			explicit Task(std::coroutine_handle<promise_type> h) : handle{ h } {}
+			Task(const Task&) = delete;
+			Task& operator=(const Task&) = delete;
+			Task(Task&& rhs) noexcept : handle{ rhs.handle } { rhs.handle = nullptr; }
+			Task& operator=(Task&& rhs) noexcept
+			{
+				std::swap(handle, rhs.handle);
+				return *this;
+			}
+
+			~Task()
+			{
+				if (handle)
+					handle.destroy();
+			}
+
+			bool Valid() const { return handle != nullptr; }
+			bool IsReady() const { return Valid() && handle.promise().state.load(std::memory_order_acquire) == Detail::DONE; }
+
+			// Only valid once IsReady() returns true
+			T Get()
+			{
+				if (!IsReady())
+					throw std::logic_error("Task not completed");
+
+				auto& promise = handle.promise();
+				if (promise.error)
+					std::rethrow_exception(promise.error);
+
+				if constexpr (!std::is_void_v<T>)
+					return std::move(*promise.value);
+			}
+
+			auto operator co_await() noexcept
+			{
+				struct Awaiter
+				{
+					std::coroutine_handle<promise_type> handle;
+
+					bool await_ready() const noexcept
+					{
+						return handle.promise().state.load(std::memory_order_acquire) == Detail::DONE;
+					}
+
+					bool await_suspend(std::coroutine_handle<> awaiting) noexcept
+					{
+						auto& promise = handle.promise();
+						promise.continuation = awaiting;
+						int expected = Detail::RUNNING;
+						// fails only if the task finished in the meantime, in which case we carry on
+						return promise.state.compare_exchange_strong(expected, Detail::AWAITED, std::memory_order_acq_rel);
+					}
+
+					T await_resume()
+					{
+						auto& promise = handle.promise();
+						if (promise.error)
+							std::rethrow_exception(promise.error);
+
+						if constexpr (!std::is_void_v<T>)
+							return std::move(*promise.value);
+					}
+				};
+				return Awaiter{ handle };
+			}
+
+		private:
+			std::coroutine_handle<promise_type> handle;
+		};
+
+		template<typename T>
+		Task<T> Detail::TaskPromise<T>::get_return_object()
+		{
+			return Task<T>{ std::coroutine_handle<TaskPromise<T>>::from_promise(*this) };
+		}
+
+		inline Task<void> Detail::TaskPromise<void>::get_return_object()
+		{
+			return Task<void>{ std::coroutine_handle<TaskPromise<void>>::from_promise(*this) };
+		}
+
+		// co_await ScheduleOn(executor) resumes the coroutine on one of the executor's threads
+		inline auto ScheduleOn(Executor& executor)
+		{
+			struct Awaiter
+			{
+				Executor& executor;
+				bool await_ready() const noexcept { return false; }
+				void await_suspend(std::coroutine_handle<> handle) { executor.Submit([handle]() { handle.resume(); }); }
+				void await_resume() const noexcept {}
+			};
+			return Awaiter{ executor };
+		}
+
+		// co_await Await(future, poller) suspends until the future is ready. Readiness is re-checked
+		// by posting to the poller, which should be an executor that is drained regularly (e.g. once per frame).
+		template<typename T>
+		auto Await(Future<T>&& future, Executor& poller)
+		{
+			struct Awaiter
+			{
+				Future<T> future;
+				Executor& poller;
+				std::coroutine_handle<> handle;
+
+				bool await_ready() const { return future.IsReady(); }
+				void await_suspend(std::coroutine_handle<> h)
+				{
+					handle = h;
+					Poll();
+				}
+				T await_resume() { return future.Get(); }
+
+				void Poll()
+				{
+					poller.Submit([this]() {
+						future.IsReady() ? handle.resume() : Poll();
+					});
+				}
+			};
+			return Awaiter{ std::move(future), poller, nullptr };
+		}
+	}
+}
\ No newline at end of file
@@ -7,9 +7,14 @@
 #include <queue>
 #include <vector>
 #include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <memory>
+#include <string>
 
 #include "Future.h"
 #include "CancelToken.h"
+#include "PoolMetrics.h"
 
 namespace LibCore
 {
@@ -26,13 +31,12 @@ namespace LibCore
         public:
             explicit ThreadPool(size_t threadCount = std::thread::hardware_concurrency())
                 : stopFlag(false)
+                , activeWorkers(0)
+                , tasksSubmitted(0)
+                , tasksCompleted(0)
+                , metricsStartMicros(NowMicros())
             {
-                for (size_t i = 0; i < threadCount; ++i) 
-                {
-                    workers.emplace_back([this] {
-                        WorkerLoop();
-                    });
-                }
+                Resize(threadCount);
             }
 
             ~ThreadPool() override 
@@ -44,8 +48,9 @@ namespace LibCore
             {
                 {
                     std::unique_lock<std::mutex> lock(queueMutex);
-                    tasks.push(std::move(task));
+                    tasks.push(QueuedTask{ std::move(task), NowMicros() });
                 }
+                tasksSubmitted.fetch_add(1, std::memory_order_relaxed);
                 queueCond.notify_one();
             }
 
@@ -116,7 +121,9 @@ namespace LibCore
                     stopFlag = true;
                 }
                 queueCond.notify_all();
+                parkedCond.notify_all();
 
+                std::unique_lock<std::mutex> lock{ workersMutex };
                 for (auto& t : workers) 
                 {
                     if (t.joinable()) 
@@ -124,26 +131,166 @@ namespace LibCore
                 }
             }
 
+            size_t Size() const
+            {
+                std::unique_lock<std::mutex> lock{ queueMutex };
+                return activeWorkers;
+            }
+
+            // Changes the number of workers taking tasks. Surplus threads are parked rather than joined,
+            // so shrinking never waits on a running task and growing again reuses them.
+            void Resize(size_t threadCount)
+            {
+                threadCount = std::max<size_t>(threadCount, 1);
+
+                std::unique_lock<std::mutex> workersLock{ workersMutex };
+                for (size_t i = workers.size(); i < threadCount; ++i)
+                {
+                    workerStats.emplace_back(std::make_unique<WorkerStats>());
+                    workers.emplace_back([this, i, stats = workerStats.back().get()] {
+                        WorkerLoop(i, *stats);
+                    });
+                }
+
+                {
+                    std::unique_lock<std::mutex> lock{ queueMutex };
+                    activeWorkers = threadCount;
+                }
+                // workers now past the count move over to parkedCond, unparked ones go back to queueCond
+                queueCond.notify_all();
+                parkedCond.notify_all();
+            }
+
+            void SetName(const std::string& poolName)
+            {
+                name = poolName;
+            }
+
+            const std::string& GetName() const
+            {
+                return name;
+            }
+
+            ThreadPoolMetrics GetMetrics() const
+            {
+                ThreadPoolMetrics metrics;
+                metrics.Name = name;
+                {
+                    std::unique_lock<std::mutex> lock{ queueMutex };
+                    metrics.WorkerCount = activeWorkers;
+                    metrics.QueueDepth = tasks.size();
+                }
+                metrics.TasksSubmitted = tasksSubmitted.load(std::memory_order_relaxed);
+                metrics.TasksCompleted = tasksCompleted.load(std::memory_order_relaxed);
+
+                const uint64_t now = NowMicros();
+                const uint64_t start = metricsStartMicros.load(std::memory_order_relaxed);
+                metrics.ElapsedSeconds = std::max<uint64_t>(now - start, 1) / 1e6;
+                metrics.TasksPerSecond = metrics.TasksCompleted / metrics.ElapsedSeconds;
+
+                metrics.Utilisation = 0.0;
+                std::unique_lock<std::mutex> workersLock{ workersMutex };
+                for (size_t i = 0; i < std::min(metrics.WorkerCount, workerStats.size()); ++i)
+                {
+                    auto& stats = workerStats[i];
+                    // count the task in flight as well, otherwise long tasks only show up once they finish
+                    uint64_t busy = stats->busyMicros.load(std::memory_order_relaxed);
+                    const uint64_t runStart = stats->runStartMicros.load(std::memory_order_relaxed);
+                    if (runStart != 0)
+                        busy += now - std::max(runStart, start);
+
+                    const float ratio = std::min(1.0f, static_cast<float>(busy / (metrics.ElapsedSeconds * 1e6)));
+                    metrics.WorkerBusyRatio.push_back(ratio);
+                    metrics.Utilisation += ratio;
+                }
+                metrics.Utilisation /= std::max<size_t>(metrics.WorkerBusyRatio.size(), 1);
+
+                metrics.WaitTime = waitTime.Snapshot();
+                metrics.RunTime = runTime.Snapshot();
+                return metrics;
+            }
+
+            void ResetMetrics()
+            {
+                tasksSubmitted = 0;
+                tasksCompleted = 0;
+                waitTime.Reset();
+                runTime.Reset();
+                std::unique_lock<std::mutex> workersLock{ workersMutex };
+                for (auto& stats : workerStats)
+                    stats->busyMicros = 0;
+                metricsStartMicros = NowMicros();
+            }
+
         private:
+            struct QueuedTask
+            {
+                std::function<void()> Func;
+                uint64_t EnqueueMicros;
+            };
+
+            struct WorkerStats
+            {
+                std::atomic<uint64_t> busyMicros{ 0 };
+                std::atomic<uint64_t> runStartMicros{ 0 };	// 0 while idle
+            };
+
+            std::string name;
             std::vector<std::thread> workers;
-            std::queue<std::function<void()>> tasks;
-            std::mutex queueMutex;
+            std::vector<std::unique_ptr<WorkerStats>> workerStats;
+            mutable std::mutex workersMutex;	// guards the two vectors above
+            std::queue<QueuedTask> tasks;
+            mutable std::mutex queueMutex;
             std::condition_variable queueCond;
+            // parked workers wait apart, a notify_one from Submit must always reach a worker that can take the task
+            std::condition_variable parkedCond;
             std::atomic<bool> stopFlag;
+            size_t activeWorkers;	// workers with index >= this are parked, guarded by queueMutex
+
+            std::atomic<uint64_t> tasksSubmitted, tasksCompleted;
+            std::atomic<uint64_t> metricsStartMicros;
+            AtomicLatencyHistogram waitTime, runTime;
+
+            static uint64_t NowMicros()
+            {
+                return std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+            }
 
-            void WorkerLoop() 
+            void WorkerLoop(size_t index, WorkerStats& stats) 
             {
                 while (true) 
                 {
-                    std::function<void()> task;
+                    QueuedTask task;
                     {
                         std::unique_lock<std::mutex> lock{ queueMutex };
-                        queueCond.wait(lock, [&] { return stopFlag || !tasks.empty(); });
-                        if (stopFlag && tasks.empty()) return;
+                        while (!stopFlag)
+                        {
+                            if (index >= activeWorkers)
+                                parkedCond.wait(lock, [&] { return stopFlag || index < activeWorkers; });
+                            else if (tasks.empty())
+                                queueCond.wait(lock, [&] { return stopFlag || index >= activeWorkers || !tasks.empty(); });
+                            else
+                                break;
+                        }
+                        // parked workers still help drain the queue on shutdown
+                        if (tasks.empty()) return;
                         task = std::move(tasks.front());
                         tasks.pop();
                     }
-                    task();
+
+                    const uint64_t runStart = NowMicros();
+                    stats.runStartMicros.store(runStart, std::memory_order_relaxed);
+                    waitTime.Record(runStart - task.EnqueueMicros);
+
+                    task.Func();
+
+                    const uint64_t runEnd = NowMicros();
+                    const uint64_t start = metricsStartMicros.load(std::memory_order_relaxed);
+                    stats.busyMicros.fetch_add(runEnd - std::max(runStart, start), std::memory_order_relaxed);
+                    stats.runStartMicros.store(0, std::memory_order_relaxed);
+                    runTime.Record(runEnd - runStart);
+                    tasksCompleted.fetch_add(1, std::memory_order_relaxed);
                 }
             }
         };
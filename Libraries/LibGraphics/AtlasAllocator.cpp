@@ -0,0 +1,92 @@
+#include "AtlasAllocator.h"
+
+#include <algorithm>
+
+namespace LibGraphics
+{
+	AtlasAllocator::AtlasAllocator(int width, int height, int alignment)
+		: width{ width }
+		, height{ height }
+		, alignment{ std::max(1, alignment) }
+		, top{ 0 }
+		, allocations{ 0 }
+	{
+
+	}
+
+	bool AtlasAllocator::Allocate(int rectWidth, int rectHeight, Rect& rect)
+	{
+		const int alignedWidth = (rectWidth + alignment - 1) / alignment * alignment;
+		const int alignedHeight = (rectHeight + alignment - 1) / alignment * alignment;
+		if (rectWidth <= 0 || rectHeight <= 0 || alignedWidth > width || alignedHeight > height)
+			return false;
+
+		// the shortest shelf it fits in wastes the least height
+		Shelf* best = nullptr;
+		std::vector<Span>::iterator bestSpan;
+		for (auto& shelf : shelves)
+		{
+			if (shelf.Height < alignedHeight || (best && shelf.Height >= best->Height))
+				continue;
+
+			auto span = std::find_if(shelf.FreeSpans.begin(), shelf.FreeSpans.end(), [alignedWidth](const Span& span) { return span.Width >= alignedWidth; });
+			if (span != shelf.FreeSpans.end())
+			{
+				best = &shelf;
+				bestSpan = span;
+			}
+		}
+
+		if (!best)
+		{
+			if (top + alignedHeight > height)
+				return false;
+
+			shelves.push_back(Shelf{ top, alignedHeight, { Span{ 0, width } } });
+			top += alignedHeight;
+			best = &shelves.back();
+			bestSpan = best->FreeSpans.begin();
+		}
+
+		rect = Rect{ bestSpan->X, best->Y, alignedWidth, alignedHeight };
+		bestSpan->X += alignedWidth;
+		bestSpan->Width -= alignedWidth;
+		if (bestSpan->Width == 0)
+			best->FreeSpans.erase(bestSpan);
+
+		++allocations;
+		return true;
+	}
+
+	void AtlasAllocator::Free(const Rect& rect)
+	{
+		auto shelf = std::find_if(shelves.begin(), shelves.end(), [&rect](const Shelf& shelf) { return shelf.Y == rect.Y; });
+		if (shelf == shelves.end() || allocations == 0)
+			return;
+
+		// back in X order, joined with the spans it touches
+		auto& spans = shelf->FreeSpans;
+		auto next = std::find_if(spans.begin(), spans.end(), [&rect](const Span& span) { return span.X > rect.X; });
+		next = spans.insert(next, Span{ rect.X, rect.Width });
+		if (next + 1 != spans.end() && next->X + next->Width == (next + 1)->X)
+		{
+			next->Width += (next + 1)->Width;
+			spans.erase(next + 1);
+		}
+		if (next != spans.begin() && (next - 1)->X + (next - 1)->Width == next->X)
+		{
+			(next - 1)->Width += next->Width;
+			spans.erase(next);
+		}
+		--allocations;
+
+		// empty shelves at the end can open again at another height
+		while (!shelves.empty()
+			&& shelves.back().FreeSpans.size() == 1
+			&& shelves.back().FreeSpans.front().Width == width)
+		{
+			top = shelves.back().Y;
+			shelves.pop_back();
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+namespace LibGraphics
+{
+	// Shelf packer for the rectangles of a TextureAtlas page. Rows (shelves) are opened from row 0 on, as tall as
+	// the first rectangle put in them, freed spans go back to their shelf's free list and are merged with
+	// their neighbours, and the last shelves are given back once empty. No GL.
+	class AtlasAllocator
+	{
+	public:
+		struct Rect
+		{
+			int X = 0, Y = 0, Width = 0, Height = 0;
+		};
+
+		AtlasAllocator(int width, int height, int alignment);
+
+		// sizes and positions are rounded up to the alignment; false if no free space fits
+		bool Allocate(int width, int height, Rect& rect);
+		// rect as returned by Allocate
+		void Free(const Rect& rect);
+		bool Empty() const { return allocations == 0; }
+
+	private:
+		struct Span
+		{
+			int X, Width;
+		};
+
+		struct Shelf
+		{
+			int Y, Height;
+			std::vector<Span> FreeSpans;	// sorted by X, never adjacent
+		};
+
+		int width, height, alignment;
+		int top;		// first row above the last shelf
+		size_t allocations;
+		std::vector<Shelf> shelves;	// sorted by Y
+	};
+}
\ No newline at end of file
@@ -0,0 +1,86 @@
+#pragma once
+
+namespace LibGraphics
+{
+    // Pyramid filters, TextureFilter recognises these source lists and drives the passes itself
+    // (downsample, blur or accumulate, upsample), so their cost does not grow with the radius.
+
+    // { SEPARABLE_GAUSSIAN_BLUR_SHADER, SEPARABLE_GAUSSIAN_BLUR_SHADER, BLUR_RESAMPLE_SHADER }
+    static const char* SEPARABLE_GAUSSIAN_BLUR_SHADER = R"(
+        in vec2 TexCoord;
+        uniform sampler2D texture1;
+        uniform float uBlurRadius = 2.0; // Standard deviation in texels
+        uniform int _PassIndex_;         // Even passes blur horizontally, odd passes vertically
+        out vec4 FragColor;
+
+        void main() {
+            vec2 direction = (_PassIndex_ % 2 == 0 ? vec2(1.0, 0.0) : vec2(0.0, 1.0)) / vec2(textureSize(texture1, 0));
+            float sigma = max(uBlurRadius, 0.001);
+
+            vec3 color = texture(texture1, TexCoord).rgb;
+            float total = 1.0;
+            for (int i = 1; i <= 12; ++i) {
+                float weight = exp(-0.5 * float(i * i) / (sigma * sigma));
+                color += (texture(texture1, TexCoord + direction * float(i)).rgb + texture(texture1, TexCoord - direction * float(i)).rgb) * weight;
+                total += 2.0 * weight;
+            }
+
+            FragColor = vec4(color / total, 1.0);
+        }
+    )";
+
+    // Rendered into a target half the size it averages 2x2 texels, into a larger one it interpolates
+    static const char* BLUR_RESAMPLE_SHADER = R"(
+        in vec2 TexCoord;
+        uniform sampler2D texture1;
+        out vec4 FragColor;
+
+        void main() {
+            FragColor = vec4(texture(texture1, TexCoord).rgb, 1.0);
+        }
+    )";
+
+    // { BLOOM_BRIGHT_PASS_SHADER, BLUR_RESAMPLE_SHADER, BLOOM_UPSAMPLE_SHADER, BLOOM_COMPOSITE_SHADER }
+    static const char* BLOOM_BRIGHT_PASS_SHADER = R"(
+        in vec2 TexCoord;
+        uniform sampler2D texture1;
+        uniform float uThreshold = 0.6; // Brightness that starts to glow
+        out vec4 FragColor;
+
+        void main() {
+            FragColor = vec4(max(texture(texture1, TexCoord).rgb - vec3(uThreshold), 0.0), 1.0);
+        }
+    )";
+
+    static const char* BLOOM_UPSAMPLE_SHADER = R"(
+        in vec2 TexCoord;
+        uniform sampler2D texture1;         // Bright pass at this level
+        uniform sampler2D texture2;         // Glow accumulated from the coarser levels
+        uniform float uBloomSpread = 0.6;   // Share of the wider glow of the coarser levels
+        uniform int uBloomLevels = 5;       // Pyramid levels below the image, read by TextureFilter
+        out vec4 FragColor;
+
+        void main() {
+            // 3x3 tent out of four bilinear taps
+            vec2 texel = 0.5 / vec2(textureSize(texture2, 0));
+            vec3 coarse = (texture(texture2, TexCoord + vec2(-texel.x, -texel.y)).rgb +
+                           texture(texture2, TexCoord + vec2( texel.x, -texel.y)).rgb +
+                           texture(texture2, TexCoord + vec2(-texel.x,  texel.y)).rgb +
+                           texture(texture2, TexCoord + vec2( texel.x,  texel.y)).rgb) * 0.25;
+
+            FragColor = vec4(mix(texture(texture1, TexCoord).rgb, coarse, uBloomSpread), 1.0);
+        }
+    )";
+
+    static const char* BLOOM_COMPOSITE_SHADER = R"(
+        in vec2 TexCoord;
+        uniform sampler2D texture1;         // Image
+        uniform sampler2D texture2;         // Glow
+        uniform float uBloomIntensity = 1.0;
+        out vec4 FragColor;
+
+        void main() {
+            FragColor = vec4(texture(texture1, TexCoord).rgb + texture(texture2, TexCoord).rgb * uBloomIntensity, 1.0);
+        }
+    )";
+}
\ No newline at end of file
@@ -0,0 +1,160 @@
+#include "CannyCompute.h"
+#include "CannyShaders.h"
+#include "GPUMemory.h"
+#include "GL/glew.h"
+
+#include <iostream>
+
+#define CANNY_COMPUTE_TILE 16				// local size of the gradient and resolve shaders
+#define CANNY_WORKLIST_HEADER 4				// dispatch x, y, z and the count before the texels
+#define CANNY_HYSTERESIS_CHECK_STEPS 4		// steps queued between reads of the worklist count
+
+namespace LibGraphics
+{
+	namespace
+	{
+		std::shared_ptr<Shader> CreateComputeShader(const char* source)
+		{
+			auto results = std::make_shared<Shader>();
+			results->AddShaderFromString(source, Shader::TYPE::COMPUTE);
+			return results->GenShaderProgram() ? results : nullptr;
+		}
+
+		// an empty list dispatches no groups
+		void ResetWorklist(unsigned int worklist)
+		{
+			const GLuint header[CANNY_WORKLIST_HEADER] = { 0, 1, 1, 0 };
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, worklist);
+			glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(header), header);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		}
+	}
+
+	std::shared_ptr<CannyCompute> CannyCompute::Create()
+	{
+		auto results = std::shared_ptr<CannyCompute>{ new CannyCompute{} };
+		results->gradientShader = CreateComputeShader(CANNY_COMPUTE_GRADIENT_SHADER);
+		results->hysteresisShader = CreateComputeShader(CANNY_COMPUTE_HYSTERESIS_SHADER);
+		results->resolveShader = CreateComputeShader(CANNY_COMPUTE_RESOLVE_SHADER);
+		if (!results->gradientShader || !results->hysteresisShader || !results->resolveShader)
+		{
+			std::cout << "Canny compute shaders failed to build" << std::endl;
+			return nullptr;
+		}
+
+		glGenBuffers(2, results->worklists);
+		return results;
+	}
+
+	CannyCompute::~CannyCompute()
+	{
+		glDeleteTextures(1, &labels);
+		glDeleteBuffers(2, worklists);
+		GPUMemory::Release(GPUMemory::CATEGORY::COMPUTE, accountedBytes);
+	}
+
+	std::shared_ptr<Texture> CannyCompute::Apply(const std::shared_ptr<Texture>& texture, float lowThreshold, float highThreshold)
+	{
+		Resize(texture->GetWidth(), texture->GetHeight());
+		const GLuint groupsX = (width + CANNY_COMPUTE_TILE - 1) / CANNY_COMPUTE_TILE;
+		const GLuint groupsY = (height + CANNY_COMPUTE_TILE - 1) / CANNY_COMPUTE_TILE;
+
+		std::shared_ptr<Texture> results{ new Texture{} };
+		results->format = Texture::FORMAT::RGBA32;
+		results->width = width;
+		results->height = height;
+		glGenTextures(1, &results->texHandler);
+		glBindTexture(GL_TEXTURE_2D, results->texHandler);
+		glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, width, height);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		results->Account(false);
+
+		// blur, gradient, suppression and thresholds in one pass, the strong edges make the first list
+		ResetWorklist(worklists[0]);
+		gradientShader->UseProgram();
+		gradientShader->SetFloat("uEdgeThresholdLow", lowThreshold);
+		gradientShader->SetFloat("uEdgeThresholdHigh", highThreshold);
+		texture->Bind();
+		glBindImageTexture(0, labels, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32UI);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, worklists[0]);
+		glDispatchCompute(groupsX, groupsY, 1);
+
+		// every step dispatches as many groups as the last one listed texels, reading the count back stalls
+		// the pipeline so only every few steps; steps past the end dispatch nothing
+		hysteresisShader->UseProgram();
+		glBindImageTexture(0, labels, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32UI);
+		int current = 0;
+		for (int step = 1;; ++step)
+		{
+			glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_COMMAND_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+			ResetWorklist(worklists[current ^ 1]);
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, worklists[current]);
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, worklists[current ^ 1]);
+			glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, worklists[current]);
+			glDispatchComputeIndirect(0);
+			current ^= 1;
+
+			if (step % CANNY_HYSTERESIS_CHECK_STEPS != 0)
+				continue;
+
+			GLuint count = 0;
+			glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, worklists[current]);
+			glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 3 * sizeof(GLuint), sizeof(count), &count);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+			if (count == 0)
+				break;
+		}
+		glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+
+		glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+		resolveShader->UseProgram();
+		glBindImageTexture(0, labels, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R32UI);
+		glBindImageTexture(1, results->texHandler, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+		glDispatchCompute(groupsX, groupsY, 1);
+
+		// sampled by the next filter, copied or read back
+		glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT);
+		return results;
+	}
+
+	void CannyCompute::Resize(int newWidth, int newHeight)
+	{
+		if (labels != 0 && newWidth == width && newHeight == height)
+			return;
+
+		width = newWidth;
+		height = newHeight;
+
+		glDeleteTextures(1, &labels);
+		glGenTextures(1, &labels);
+		glBindTexture(GL_TEXTURE_2D, labels);
+		glTexStorage2D(GL_TEXTURE_2D, 1, GL_R32UI, width, height);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		// a texel turns strong once, so no list holds more than every texel
+		const GLsizeiptr size = (CANNY_WORKLIST_HEADER + static_cast<GLsizeiptr>(width) * height) * sizeof(GLuint);
+		for (auto worklist : worklists)
+		{
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, worklist);
+			glBufferData(GL_SHADER_STORAGE_BUFFER, size, nullptr, GL_DYNAMIC_COPY);
+		}
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+		GPUMemory::Release(GPUMemory::CATEGORY::COMPUTE, accountedBytes);
+		accountedBytes = GPUMemory::TextureBytes(width, height, 4.0, false) + 2 * static_cast<int64_t>(size);
+		GPUMemory::Allocate(GPUMemory::CATEGORY::COMPUTE, accountedBytes);
+	}
+
+	CannyCompute::CannyCompute()
+		: width{ 0 }
+		, height{ 0 }
+		, labels{ 0 }
+		, worklists{ 0, 0 }
+		, accountedBytes{ 0 }
+	{
+
+	}
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <memory>
+#include <cstdint>
+
+#include "Shader.h"
+#include "Texture.h"
+
+namespace LibGraphics
+{
+	// Canny edge detection with the compute shaders of CannyShaders.h: one dispatch blurs, takes the gradient,
+	// thins it and classifies the texels, hysteresis then grows the strong edges one worklist step at a time
+	// until no weak edge is left next to one, and a last dispatch writes the edges out. GL thread only.
+	class CannyCompute
+	{
+	public:
+		// nullptr if the compute shaders do not build
+		static std::shared_ptr<CannyCompute> Create();
+		CannyCompute(const CannyCompute& rhs) = delete;
+		CannyCompute& operator=(const CannyCompute& rhs) = delete;
+		~CannyCompute();
+
+		// white edges on black found in the red channel of texture, in an RGBA32 texture of the same size
+		std::shared_ptr<Texture> Apply(const std::shared_ptr<Texture>& texture, float lowThreshold, float highThreshold);
+
+	private:
+		CannyCompute();
+		void Resize(int width, int height);
+
+		std::shared_ptr<Shader> gradientShader, hysteresisShader, resolveShader;
+		int width, height;
+		unsigned int labels;		// GL_R32UI: 0 none, 1 weak, 2 strong
+		unsigned int worklists[2];	// indirect dispatch arguments and a count, then packed texels
+		int64_t accountedBytes;		// of labels and worklists, counted with GPUMemory
+	};
+}
\ No newline at end of file
@@ -142,4 +142,142 @@ namespace LibGraphics
             }
         }
     )";
+
+    // Compute version of the list above, run by CannyCompute when TextureFilter is created from it. Tiles of
+    // 16x16 texels load the red channel with a 4 texel halo into shared memory once, then blur, take the
+    // Sobel gradient and thin it to its local maxima there; hysteresis grows the strong edges over a worklist.
+    static const char* CANNY_COMPUTE_GRADIENT_SHADER = R"(
+        #define TILE 16
+        #define HALO 4          // 2 for the blur, 1 for the gradient, 1 for the suppression
+        #define WEAK 1u
+        #define STRONG 2u
+
+        layout(local_size_x = TILE, local_size_y = TILE) in;
+        layout(binding = 0) uniform sampler2D texture1;
+        layout(r32ui, binding = 0) uniform writeonly uimage2D uLabels;
+        layout(std430, binding = 0) buffer StrongEdges {
+            uint dispatchX, dispatchY, dispatchZ;   // indirect arguments for the first hysteresis step
+            uint count;
+            uint texels[];                          // x | y << 16
+        } strongEdges;
+        uniform float uEdgeThresholdLow;
+        uniform float uEdgeThresholdHigh;
+
+        const float kernel[5] = float[](1.0, 4.0, 6.0, 4.0, 1.0);
+
+        shared float red[TILE + 2 * HALO][TILE + 2 * HALO];
+        shared float blurred[TILE + 4][TILE + 4];
+        shared vec2 gradient[TILE + 2][TILE + 2];
+
+        void main() {
+            ivec2 size = textureSize(texture1, 0);
+            ivec2 origin = ivec2(gl_WorkGroupID.xy) * TILE - HALO;
+
+            // texels past the edges wrap like GL_REPEAT, % of a negative int is undefined so shift first
+            for (uint i = gl_LocalInvocationIndex; i < (TILE + 2 * HALO) * (TILE + 2 * HALO); i += TILE * TILE) {
+                ivec2 p = ivec2(i % (TILE + 2 * HALO), i / (TILE + 2 * HALO));
+                red[p.y][p.x] = texelFetch(texture1, (origin + p + size * HALO) % size, 0).r;
+            }
+            barrier();
+
+            for (uint i = gl_LocalInvocationIndex; i < (TILE + 4) * (TILE + 4); i += TILE * TILE) {
+                ivec2 p = ivec2(i % (TILE + 4), i / (TILE + 4));
+                float sum = 0.0;
+                for (int y = 0; y < 5; ++y)
+                    for (int x = 0; x < 5; ++x)
+                        sum += red[p.y + y][p.x + x] * kernel[x] * kernel[y];
+                blurred[p.y][p.x] = sum / 256.0;
+            }
+            barrier();
+
+            for (uint i = gl_LocalInvocationIndex; i < (TILE + 2) * (TILE + 2); i += TILE * TILE) {
+                ivec2 p = ivec2(i % (TILE + 2), i / (TILE + 2)) + 1;
+                float gx = (blurred[p.y - 1][p.x + 1] + 2.0 * blurred[p.y][p.x + 1] + blurred[p.y + 1][p.x + 1]) -
+                           (blurred[p.y - 1][p.x - 1] + 2.0 * blurred[p.y][p.x - 1] + blurred[p.y + 1][p.x - 1]);
+                float gy = (blurred[p.y + 1][p.x - 1] + 2.0 * blurred[p.y + 1][p.x] + blurred[p.y + 1][p.x + 1]) -
+                           (blurred[p.y - 1][p.x - 1] + 2.0 * blurred[p.y - 1][p.x] + blurred[p.y - 1][p.x + 1]);
+                gradient[p.y - 1][p.x - 1] = vec2(gx, gy);
+            }
+            barrier();
+
+            ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+            if (texel.x >= size.x || texel.y >= size.y)
+                return;
+
+            // keep the texel only if it is the largest across the edge, direction rounded to 45 degrees
+            ivec2 p = ivec2(gl_LocalInvocationID.xy) + 1;
+            vec2 g = gradient[p.y][p.x];
+            float magnitude = length(g);
+            int sector = (int(round(atan(g.y, g.x) * 4.0 / 3.14159265)) + 4) % 4;
+            const ivec2 across[4] = ivec2[](ivec2(1, 0), ivec2(1, 1), ivec2(0, 1), ivec2(-1, 1));
+            ivec2 ahead = p + across[sector], behind = p - across[sector];
+            bool maximum = magnitude >= length(gradient[ahead.y][ahead.x]) && magnitude > length(gradient[behind.y][behind.x]);
+
+            uint label = !maximum ? 0u : magnitude >= uEdgeThresholdHigh ? STRONG : magnitude >= uEdgeThresholdLow ? WEAK : 0u;
+            imageStore(uLabels, texel, uvec4(label));
+            if (label == STRONG) {
+                uint slot = atomicAdd(strongEdges.count, 1u);
+                strongEdges.texels[slot] = uint(texel.x) | (uint(texel.y) << 16);
+                atomicMax(strongEdges.dispatchX, min(slot / 64u + 1u, 65535u));
+            }
+        }
+    )";
+
+    // One step: weak neighbours of the texels found in the last step become strong and make the next list
+    static const char* CANNY_COMPUTE_HYSTERESIS_SHADER = R"(
+        #define WEAK 1u
+        #define STRONG 2u
+
+        layout(local_size_x = 64) in;
+        layout(r32ui, binding = 0) uniform coherent uimage2D uLabels;
+        layout(std430, binding = 0) readonly buffer Current {
+            uint dispatchX, dispatchY, dispatchZ;
+            uint count;
+            uint texels[];
+        } current;
+        layout(std430, binding = 1) buffer Next {
+            uint dispatchX, dispatchY, dispatchZ;
+            uint count;
+            uint texels[];
+        } next;
+
+        void main() {
+            ivec2 size = imageSize(uLabels);
+
+            // at most 65535 groups, larger lists are strided
+            for (uint i = gl_GlobalInvocationID.x; i < current.count; i += gl_NumWorkGroups.x * 64u) {
+                ivec2 texel = ivec2(current.texels[i] & 0xFFFFu, current.texels[i] >> 16);
+                for (int y = -1; y <= 1; ++y) {
+                    for (int x = -1; x <= 1; ++x) {
+                        ivec2 neighbour = texel + ivec2(x, y);
+                        if (neighbour.x < 0 || neighbour.y < 0 || neighbour.x >= size.x || neighbour.y >= size.y)
+                            continue;
+
+                        // only one invocation wins a texel, so it is listed once
+                        if (imageAtomicCompSwap(uLabels, neighbour, WEAK, STRONG) == WEAK) {
+                            uint slot = atomicAdd(next.count, 1u);
+                            next.texels[slot] = uint(neighbour.x) | (uint(neighbour.y) << 16);
+                            atomicMax(next.dispatchX, min(slot / 64u + 1u, 65535u));
+                        }
+                    }
+                }
+            }
+        }
+    )";
+
+    static const char* CANNY_COMPUTE_RESOLVE_SHADER = R"(
+        #define STRONG 2u
+
+        layout(local_size_x = 16, local_size_y = 16) in;
+        layout(r32ui, binding = 0) uniform readonly uimage2D uLabels;
+        layout(rgba8, binding = 1) uniform writeonly image2D uEdges;
+
+        void main() {
+            ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+            if (texel.x >= imageSize(uLabels).x || texel.y >= imageSize(uLabels).y)
+                return;
+            float edge = imageLoad(uLabels, texel).r == STRONG ? 1.0 : 0.0;
+            imageStore(uEdges, texel, vec4(vec3(edge), 1.0));
+        }
+    )";
 }
\ No newline at end of file
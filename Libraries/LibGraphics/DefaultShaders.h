@@ -1,5 +1,6 @@
 #pragma once
 
+#include "BlurShaders.h"
 #include "CannyShaders.h"
 
 namespace LibGraphics
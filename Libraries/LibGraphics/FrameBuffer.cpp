@@ -1,4 +1,5 @@
 #include "FrameBuffer.h"
+#include "GPUMemory.h"
 #include "GL/glew.h"
 #include "soil2/src/SOIL2/SOIL2.h"
 
@@ -64,6 +65,10 @@ namespace LibGraphics
 
 		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, frameBuffer->rbo);
 
+		// RGB8 targets and the 8 byte depth stencil
+		frameBuffer->accountedBytes = GPUMemory::TextureBytes(width, height, 4.0 * targets + 8.0, false);
+		GPUMemory::Allocate(GPUMemory::CATEGORY::RENDER_TARGET, frameBuffer->accountedBytes);
+
 		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
 		{
 			frameBuffer = nullptr;
@@ -94,6 +99,7 @@ namespace LibGraphics
 		std::swap(copy->width, this->width);
 		std::swap(copy->rbo, this->rbo);
 		std::swap(copy->texture, this->texture);
+		std::swap(copy->accountedBytes, this->accountedBytes);
 	}
 
 	void FrameBuffer::SetClearColor(const LibCore::Math::Vec4& clearColor)
@@ -206,6 +212,7 @@ namespace LibGraphics
 			result->texHandler, GL_TEXTURE_2D, 0, 0, 0, 0,	// Destination texture parameters
 			result->width, result->height, 1				// Dimensions of the copied region
 		);
+		result->Account(false);
 		return result;
 	}
 
@@ -263,6 +270,7 @@ namespace LibGraphics
 
 	FrameBuffer::~FrameBuffer()
 	{
+		GPUMemory::Release(GPUMemory::CATEGORY::RENDER_TARGET, accountedBytes);
 		if (!texture.empty())
 			glDeleteTextures((GLsizei)texture.size(), texture.data());
 		if (rbo)
@@ -278,6 +286,7 @@ namespace LibGraphics
 		, width{ width }
 		, height{ height }
 		, clearColor{ 1.0f,1.0f,1.0f,1.0f }
+		, accountedBytes{ 0 }
 	{
 
 	}
@@ -2,6 +2,7 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <cstdint>
 #include <functional>
 #include "Texture.h"
 #include "LibCore/Vec4.h"
@@ -40,5 +41,6 @@ namespace LibGraphics
 		unsigned fbo, rbo;
 		LibCore::Math::Vec4 clearColor;
 		std::vector<unsigned int> texture;
+		int64_t accountedBytes;	// counted with GPUMemory
 	};
 }
\ No newline at end of file
@@ -0,0 +1,157 @@
+#include "GPUMemory.h"
+
+#include <list>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+
+namespace LibGraphics
+{
+	namespace
+	{
+		struct Residency
+		{
+			std::atomic<int64_t> usage[static_cast<int>(GPUMemory::CATEGORY::COUNT)] = {};
+			std::atomic<int64_t> budget{ 0 };
+			std::atomic<uint64_t> evictions{ 0 };
+
+			struct Evictable
+			{
+				GPUMemory::Handle Handle;
+				std::function<void()> Evict;
+				uint64_t TouchedFrame;
+			};
+
+			// least recently touched first, frames advance with every Trim()
+			std::mutex mutex;
+			GPUMemory::Handle nextHandle = 1;
+			uint64_t frame = 0;
+			std::list<Evictable> lru;
+			std::unordered_map<GPUMemory::Handle, decltype(lru)::iterator> entries;
+		};
+
+		// function local so textures freed during static destruction still find it
+		Residency& GetResidency()
+		{
+			static Residency residency;
+			return residency;
+		}
+	}
+
+	void GPUMemory::Allocate(CATEGORY category, int64_t bytes)
+	{
+		GetResidency().usage[static_cast<int>(category)] += bytes;
+	}
+
+	void GPUMemory::Release(CATEGORY category, int64_t bytes)
+	{
+		GetResidency().usage[static_cast<int>(category)] -= bytes;
+	}
+
+	int64_t GPUMemory::GetUsage()
+	{
+		int64_t results = 0;
+		for (auto& usage : GetResidency().usage)
+			results += usage;
+		return results;
+	}
+
+	int64_t GPUMemory::GetUsage(CATEGORY category)
+	{
+		return GetResidency().usage[static_cast<int>(category)];
+	}
+
+	const char* GPUMemory::GetCategoryName(CATEGORY category)
+	{
+		switch (category)
+		{
+		case CATEGORY::TEXTURE:			return "Textures";
+		case CATEGORY::RENDER_TARGET:	return "Render targets";
+		case CATEGORY::TEXTURE_ARRAY:	return "Texture arrays";
+		case CATEGORY::ATLAS:			return "Thumbnail atlas";
+		case CATEGORY::COMPUTE:			return "Compute buffers";
+		default:						return "";
+		}
+	}
+
+	int64_t GPUMemory::TextureBytes(int width, int height, double bytesPerTexel, bool mipMapped)
+	{
+		const double bytes = static_cast<double>(width) * height * bytesPerTexel;
+		return static_cast<int64_t>(mipMapped ? bytes * 4.0 / 3.0 : bytes);
+	}
+
+	void GPUMemory::SetBudget(int64_t bytes)
+	{
+		GetResidency().budget = bytes;
+	}
+
+	int64_t GPUMemory::GetBudget()
+	{
+		return GetResidency().budget;
+	}
+
+	GPUMemory::Handle GPUMemory::RegisterEvictable(const std::function<void()>& evict)
+	{
+		auto& residency = GetResidency();
+		std::lock_guard<std::mutex> lock{ residency.mutex };
+		const Handle handle = residency.nextHandle++;
+		residency.lru.push_back(Residency::Evictable{ handle, evict, residency.frame });
+		residency.entries[handle] = std::prev(residency.lru.end());
+		return handle;
+	}
+
+	void GPUMemory::Unregister(Handle handle)
+	{
+		auto& residency = GetResidency();
+		std::lock_guard<std::mutex> lock{ residency.mutex };
+		auto entry = residency.entries.find(handle);
+		if (entry == residency.entries.end())
+			return;
+
+		residency.lru.erase(entry->second);
+		residency.entries.erase(entry);
+	}
+
+	void GPUMemory::Touch(Handle handle)
+	{
+		auto& residency = GetResidency();
+		std::lock_guard<std::mutex> lock{ residency.mutex };
+		auto entry = residency.entries.find(handle);
+		if (entry != residency.entries.end())
+		{
+			entry->second->TouchedFrame = residency.frame;
+			residency.lru.splice(residency.lru.end(), residency.lru, entry->second);
+		}
+	}
+
+	void GPUMemory::Trim()
+	{
+		auto& residency = GetResidency();
+		while (residency.budget > 0 && GetUsage() > residency.budget)
+		{
+			// called unlocked, evicting releases memory and may unregister other resources
+			std::function<void()> evict;
+			{
+				// what the last frame used stays even over budget, it would only be re-created right away
+				std::lock_guard<std::mutex> lock{ residency.mutex };
+				if (residency.lru.empty() || residency.lru.front().TouchedFrame == residency.frame)
+					break;
+
+				evict = std::move(residency.lru.front().Evict);
+				residency.entries.erase(residency.lru.front().Handle);
+				residency.lru.pop_front();
+			}
+
+			evict();
+			++residency.evictions;
+		}
+
+		std::lock_guard<std::mutex> lock{ residency.mutex };
+		++residency.frame;
+	}
+
+	uint64_t GPUMemory::GetEvictions()
+	{
+		return GetResidency().evictions;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+namespace LibGraphics
+{
+	// VRAM accounting of everything LibGraphics allocates (textures, render targets, texture arrays, atlas pages,
+	// compute scratch)
+	// and a budget kept by evicting what its owner can re-create: thumbnail atlas pages, filter render targets.
+	// Sizes are estimates from dimensions and format, RGB8 counted as the 4 bytes drivers store it in.
+	// Accounting is safe from any thread, eviction runs on the GL thread in Trim().
+	class GPUMemory
+	{
+	public:
+		enum class CATEGORY : int
+		{
+			TEXTURE = 0,
+			RENDER_TARGET,
+			TEXTURE_ARRAY,
+			ATLAS,
+			COMPUTE,
+			COUNT
+		};
+
+		static void Allocate(CATEGORY category, int64_t bytes);
+		static void Release(CATEGORY category, int64_t bytes);
+		static int64_t GetUsage();
+		static int64_t GetUsage(CATEGORY category);
+		static const char* GetCategoryName(CATEGORY category);
+
+		// bytes of a texture of bytesPerTexel, a third more with a full mip chain
+		static int64_t TextureBytes(int width, int height, double bytesPerTexel, bool mipMapped);
+
+		// 0 for no budget
+		static void SetBudget(int64_t bytes);
+		static int64_t GetBudget();
+
+		// evict frees the resource on the GL thread, the handle is already unregistered when it runs
+		using Handle = uint64_t;
+		static Handle RegisterEvictable(const std::function<void()>& evict);
+		static void Unregister(Handle handle);
+		// marks the resource as just used
+		static void Touch(Handle handle);
+		// GL thread, once per frame: evicts least recently touched resources until the usage is within budget,
+		// sparing those touched since the last call
+		static void Trim();
+		static uint64_t GetEvictions();
+	};
+}
\ No newline at end of file
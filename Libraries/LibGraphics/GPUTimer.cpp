@@ -0,0 +1,171 @@
+#include "GPUTimer.h"
+#include "GL/glew.h"
+
+#include <iomanip>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+
+#define GPU_TIMER_HISTORY 4096			// finished samples kept for ExportCSV
+#define GPU_TIMER_SMOOTHING 0.1			// weight of the newest sample in AverageMillis
+
+namespace LibGraphics
+{
+	std::shared_ptr<GPUTimer> GPUTimer::Create()
+	{
+		return std::shared_ptr<GPUTimer>{ new GPUTimer{} };
+	}
+
+	GPUTimer::~GPUTimer()
+	{
+		if (!allQueries.empty())
+			glDeleteQueries(static_cast<GLsizei>(allQueries.size()), allQueries.data());
+	}
+
+	void GPUTimer::BeginSample(const std::string& label, int width, int height)
+	{
+		if (sampleOpen)
+			EndSample();
+
+		current = Sample{ nextSampleId++, label, width, height, {}, {} };
+		sampleOpen = true;
+	}
+
+	void GPUTimer::BeginPass()
+	{
+		if (!sampleOpen || passOpen)
+			return;
+
+		current.Queries.push_back(AcquireQuery());
+		glBeginQuery(GL_TIME_ELAPSED, current.Queries.back());
+		passOpen = true;
+	}
+
+	void GPUTimer::EndPass()
+	{
+		if (!passOpen)
+			return;
+
+		glEndQuery(GL_TIME_ELAPSED);
+		passOpen = false;
+	}
+
+	void GPUTimer::EndSample()
+	{
+		if (!sampleOpen)
+			return;
+
+		EndPass();
+		sampleOpen = false;
+		if (current.Queries.empty())
+			return;
+		pending.push_back(std::move(current));
+	}
+
+	void GPUTimer::Collect()
+	{
+		while (!pending.empty())
+		{
+			// queries finish in order, the last pass being available means the whole sample is
+			auto& sample = pending.front();
+			GLint available = GL_FALSE;
+			glGetQueryObjectiv(sample.Queries.back(), GL_QUERY_RESULT_AVAILABLE, &available);
+			if (available == GL_FALSE)
+				break;
+
+			double sampleMillis = 0.0;
+			for (auto query : sample.Queries)
+			{
+				GLuint64 elapsed = 0;
+				glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+				sample.PassMillis.push_back(elapsed / 1000000.0);
+				sampleMillis += sample.PassMillis.back();
+				freeQueries.push_back(query);
+			}
+			sample.Queries.clear();
+
+			if (sample.Id >= clearedBefore)
+			{
+				auto& stat = stats[sample.Label];
+				stat.AverageMillis = stat.Samples == 0 ? sampleMillis : stat.AverageMillis + (sampleMillis - stat.AverageMillis) * GPU_TIMER_SMOOTHING;
+				stat.Samples++;
+				stat.LastMillis = sampleMillis;
+				stat.MaxMillis = std::max(stat.MaxMillis, sampleMillis);
+				stat.TotalMillis += sampleMillis;
+				stat.LastPassMillis = sample.PassMillis;
+
+				history.push_back(std::move(sample));
+				if (history.size() > GPU_TIMER_HISTORY)
+					history.pop_front();
+			}
+			pending.pop_front();
+		}
+	}
+
+	const GPUTimer::Stats* GPUTimer::GetStats(const std::string& label) const
+	{
+		auto it = stats.find(label);
+		return it == stats.end() ? nullptr : &it->second;
+	}
+
+	void GPUTimer::Clear()
+	{
+		// the queries of pending samples are still in use, they go back to the pool when collected
+		clearedBefore = nextSampleId;
+		stats.clear();
+		history.clear();
+	}
+
+	bool GPUTimer::ExportCSV(const std::string& path) const
+	{
+		std::ofstream file{ path, std::ios::out | std::ios::trunc };
+		if (!file)
+		{
+			std::cout << "Failed to write GPU timings to " << path << std::endl;
+			return false;
+		}
+
+		file << "sample,filter,width,height,pass,pass_ms,sample_ms\n";
+		file << std::fixed << std::setprecision(4);
+		for (auto& sample : history)
+		{
+			double sampleMillis = 0.0;
+			for (auto passMillis : sample.PassMillis)
+				sampleMillis += passMillis;
+
+			for (size_t pass = 0; pass < sample.PassMillis.size(); ++pass)
+			{
+				// labels are filter names, quote them in case one has a comma
+				file << sample.Id << ",\"" << sample.Label << "\","
+					<< sample.Width << ',' << sample.Height << ','
+					<< pass << ',' << sample.PassMillis[pass] << ',' << sampleMillis << "\n";
+			}
+		}
+		return file.good();
+	}
+
+	unsigned int GPUTimer::AcquireQuery()
+	{
+		if (freeQueries.empty())
+		{
+			GLuint query = 0;
+			glGenQueries(1, &query);
+			allQueries.push_back(query);
+			return query;
+		}
+
+		auto query = freeQueries.back();
+		freeQueries.pop_back();
+		return query;
+	}
+
+	GPUTimer::GPUTimer()
+		: nextSampleId{ 0 }
+		, clearedBefore{ 0 }
+		, sampleOpen{ false }
+		, passOpen{ false }
+		, current{}
+	{
+
+	}
+}
\ No newline at end of file
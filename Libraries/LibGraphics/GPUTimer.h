@@ -0,0 +1,72 @@
+#pragma once
+
+#include <map>
+#include <deque>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+namespace LibGraphics
+{
+	// GL_TIME_ELAPSED queries around filter passes. A sample is one Apply of a filter and holds a query per pass;
+	// results are read in Collect() once the GPU has them, never waiting on it, so timings show up a frame or
+	// two late. Time elapsed queries cannot nest: passes of one sample must not overlap. GL thread only.
+	class GPUTimer
+	{
+	public:
+		struct Stats
+		{
+			uint64_t Samples = 0;
+			double LastMillis = 0.0;
+			double AverageMillis = 0.0;	// smoothed over the last samples
+			double MaxMillis = 0.0;
+			double TotalMillis = 0.0;
+			std::vector<double> LastPassMillis;
+		};
+
+		static std::shared_ptr<GPUTimer> Create();
+		GPUTimer(const GPUTimer& rhs) = delete;
+		GPUTimer& operator=(const GPUTimer& rhs) = delete;
+		~GPUTimer();
+
+		void BeginSample(const std::string& label, int width, int height);
+		void BeginPass();
+		void EndPass();
+		void EndSample();
+
+		// reads back the samples the GPU has finished, in submission order
+		void Collect();
+		const std::map<std::string, Stats>& GetStats() const { return stats; }
+		// nullptr if label has no finished sample yet
+		const Stats* GetStats(const std::string& label) const;
+		// stats and history, samples still in flight are dropped when collected
+		void Clear();
+
+		// one row per pass of the finished samples still in the history
+		bool ExportCSV(const std::string& path) const;
+
+	private:
+		GPUTimer();
+		unsigned int AcquireQuery();
+
+		struct Sample
+		{
+			uint64_t Id;
+			std::string Label;
+			int Width, Height;
+			std::vector<unsigned int> Queries;
+			std::vector<double> PassMillis;
+		};
+
+		uint64_t nextSampleId;
+		uint64_t clearedBefore;		// samples begun before the last Clear() are not counted
+		bool sampleOpen, passOpen;
+		Sample current;
+		std::deque<Sample> pending;
+		std::deque<Sample> history;
+		std::vector<unsigned int> freeQueries;
+		std::vector<unsigned int> allQueries;
+		std::map<std::string, Stats> stats;
+	};
+}
\ No newline at end of file
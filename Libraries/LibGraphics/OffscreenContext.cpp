@@ -0,0 +1,379 @@
+#include "OffscreenContext.h"
+
+#include "GL/glew.h"
+
+#include <mutex>
+#include <vector>
+#include <cstring>
+#include <iostream>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include "GL/wglew.h"
+#endif
+
+// opt-in, the build defines these when it links libEGL / libOSMesa (e.g. -DLIBGRAPHICS_EGL -lEGL)
+#if defined(LIBGRAPHICS_EGL)
+#define OFFSCREEN_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#if defined(LIBGRAPHICS_OSMESA)
+#define OFFSCREEN_OSMESA
+#include <GL/osmesa.h>
+#endif
+
+#define OFFSCREEN_WINDOW_CLASS L"LibGraphicsOffscreenContext"
+#define OFFSCREEN_MAX_EGL_DEVICES 16
+
+namespace LibGraphics
+{
+	namespace
+	{
+#if defined(OFFSCREEN_EGL)
+		bool HasExtension(const char* extensions, const char* name)
+		{
+			const size_t length = std::strlen(name);
+			for (const char* found = extensions ? std::strstr(extensions, name) : nullptr; found; found = std::strstr(found + length, name))
+			{
+				const bool starts = found == extensions || found[-1] == ' ';
+				const bool ends = found[length] == ' ' || found[length] == '\0';
+				if (starts && ends)
+					return true;
+			}
+			return false;
+		}
+
+		EGLDisplay OpenEGLDisplay()
+		{
+			const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+			auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+
+			// Mesa without any window system, covers llvmpipe on machines without a GPU
+			if (getPlatformDisplay && HasExtension(clientExtensions, "EGL_MESA_platform_surfaceless"))
+			{
+				EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+				if (display != EGL_NO_DISPLAY && eglInitialize(display, nullptr, nullptr))
+					return display;
+			}
+
+			// vendor drivers (e.g. NVIDIA) expose their GPUs as devices instead
+			auto queryDevices = reinterpret_cast<PFNEGLQUERYDEVICESEXTPROC>(eglGetProcAddress("eglQueryDevicesEXT"));
+			if (getPlatformDisplay && queryDevices && HasExtension(clientExtensions, "EGL_EXT_platform_device"))
+			{
+				EGLDeviceEXT devices[OFFSCREEN_MAX_EGL_DEVICES];
+				EGLint deviceCount = 0;
+				if (queryDevices(OFFSCREEN_MAX_EGL_DEVICES, devices, &deviceCount))
+				{
+					for (EGLint i = 0; i < deviceCount; ++i)
+					{
+						EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_DEVICE_EXT, devices[i], nullptr);
+						if (display != EGL_NO_DISPLAY && eglInitialize(display, nullptr, nullptr))
+							return display;
+					}
+				}
+			}
+
+			EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+			if (display != EGL_NO_DISPLAY && eglInitialize(display, nullptr, nullptr))
+				return display;
+			return EGL_NO_DISPLAY;
+		}
+#endif
+	}
+
+	std::shared_ptr<OffscreenContext> OffscreenContext::Create(int majorVersion, int minorVersion)
+	{
+		auto results = std::shared_ptr<OffscreenContext>(new OffscreenContext{});
+
+		const bool created =
+			results->CreateEGL(majorVersion, minorVersion) ||
+			results->CreateOSMesa(majorVersion, minorVersion) ||
+			results->CreateWGL(majorVersion, minorVersion);
+		if (!created)
+		{
+			std::cerr << "No offscreen OpenGL " << majorVersion << "." << minorVersion << " context available" << std::endl;
+			return nullptr;
+		}
+
+		if (!results->MakeCurrent() || !results->LoadFunctions())
+			return nullptr;
+		return results;
+	}
+
+	OffscreenContext::OffscreenContext()
+		: api{ API::NONE }
+		, backend{ }
+		, display{ nullptr }
+		, surface{ nullptr }
+		, context{ nullptr }
+	{
+
+	}
+
+	OffscreenContext::~OffscreenContext()
+	{
+		switch (api)
+		{
+#if defined(OFFSCREEN_EGL)
+		case API::EGL:
+			if (eglGetCurrentContext() == static_cast<EGLContext>(context))
+				eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+			if (surface)
+				eglDestroySurface(display, surface);
+			eglDestroyContext(display, context);
+			// the display is shared by every context of the process, it is not terminated here
+			break;
+#endif
+#if defined(OFFSCREEN_OSMESA)
+		case API::OSMESA:
+			if (OSMesaGetCurrentContext() == static_cast<OSMesaContext>(context))
+				OSMesaMakeCurrent(nullptr, nullptr, GL_UNSIGNED_BYTE, 0, 0);
+			OSMesaDestroyContext(static_cast<OSMesaContext>(context));
+			delete[] static_cast<unsigned char*>(surface);
+			break;
+#endif
+#if defined(_WIN32)
+		case API::WGL:
+			if (wglGetCurrentContext() == static_cast<HGLRC>(context))
+				wglMakeCurrent(nullptr, nullptr);
+			wglDeleteContext(static_cast<HGLRC>(context));
+			ReleaseDC(static_cast<HWND>(surface), static_cast<HDC>(display));
+			DestroyWindow(static_cast<HWND>(surface));	// only succeeds on the creating thread
+			break;
+#endif
+		default:
+			break;
+		}
+	}
+
+	bool OffscreenContext::MakeCurrent() const
+	{
+		switch (api)
+		{
+#if defined(OFFSCREEN_EGL)
+		case API::EGL:
+			return eglBindAPI(EGL_OPENGL_API) && eglMakeCurrent(display, surface, surface, context);
+#endif
+#if defined(OFFSCREEN_OSMESA)
+		case API::OSMESA:
+			return OSMesaMakeCurrent(static_cast<OSMesaContext>(context), surface, GL_UNSIGNED_BYTE, 1, 1);
+#endif
+#if defined(_WIN32)
+		case API::WGL:
+			return wglMakeCurrent(static_cast<HDC>(display), static_cast<HGLRC>(context));
+#endif
+		default:
+			return false;
+		}
+	}
+
+	void OffscreenContext::ReleaseCurrent() const
+	{
+		switch (api)
+		{
+#if defined(OFFSCREEN_EGL)
+		case API::EGL:
+			eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+			break;
+#endif
+#if defined(OFFSCREEN_OSMESA)
+		case API::OSMESA:
+			OSMesaMakeCurrent(nullptr, nullptr, GL_UNSIGNED_BYTE, 0, 0);
+			break;
+#endif
+#if defined(_WIN32)
+		case API::WGL:
+			wglMakeCurrent(nullptr, nullptr);
+			break;
+#endif
+		default:
+			break;
+		}
+	}
+
+	const std::string& OffscreenContext::Backend() const
+	{
+		return backend;
+	}
+
+	std::string OffscreenContext::Renderer() const
+	{
+		const auto renderer = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+		return renderer ? renderer : "";
+	}
+
+	bool OffscreenContext::CreateEGL(int majorVersion, int minorVersion)
+	{
+#if defined(OFFSCREEN_EGL)
+		EGLDisplay eglDisplay = OpenEGLDisplay();
+		if (eglDisplay == EGL_NO_DISPLAY || !eglBindAPI(EGL_OPENGL_API))
+			return false;
+
+		// nothing is ever presented, the filters render into their own framebuffers
+		const bool surfaceless = HasExtension(eglQueryString(eglDisplay, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context");
+		const EGLint configAttributes[] = {
+			EGL_SURFACE_TYPE, surfaceless ? 0 : EGL_PBUFFER_BIT,
+			EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+			EGL_RED_SIZE, 8,
+			EGL_GREEN_SIZE, 8,
+			EGL_BLUE_SIZE, 8,
+			EGL_ALPHA_SIZE, 8,
+			EGL_NONE
+		};
+		EGLConfig config = nullptr;
+		EGLint configCount = 0;
+		if (!eglChooseConfig(eglDisplay, configAttributes, &config, 1, &configCount) || configCount == 0)
+			return false;
+
+		const EGLint contextAttributes[] = {
+			EGL_CONTEXT_MAJOR_VERSION, majorVersion,
+			EGL_CONTEXT_MINOR_VERSION, minorVersion,
+			EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+			EGL_NONE
+		};
+		EGLContext eglContext = eglCreateContext(eglDisplay, config, EGL_NO_CONTEXT, contextAttributes);
+		if (eglContext == EGL_NO_CONTEXT)
+			return false;
+
+		EGLSurface eglSurface = EGL_NO_SURFACE;
+		if (!surfaceless)
+		{
+			const EGLint pbufferAttributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+			eglSurface = eglCreatePbufferSurface(eglDisplay, config, pbufferAttributes);
+			if (eglSurface == EGL_NO_SURFACE)
+			{
+				eglDestroyContext(eglDisplay, eglContext);
+				return false;
+			}
+		}
+
+		api = API::EGL;
+		backend = surfaceless ? "EGL surfaceless" : "EGL pbuffer";
+		display = eglDisplay;
+		surface = eglSurface;
+		context = eglContext;
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	bool OffscreenContext::CreateOSMesa(int majorVersion, int minorVersion)
+	{
+#if defined(OFFSCREEN_OSMESA)
+		const int attributes[] = {
+			OSMESA_FORMAT, OSMESA_RGBA,
+			OSMESA_DEPTH_BITS, 0,
+			OSMESA_PROFILE, OSMESA_CORE_PROFILE,
+			OSMESA_CONTEXT_MAJOR_VERSION, majorVersion,
+			OSMESA_CONTEXT_MINOR_VERSION, minorVersion,
+			0
+		};
+		OSMesaContext osmesaContext = OSMesaCreateContextAttribs(attributes, nullptr);
+		if (!osmesaContext)
+			return false;
+
+		// OSMesa needs a colour buffer to make a context current, 1x1 is enough next to the filters' framebuffers
+		api = API::OSMESA;
+		backend = "OSMesa";
+		surface = new unsigned char[4]{};
+		context = osmesaContext;
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	bool OffscreenContext::CreateWGL(int majorVersion, int minorVersion)
+	{
+#if defined(_WIN32)
+		// WGL cannot create a context without a window, a hidden one owned by this thread does not need GLFW
+		static std::once_flag registered;
+		std::call_once(registered, []() {
+			WNDCLASSW windowClass{};
+			windowClass.style = CS_OWNDC;
+			windowClass.lpfnWndProc = DefWindowProcW;
+			windowClass.hInstance = GetModuleHandleW(nullptr);
+			windowClass.lpszClassName = OFFSCREEN_WINDOW_CLASS;
+			RegisterClassW(&windowClass);
+		});
+
+		HWND window = CreateWindowExW(0, OFFSCREEN_WINDOW_CLASS, L"", WS_OVERLAPPEDWINDOW, 0, 0, 1, 1, nullptr, nullptr, GetModuleHandleW(nullptr), nullptr);
+		if (!window)
+			return false;
+
+		HDC deviceContext = GetDC(window);
+		PIXELFORMATDESCRIPTOR pixelFormat{};
+		pixelFormat.nSize = sizeof(pixelFormat);
+		pixelFormat.nVersion = 1;
+		pixelFormat.dwFlags = PFD_DRAW_TO_WINDOW | PFD_SUPPORT_OPENGL | PFD_DOUBLEBUFFER;
+		pixelFormat.iPixelType = PFD_TYPE_RGBA;
+		pixelFormat.cColorBits = 32;
+		pixelFormat.iLayerType = PFD_MAIN_PLANE;
+
+		// a legacy context first, wglCreateContextAttribsARB can only be looked up with one current
+		HGLRC legacyContext = nullptr;
+		const int format = ChoosePixelFormat(deviceContext, &pixelFormat);
+		if (format == 0 || !SetPixelFormat(deviceContext, format, &pixelFormat) || !(legacyContext = wglCreateContext(deviceContext)))
+		{
+			ReleaseDC(window, deviceContext);
+			DestroyWindow(window);
+			return false;
+		}
+
+		HGLRC previousContext = wglGetCurrentContext();
+		HDC previousDeviceContext = wglGetCurrentDC();
+		wglMakeCurrent(deviceContext, legacyContext);
+		auto createContextAttribs = reinterpret_cast<PFNWGLCREATECONTEXTATTRIBSARBPROC>(wglGetProcAddress("wglCreateContextAttribsARB"));
+
+		const int attributes[] = {
+			WGL_CONTEXT_MAJOR_VERSION_ARB, majorVersion,
+			WGL_CONTEXT_MINOR_VERSION_ARB, minorVersion,
+			WGL_CONTEXT_PROFILE_MASK_ARB, WGL_CONTEXT_CORE_PROFILE_BIT_ARB,
+			0
+		};
+		HGLRC coreContext = createContextAttribs ? createContextAttribs(deviceContext, nullptr, attributes) : nullptr;
+		wglMakeCurrent(previousDeviceContext, previousContext);
+		wglDeleteContext(legacyContext);
+
+		if (!coreContext)
+		{
+			ReleaseDC(window, deviceContext);
+			DestroyWindow(window);
+			return false;
+		}
+
+		api = API::WGL;
+		backend = "WGL hidden window";
+		display = deviceContext;
+		surface = window;
+		context = coreContext;
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	bool OffscreenContext::LoadFunctions() const
+	{
+		// GLEW keeps one global set of entry points, contexts of the same driver share them,
+		// but worker threads creating contexts at the same time must not load them concurrently
+		static std::mutex glewMutex;
+		std::lock_guard<std::mutex> lock{ glewMutex };
+
+		glewExperimental = GL_TRUE;
+		const GLenum glErr = glewInit();
+		glGetError();	// glewInit queries GL_EXTENSIONS the pre-core way on core contexts
+		// a GLEW built for GLX also wants an X display for its GLX entry points, the GL ones are loaded by then
+		if (glErr != GLEW_OK && glErr != GLEW_ERROR_NO_GLX_DISPLAY)
+		{
+			std::cerr << "Error: " << glewGetErrorString(glErr) << std::endl;
+			return false;
+		}
+		return true;
+	}
+}
\ No newline at end of file
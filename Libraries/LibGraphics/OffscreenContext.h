@@ -0,0 +1,44 @@
+#pragma once
+#include <memory>
+#include <string>
+
+namespace LibGraphics
+{
+	// A GL context without a window, for batch jobs, benchmarks and machines without a display.
+	// Unlike AppManager it does not need GLFW or the main thread: each worker thread creates its own
+	// context and makes it current, after which Texture, FrameBuffer and TextureFilter work as usual.
+	// Backends, first available wins: EGL (surfaceless, else a 1x1 pbuffer), OSMesa, and on Windows
+	// a hidden WGL window owned by the creating thread. Mesa llvmpipe works through EGL and OSMesa.
+	// EGL and OSMesa are compiled in only when the build defines LIBGRAPHICS_EGL / LIBGRAPHICS_OSMESA
+	// and links the library, without either Create returns nullptr off Windows.
+	class OffscreenContext
+	{
+	public:
+		// current on the calling thread when returned, nullptr if no backend could provide a 4.3 core context
+		static std::shared_ptr<OffscreenContext> Create(int majorVersion = 4, int minorVersion = 3);
+		~OffscreenContext();
+
+		bool MakeCurrent() const;
+		void ReleaseCurrent() const;
+		const std::string& Backend() const;	// e.g. "EGL surfaceless", for logs
+		std::string Renderer() const;		// GL_RENDERER, needs the context current
+
+	private:
+		OffscreenContext();
+		OffscreenContext(const OffscreenContext&) = delete;
+		OffscreenContext& operator=(const OffscreenContext&) = delete;
+
+		bool CreateEGL(int majorVersion, int minorVersion);
+		bool CreateOSMesa(int majorVersion, int minorVersion);
+		bool CreateWGL(int majorVersion, int minorVersion);
+		bool LoadFunctions() const;
+
+		enum class API { NONE, EGL, OSMESA, WGL };
+
+		API api;
+		std::string backend;
+		void* display;		// EGLDisplay, HDC
+		void* surface;		// EGLSurface, HWND, OSMesa colour buffer
+		void* context;		// EGLContext, HGLRC, OSMesaContext
+	};
+}
\ No newline at end of file
@@ -31,6 +31,8 @@ namespace LibGraphics
 		{
 		case TYPE::VERTEX: info.shaderType = GL_VERTEX_SHADER; break;
 		case TYPE::FRAGMENT: info.shaderType = GL_FRAGMENT_SHADER; break;
+		case TYPE::COMPUTE: info.shaderType = GL_COMPUTE_SHADER; break;
+		case TYPE::GEOMETRY: info.shaderType = GL_GEOMETRY_SHADER; break;
 		default:
 			assert(false); // shader type not implemented
 		}
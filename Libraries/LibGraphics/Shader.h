@@ -16,7 +16,9 @@ namespace LibGraphics
 		enum class TYPE
 		{
 			VERTEX = 0,
-			FRAGMENT
+			FRAGMENT,
+			COMPUTE,	// on its own in a program, run with glDispatchCompute
+			GEOMETRY
 		};
 
 		enum class UTYPE
@@ -1,10 +1,20 @@
 #include "Texture.h"
+#include "GPUMemory.h"
 #include "GL/glew.h"
 #include "soil2/src/SOIL2/SOIL2.h"
 #include "soil2/src/SOIL2/image_helper.h"
+// image_DXT.h has no C++ guards of its own, unlike SOIL2.h and image_helper.h
+extern "C"
+{
+#include "soil2/src/SOIL2/image_DXT.h"
+}
 #include "LibCore/StringUtils.h"
+#include "LibCore/File.h"
 
 #include <array>
+#include <cstdlib>
+#include <iostream>
+#include <algorithm>
 #include <filesystem>
 
 namespace LibGraphics
@@ -19,6 +29,7 @@ namespace LibGraphics
 		, width(wd)
 		, height(ht)
 		, format(f)
+		, accountedBytes(0)
 	{
 		if (width == 0 || height == 0)
 			return;
@@ -52,6 +63,7 @@ namespace LibGraphics
 		std::vector<unsigned char> img(static_cast<size_t>(height * width * channels), 255);
 
 		glTexImage2D(GL_TEXTURE_2D, 0, type, width, height, 0, type, GL_UNSIGNED_BYTE, img.data());
+		Account(mipMapped);
 	}
 
 	Texture::Texture(Texture&& rhs)
@@ -59,8 +71,10 @@ namespace LibGraphics
 		, height(rhs.height)
 		, format(rhs.format)
 		, texHandler(rhs.texHandler)
+		, accountedBytes(rhs.accountedBytes)
 	{
 		rhs.texHandler = 0;
+		rhs.accountedBytes = 0;
 	}
 
 	Texture& Texture::operator=(Texture&& rhs)
@@ -69,11 +83,13 @@ namespace LibGraphics
 		std::swap(rhs.height, height);
 		std::swap(rhs.format, format);
 		std::swap(rhs.texHandler, texHandler);
+		std::swap(rhs.accountedBytes, accountedBytes);
 		return *this;
 	}
 
 	Texture::~Texture()
 	{
+		GPUMemory::Release(GPUMemory::CATEGORY::TEXTURE, accountedBytes);
 		if (texHandler)
 		{
 			glDeleteTextures(1, &texHandler);
@@ -186,43 +202,41 @@ namespace LibGraphics
 
 	bool Texture::Save(const std::string& path) const
 	{
-		std::string ext = std::filesystem::path{ path }.extension().string();
-		int channels = format == FORMAT::RGBA32 ? 4 : 3;
+		return SavePixels(path, GetWidth(), GetHeight(), GetChannels(), ReadPixels());
+	}
+
+	LibCore::Async::Future<bool> Texture::Save(const std::string& path, LibCore::Async::ThreadPool& threadPool) const
+	{
+		return threadPool.Enqueue([path, channels = GetChannels(), pixels = ReadPixels()](int width, int height) {
+			return SavePixels(path, width, height, channels, pixels);
+		}, 
+		GetWidth(),
+		GetHeight());
+	}
+
+	std::vector<unsigned char> Texture::ReadPixels() const
+	{
+		const int channels = GetChannels();
 		std::vector<unsigned char> pixels((size_t)GetWidth() * GetHeight() * channels, 0);
 		Bind();
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
 		glGetTexImage(GL_TEXTURE_2D, 0, channels == 4 ? GL_RGBA : GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+		return pixels;
+	}
 
-		auto saveType = SOIL_SAVE_TYPE_QOI;
-
-		if (ext == ".bmp")
-			saveType = SOIL_SAVE_TYPE_BMP;
-		else if (ext == ".tga")
-			saveType = SOIL_SAVE_TYPE_TGA;
-		else if (ext == ".dds")
-			saveType = SOIL_SAVE_TYPE_DDS;
-		else if (ext == ".png")
-			saveType = SOIL_SAVE_TYPE_PNG;
-		else if (ext == ".jpg" || ext == ".jpeg")
-			saveType = SOIL_SAVE_TYPE_JPG;
+	bool Texture::SavePixels(const std::string& path, int width, int height, int channels, const std::vector<unsigned char>& pixels)
+	{
+		// SOIL only writes DDS straight to a file
+		if (LibCore::Utils::String::ToLower(std::filesystem::path{ path }.extension().string()) == ".dds")
+			return SOIL_save_image_quality(path.c_str(), SOIL_SAVE_TYPE_DDS, width, height, channels, pixels.data(), 100) == 1;
 
-		return SOIL_save_image_quality(
-			path.c_str(),
-			saveType,
-			GetWidth(),
-			GetHeight(),
-			channels,
-			pixels.data(),
-			100);
+		const auto encoded = EncodePixels(path, width, height, channels, pixels);
+		return !encoded.Empty() && LibCore::Filesystem::File{ path.c_str() }.Write(encoded.Data(), encoded.Size());
 	}
 
-	LibCore::Async::Future<bool> Texture::Save(const std::string& path, LibCore::Async::ThreadPool& threadPool) const
+	LibCore::Filesystem::IOBuffer Texture::EncodePixels(const std::string& path, int width, int height, int channels, const std::vector<unsigned char>& pixels)
 	{
 		std::string ext = LibCore::Utils::String::ToLower(std::filesystem::path{ path }.extension().string());
-		int channels = format == FORMAT::RGBA32 ? 4 : 3;
-		std::vector<unsigned char> pixels((size_t)GetWidth() * GetHeight() * channels, 0);
-		Bind();
-		glGetTexImage(GL_TEXTURE_2D, 0, channels == 4 ? GL_RGBA : GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
-
 		auto saveType = SOIL_SAVE_TYPE_QOI;
 
 		if (ext == ".bmp")
@@ -236,18 +250,21 @@ namespace LibGraphics
 		else if (ext == ".jpg" || ext == ".jpeg")
 			saveType = SOIL_SAVE_TYPE_JPG;
 
-		return threadPool.Enqueue([path, saveType, channels, pixels](unsigned width, unsigned height) {
-			return SOIL_save_image_quality(
-				path.c_str(),
-				saveType,
-				width,
-				height,
-				channels,
-				pixels.data(),
-				100) == 1;
-		}, 
-		GetWidth(),
-		GetHeight());
+		int encodedSize = 0;
+		unsigned char* encoded = SOIL_write_image_to_memory_quality(
+			saveType,
+			width,
+			height,
+			channels,
+			pixels.data(),
+			100,
+			&encodedSize);
+		if (!encoded)
+			return {};
+
+		LibCore::Filesystem::IOBuffer results{ encoded, static_cast<size_t>(encodedSize) };
+		SOIL_free_image_data(encoded);
+		return results;
 	}
 
 	std::shared_ptr<Texture> Texture::Clone() const
@@ -270,6 +287,7 @@ namespace LibGraphics
 			result->texHandler, GL_TEXTURE_2D, 0, 0, 0, 0,	// Destination texture parameters
 			result->width, result->height, 1				// Dimensions of the copied region
 		);
+		result->Account(false);
 		return result;
 	}
 
@@ -279,6 +297,13 @@ namespace LibGraphics
 		return result;
 	}
 
+	int Texture::GetMaxSize()
+	{
+		GLint maxSize = 0;
+		glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+		return maxSize;
+	}
+
 	std::shared_ptr<Texture> Texture::CreateFromData(const std::vector<char>& data)
 	{
 		int width, height, channel;
@@ -339,6 +364,7 @@ namespace LibGraphics
 			pData);
 
 		glGenerateMipmap(GL_TEXTURE_2D);
+		result->Account(true);
 
 		glActiveTexture(GL_TEXTURE0);
 		glBindTexture(GL_TEXTURE_2D, 0);
@@ -408,6 +434,7 @@ namespace LibGraphics
 			pData);
 
 		glGenerateMipmap(GL_TEXTURE_2D);
+		result->Account(true);
 
 		glActiveTexture(GL_TEXTURE0);
 		glBindTexture(GL_TEXTURE_2D, 0);
@@ -472,6 +499,7 @@ namespace LibGraphics
 			GL_UNSIGNED_BYTE,
 			data.data());
 		glGenerateMipmap(GL_TEXTURE_2D);
+		result->Account(true);
 
 		glActiveTexture(GL_TEXTURE0);
 		glBindTexture(GL_TEXTURE_2D, 0);
@@ -534,6 +562,7 @@ namespace LibGraphics
 			GL_UNSIGNED_BYTE,
 			data.data());
 		glGenerateMipmap(GL_TEXTURE_2D);
+		result->Account(true);
 
 		glActiveTexture(GL_TEXTURE0);
 		glBindTexture(GL_TEXTURE_2D, 0);
@@ -541,6 +570,124 @@ namespace LibGraphics
 		return result;
 	}
 
+	void Texture::Account(bool mipMapped)
+	{
+		// bytes per texel as drivers store the format, RGB8 is padded to 4
+		double bytesPerTexel = 4.0;
+		switch (format)
+		{
+		case FORMAT::R8:
+			bytesPerTexel = 1.0;
+			break;
+		case FORMAT::YUY2:
+			bytesPerTexel = 2.0;
+			break;
+		case FORMAT::BC1:
+			bytesPerTexel = 0.5;
+			break;
+		default:
+			break;
+		}
+
+		GPUMemory::Release(GPUMemory::CATEGORY::TEXTURE, accountedBytes);
+		accountedBytes = GPUMemory::TextureBytes(width, height, bytesPerTexel, mipMapped);
+		GPUMemory::Allocate(GPUMemory::CATEGORY::TEXTURE, accountedBytes);
+	}
+
+	Texture::CompressedData Texture::CompressBC1(const std::vector<char>& pixels, int width, int height, FORMAT format)
+	{
+		if (width <= 0 || height <= 0 || (format != FORMAT::BGR24 && format != FORMAT::RGB24) || pixels.size() < static_cast<size_t>(width) * height * 3)
+			return {};
+
+		// the encoder reads RGB
+		std::vector<unsigned char> level(pixels.begin(), pixels.begin() + static_cast<size_t>(width) * height * 3);
+		if (format == FORMAT::BGR24)
+		{
+			for (size_t i = 0; i < level.size(); i += 3)
+				std::swap(level[i], level[i + 2]);
+		}
+
+		CompressedData results;
+		results.width = width;
+		results.height = height;
+		int levelWidth = width, levelHeight = height;
+		while (true)
+		{
+			int size = 0;
+			unsigned char* blocks = convert_image_to_DXT1(level.data(), levelWidth, levelHeight, 3, &size);
+			if (!blocks)
+				return {};
+			results.levels.emplace_back(blocks, blocks + size);
+			std::free(blocks);
+
+			if (levelWidth == 1 && levelHeight == 1)
+				break;
+
+			// 2x2 box filter, the sizes round down like GL's mip chain
+			const int nextWidth = std::max(1, levelWidth / 2), nextHeight = std::max(1, levelHeight / 2);
+			std::vector<unsigned char> next(static_cast<size_t>(nextWidth) * nextHeight * 3);
+			for (int y = 0; y < nextHeight; ++y)
+			{
+				const unsigned char* row0 = &level[static_cast<size_t>(std::min(2 * y, levelHeight - 1)) * levelWidth * 3];
+				const unsigned char* row1 = &level[static_cast<size_t>(std::min(2 * y + 1, levelHeight - 1)) * levelWidth * 3];
+				for (int x = 0; x < nextWidth; ++x)
+				{
+					const int x0 = std::min(2 * x, levelWidth - 1) * 3, x1 = std::min(2 * x + 1, levelWidth - 1) * 3;
+					for (int c = 0; c < 3; ++c)
+						next[(static_cast<size_t>(y) * nextWidth + x) * 3 + c] = static_cast<unsigned char>((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) / 4);
+				}
+			}
+			level.swap(next);
+			levelWidth = nextWidth;
+			levelHeight = nextHeight;
+		}
+		return results;
+	}
+
+	std::shared_ptr<Texture> Texture::CreateFromCompressed(const CompressedData& data)
+	{
+		if (data.levels.empty())
+			return nullptr;
+		if (!GLEW_EXT_texture_compression_s3tc)
+		{
+			std::cout << "S3TC texture compression not supported" << std::endl;
+			return nullptr;
+		}
+
+		std::shared_ptr<Texture> result{ new Texture{} };
+		result->format = FORMAT::BC1;
+		result->width = data.width;
+		result->height = data.height;
+
+		glActiveTexture(GL_TEXTURE0);
+		glGenTextures(1, &result->texHandler);
+		glBindTexture(GL_TEXTURE_2D, result->texHandler);
+
+		// same sampling as CreateFromData, the chain comes precomputed so no glGenerateMipmap
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(data.levels.size()) - 1);
+
+		for (size_t level = 0; level < data.levels.size(); ++level)
+		{
+			glCompressedTexImage2D(
+				GL_TEXTURE_2D,
+				static_cast<GLint>(level),
+				GL_COMPRESSED_RGB_S3TC_DXT1_EXT,
+				std::max(1, data.width >> level),
+				std::max(1, data.height >> level),
+				0,
+				static_cast<GLsizei>(data.levels[level].size()),
+				data.levels[level].data());
+		}
+		result->Account(data.levels.size() > 1);
+
+		glBindTexture(GL_TEXTURE_2D, 0);
+		return result;
+	}
+
 	Texture::TextureData Texture::DecodeData(const char* data, size_t size)
 	{
 		int channel;
@@ -640,6 +787,7 @@ namespace LibGraphics
 			GL_UNSIGNED_BYTE,
 			pData);
 		glGenerateMipmap(GL_TEXTURE_2D);
+		result->Account(true);
 
 		SOIL_free_image_data(pData);
 
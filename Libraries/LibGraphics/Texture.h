@@ -3,10 +3,12 @@
 #include <string>
 #include <memory>
 #include <vector>
+#include <cstdint>
 
 #include "LibCore/Vec4.h"
 #include "LibCore/Future.h"
 #include "LibCore/ThreadPool.h"
+#include "LibCore/IOBuffer.h"
 
 namespace LibGraphics
 {
@@ -19,7 +21,8 @@ namespace LibGraphics
 			BGR24,	// Color texture format, 8-bits per channel.
 			RGB24,	// Color texture format, 8-bits per channel.
 			RGBA32, // Color with alpha texture format, 8 - bits per channel.
-			YUY2	// A format that uses the YUV color space and is often used for video encoding or playback.
+			YUY2,	// A format that uses the YUV color space and is often used for video encoding or playback.
+			BC1		// DXT1 block compressed color, 4 bits per pixel, no alpha.
 		};
 
 		Texture(unsigned width, unsigned height, FORMAT format, bool mipMapped);
@@ -43,6 +46,9 @@ namespace LibGraphics
 
 		bool Save(const std::string& path) const;
 		LibCore::Async::Future<bool> Save(const std::string& path, LibCore::Async::ThreadPool& threadPool) const;
+		// GL thread only, returns tightly packed RGB (or RGBA for RGBA32) rows
+		std::vector<unsigned char> ReadPixels() const;
+		int GetChannels() const { return format == FORMAT::RGBA32 ? 4 : 3; }
 		std::shared_ptr<Texture> Clone() const;
 
 		// static here
@@ -53,20 +59,41 @@ namespace LibGraphics
 			std::vector<char> data;
 		};
 		static TextureData DecodeData(const char* data, size_t size);
+
+		// BC1 blocks of every mip level down to 1x1, 8 bytes per 4x4 block
+		struct CompressedData
+		{
+			int width = 0, height = 0;
+			std::vector<std::vector<unsigned char>> levels;
+		};
+		// does not touch GL, takes tightly packed BGR24 or RGB24 rows; empty levels on failure
+		static CompressedData CompressBC1(const std::vector<char>& pixels, int width, int height, FORMAT format);
+		// GL thread only, nullptr without S3TC support or for empty data
+		static std::shared_ptr<Texture> CreateFromCompressed(const CompressedData& data);
 		static std::shared_ptr<Texture> CreateFromFile(const std::string& filePath);
 		static std::shared_ptr<Texture> CreateFromData(const std::vector<char>& data);
 		static std::shared_ptr<Texture> CreateFromData(const std::vector<unsigned char>& data);
 		static std::shared_ptr<Texture> CreateFromData(const std::vector<char>& data, int width, int height, FORMAT format);
 		static std::shared_ptr<Texture> CreateFromData(const std::vector<unsigned char>& data, int width, int height, FORMAT format);
 		static std::shared_ptr<Texture> CreateWhiteTexture(int width, int height);
+		// GL_MAX_TEXTURE_SIZE, GL thread only
+		static int GetMaxSize();
+		// does not touch GL, safe to call from any thread with pixels from ReadPixels()
+		static bool SavePixels(const std::string& path, int width, int height, int channels, const std::vector<unsigned char>& pixels);
+		// encodes in memory in the format picked by the extension of path (QOI if unknown), empty on failure or for DDS
+		static LibCore::Filesystem::IOBuffer EncodePixels(const std::string& path, int width, int height, int channels, const std::vector<unsigned char>& pixels);
 
 	private:
 		friend class FrameBuffer;
+		friend class CannyCompute;
 		Texture();
+		// counts the storage with GPUMemory once the size and format are set, again if they change
+		void Account(bool mipMapped);
 
 		int width;
 		int height;
 		FORMAT format;
 		unsigned int texHandler;
+		int64_t accountedBytes;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,119 @@
+#include "TextureArray.h"
+#include "GPUMemory.h"
+#include "GL/glew.h"
+
+#include <iostream>
+
+namespace LibGraphics
+{
+	std::shared_ptr<TextureArray> TextureArray::Create(int width, int height, int layers)
+	{
+		if (width <= 0 || height <= 0 || layers <= 0 || layers > GetMaxLayers())
+			return nullptr;
+
+		auto results = std::shared_ptr<TextureArray>{ new TextureArray{} };
+		results->width = width;
+		results->height = height;
+		results->layers = layers;
+
+		glActiveTexture(GL_TEXTURE0);
+		glGenTextures(1, &results->texHandler);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, results->texHandler);
+		glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_RGB8, width, height, layers);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+		results->accountedBytes = GPUMemory::TextureBytes(width, height, 4.0 * layers, false);
+		GPUMemory::Allocate(GPUMemory::CATEGORY::TEXTURE_ARRAY, results->accountedBytes);
+
+		glGenFramebuffers(1, &results->fbo);
+		glBindFramebuffer(GL_FRAMEBUFFER, results->fbo);
+		glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, results->texHandler, 0);
+		const bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		if (!complete)
+		{
+			std::cout << "Layered framebuffer incomplete" << std::endl;
+			return nullptr;
+		}
+
+		glGenFramebuffers(1, &results->readFbo);
+		return results;
+	}
+
+	TextureArray::~TextureArray()
+	{
+		GPUMemory::Release(GPUMemory::CATEGORY::TEXTURE_ARRAY, accountedBytes);
+		glDeleteFramebuffers(1, &readFbo);
+		glDeleteFramebuffers(1, &fbo);
+		glDeleteTextures(1, &texHandler);
+	}
+
+	void TextureArray::Upload(int layer, const std::vector<char>& pixels, Texture::FORMAT format) const
+	{
+		if (layer < 0 || layer >= layers || pixels.size() < static_cast<size_t>(width) * height * 3)
+			return;
+
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, texHandler);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, width, height, 1, format == Texture::FORMAT::BGR24 ? GL_BGR : GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	}
+
+	std::vector<unsigned char> TextureArray::ReadLayer(int layer) const
+	{
+		if (layer < 0 || layer >= layers)
+			return {};
+
+		GLint readFboId = 0;
+		glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &readFboId);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, readFbo);
+		glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, texHandler, 0, layer);
+		glReadBuffer(GL_COLOR_ATTACHMENT0);
+
+		std::vector<unsigned char> results(static_cast<size_t>(width) * height * 3);
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, results.data());
+
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, readFboId);
+		return results;
+	}
+
+	void TextureArray::Bind() const
+	{
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, texHandler);
+	}
+
+	void TextureArray::RenderToLayers(const std::function<void()>& renderCall) const
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+		glViewport(0, 0, width, height);
+		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT);	// clears every attached layer
+		renderCall();
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+
+	int TextureArray::GetMaxLayers()
+	{
+		GLint maxLayers = 0;
+		glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+		return maxLayers;
+	}
+
+	TextureArray::TextureArray()
+		: width{ 0 }
+		, height{ 0 }
+		, layers{ 0 }
+		, texHandler{ 0 }
+		, fbo{ 0 }
+		, readFbo{ 0 }
+		, accountedBytes{ 0 }
+	{
+
+	}
+}
\ No newline at end of file
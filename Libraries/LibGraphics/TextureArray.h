@@ -0,0 +1,47 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <functional>
+
+#include "Texture.h"
+
+namespace LibGraphics
+{
+	// GL_TEXTURE_2D_ARRAY of same-size RGB layers, also a layered render target: one draw with a geometry shader
+	// writing gl_Layer fills every layer, so a batch of images goes through a filter pass at once
+	// (TextureFilter::ApplyLayers). Sampled with GL_LINEAR and GL_REPEAT like the other textures. GL thread only.
+	class TextureArray
+	{
+	public:
+		static std::shared_ptr<TextureArray> Create(int width, int height, int layers);
+		TextureArray(const TextureArray& rhs) = delete;
+		TextureArray& operator=(const TextureArray& rhs) = delete;
+		~TextureArray();
+
+		// tightly packed BGR24 or RGB24 rows
+		void Upload(int layer, const std::vector<char>& pixels, Texture::FORMAT format) const;
+		// tightly packed RGB rows like Texture::ReadPixels
+		std::vector<unsigned char> ReadLayer(int layer) const;
+
+		void Bind() const;
+		// every layer attached, renderCall draws once per layer
+		void RenderToLayers(const std::function<void()>& renderCall) const;
+
+		int GetWidth() const { return width; }
+		int GetHeight() const { return height; }
+		int GetLayers() const { return layers; }
+		// GL_MAX_ARRAY_TEXTURE_LAYERS
+		static int GetMaxLayers();
+
+	private:
+		TextureArray();
+
+		int width, height, layers;
+		unsigned int texHandler;
+		unsigned int fbo;		// all layers, for rendering
+		unsigned int readFbo;	// one layer at a time, for reading back
+		int64_t accountedBytes;	// counted with GPUMemory
+	};
+}
\ No newline at end of file
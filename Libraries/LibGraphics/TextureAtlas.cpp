@@ -0,0 +1,203 @@
+#include "TextureAtlas.h"
+#include "GL/glew.h"
+
+#include <iostream>
+#include <algorithm>
+
+namespace LibGraphics
+{
+	namespace
+	{
+		size_t BlocksSize(int width, int height)
+		{
+			return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * 8;
+		}
+
+		// zeroed BC1 blocks decode to black
+		void ClearRect(int level, int x, int y, int width, int height)
+		{
+			const std::vector<unsigned char> black(BlocksSize(width, height), 0);
+			glCompressedTexSubImage2D(GL_TEXTURE_2D, level, x, y, width, height, GL_COMPRESSED_RGB_S3TC_DXT1_EXT, static_cast<GLsizei>(black.size()), black.data());
+		}
+	}
+
+	std::shared_ptr<TextureAtlas> TextureAtlas::Create(int pageSize, int levels)
+	{
+		if (!GLEW_EXT_texture_compression_s3tc)
+		{
+			std::cout << "S3TC texture compression not supported" << std::endl;
+			return nullptr;
+		}
+
+		auto results = std::shared_ptr<TextureAtlas>{ new TextureAtlas{} };
+		results->levels = std::clamp(levels, 1, 8);
+
+		// every level of a page a whole number of blocks
+		const int alignment = 4 << (results->levels - 1);
+		results->pageSize = std::min(pageSize, Texture::GetMaxSize()) / alignment * alignment;
+		if (results->pageSize <= 0)
+			return nullptr;
+		return results;
+	}
+
+	TextureAtlas::~TextureAtlas()
+	{
+		for (size_t page = 0; page < pages.size(); ++page)
+			ReleasePage(static_cast<int>(page));
+	}
+
+	TextureAtlas::Region TextureAtlas::Add(const Texture::CompressedData& data)
+	{
+		if (data.levels.empty() || data.width <= 0 || data.height <= 0)
+			return {};
+
+		// positions on a multiple of the block size at the smallest level, one texel of gutter there
+		const int gutter = 1 << (levels - 1);
+		Region results;
+		results.Width = data.width;
+		results.Height = data.height;
+		for (size_t page = 0; page < pages.size() && !results.Valid(); ++page)
+		{
+			if (pages[page].texHandler != 0 && pages[page].Allocator.Allocate(data.width + gutter, data.height + gutter, results.Allocation))
+				results.Page = static_cast<int>(page);
+		}
+
+		if (!results.Valid())
+		{
+			const int page = CreatePage();
+			if (!pages[page].Allocator.Allocate(data.width + gutter, data.height + gutter, results.Allocation))
+			{
+				ReleasePage(page);
+				return {};
+			}
+			results.Page = page;
+		}
+		results.Generation = pages[results.Page].Generation;
+
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, pages[results.Page].texHandler);
+		const int uploadLevels = std::min(levels, static_cast<int>(data.levels.size()));
+		for (int level = 0; level < uploadLevels; ++level)
+		{
+			// whole blocks, the padding of a partial block lands in the gutter
+			const int levelWidth = std::max(1, data.width >> level), levelHeight = std::max(1, data.height >> level);
+			if (data.levels[level].size() != BlocksSize(levelWidth, levelHeight))
+				break;
+
+			glCompressedTexSubImage2D(
+				GL_TEXTURE_2D,
+				level,
+				results.Allocation.X >> level,
+				results.Allocation.Y >> level,
+				(levelWidth + 3) / 4 * 4,
+				(levelHeight + 3) / 4 * 4,
+				GL_COMPRESSED_RGB_S3TC_DXT1_EXT,
+				static_cast<GLsizei>(data.levels[level].size()),
+				data.levels[level].data());
+		}
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		results.UV0 = LibCore::Math::Vec2{ results.Allocation.X / (float)pageSize, results.Allocation.Y / (float)pageSize };
+		results.UV1 = LibCore::Math::Vec2{ (results.Allocation.X + data.width) / (float)pageSize, (results.Allocation.Y + data.height) / (float)pageSize };
+		return results;
+	}
+
+	void TextureAtlas::Remove(const Region& region)
+	{
+		if (!IsResident(region))
+			return;
+
+		auto& page = pages[region.Page];
+		page.Allocator.Free(region.Allocation);
+		if (page.Allocator.Empty())
+		{
+			ReleasePage(region.Page);
+			return;
+		}
+
+		// back to black, the next image placed over it would otherwise have this one in its gutter
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, page.texHandler);
+		for (int level = 0; level < levels; ++level)
+			ClearRect(level, region.Allocation.X >> level, region.Allocation.Y >> level, region.Allocation.Width >> level, region.Allocation.Height >> level);
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+
+	bool TextureAtlas::IsResident(const Region& region) const
+	{
+		return region.Valid()
+			&& region.Page < static_cast<int>(pages.size())
+			&& pages[region.Page].texHandler != 0
+			&& pages[region.Page].Generation == region.Generation;
+	}
+
+	void TextureAtlas::Touch(const Region& region) const
+	{
+		if (IsResident(region))
+			GPUMemory::Touch(pages[region.Page].Residency);
+	}
+
+	uint64_t TextureAtlas::GetPageHandler(int page) const
+	{
+		return page >= 0 && page < static_cast<int>(pages.size()) ? (uint64_t)pages[page].texHandler : 0;
+	}
+
+	int TextureAtlas::GetPageCount() const
+	{
+		return static_cast<int>(std::count_if(pages.begin(), pages.end(), [](const Page& page) { return page.texHandler != 0; }));
+	}
+
+	int TextureAtlas::CreatePage()
+	{
+		auto slot = std::find_if(pages.begin(), pages.end(), [](const Page& page) { return page.texHandler == 0; });
+		if (slot == pages.end())
+			slot = pages.insert(pages.end(), Page{ 0, AtlasAllocator{ pageSize, pageSize, 4 << (levels - 1) }, 0, 0, 0 });
+		else
+			slot->Allocator = AtlasAllocator{ pageSize, pageSize, 4 << (levels - 1) };
+		const int page = static_cast<int>(slot - pages.begin());
+
+		glActiveTexture(GL_TEXTURE0);
+		glGenTextures(1, &slot->texHandler);
+		glBindTexture(GL_TEXTURE_2D, slot->texHandler);
+		glTexStorage2D(GL_TEXTURE_2D, levels, GL_COMPRESSED_RGB_S3TC_DXT1_EXT, pageSize, pageSize);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+		// storage starts undefined, the gutters have to be black
+		slot->Bytes = 0;
+		for (int level = 0; level < levels; ++level)
+		{
+			ClearRect(level, 0, 0, pageSize >> level, pageSize >> level);
+			slot->Bytes += static_cast<int64_t>(BlocksSize(pageSize >> level, pageSize >> level));
+		}
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		GPUMemory::Allocate(GPUMemory::CATEGORY::ATLAS, slot->Bytes);
+		slot->Residency = GPUMemory::RegisterEvictable([this, page]() { ReleasePage(page); });
+		return page;
+	}
+
+	void TextureAtlas::ReleasePage(int page)
+	{
+		auto& slot = pages[page];
+		if (slot.texHandler == 0)
+			return;
+
+		GPUMemory::Unregister(slot.Residency);
+		GPUMemory::Release(GPUMemory::CATEGORY::ATLAS, slot.Bytes);
+		glDeleteTextures(1, &slot.texHandler);
+		slot.texHandler = 0;
+		slot.Bytes = 0;
+		slot.Residency = 0;
+		++slot.Generation;	// regions handed out so far are no longer resident
+	}
+
+	TextureAtlas::TextureAtlas()
+		: pageSize{ 0 }
+		, levels{ 1 }
+	{
+
+	}
+}
\ No newline at end of file
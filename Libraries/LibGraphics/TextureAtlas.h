@@ -0,0 +1,70 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+#include "Texture.h"
+#include "GPUMemory.h"
+#include "AtlasAllocator.h"
+#include "LibCore/Vec2.h"
+
+namespace LibGraphics
+{
+	// BC1 pages that many small images share, so a grid of them samples a few textures instead of one each.
+	// Every page keeps `levels` mip levels; images are placed on a grid coarse enough for their blocks to line up
+	// at every level, with a black gutter so filtering at the smallest level does not reach a neighbour. Pages
+	// are allocated when the others are full and freed when their last image goes, or evicted whole by GPUMemory
+	// when over budget and not touched for a frame; their regions then stop being resident. GL thread only.
+	class TextureAtlas
+	{
+	public:
+		struct Region
+		{
+			int Page = -1;
+			uint32_t Generation = 0;			// of the page, it changes when the page is freed
+			int Width = 0, Height = 0;			// of the image, the allocation around it is larger
+			AtlasAllocator::Rect Allocation;
+			LibCore::Math::Vec2 UV0, UV1;
+
+			bool Valid() const { return Page >= 0; }
+			float GetAspect() const { return Width / (float)Height; }
+		};
+
+		// nullptr without S3TC support; pageSize is clamped to GL_MAX_TEXTURE_SIZE
+		static std::shared_ptr<TextureAtlas> Create(int pageSize, int levels);
+		TextureAtlas(const TextureAtlas& rhs) = delete;
+		TextureAtlas& operator=(const TextureAtlas& rhs) = delete;
+		~TextureAtlas();
+
+		// invalid region if the image is larger than a page; levels past the page's are dropped
+		Region Add(const Texture::CompressedData& data);
+		void Remove(const Region& region);
+		// false once the page of region has been evicted, its image has to be added again
+		bool IsResident(const Region& region) const;
+		// keeps the page of region from eviction for this frame
+		void Touch(const Region& region) const;
+
+		uint64_t GetPageHandler(int page) const;
+		int GetPageSize() const { return pageSize; }
+		// allocated pages, empty slots not counted
+		int GetPageCount() const;
+
+	private:
+		TextureAtlas();
+		int CreatePage();
+		void ReleasePage(int page);
+
+		struct Page
+		{
+			unsigned int texHandler;	// 0 once freed, the slot is reused
+			AtlasAllocator Allocator;
+			uint32_t Generation;
+			int64_t Bytes;
+			GPUMemory::Handle Residency;
+		};
+
+		int pageSize, levels;
+		std::vector<Page> pages;
+	};
+}
\ No newline at end of file
@@ -1,6 +1,14 @@
 #include "TextureFilter.h"
 #include "GL/glew.h"
 #include "FrameBuffer.h"
+#include "DefaultShaders.h"
+
+#include <cmath>
+#include <regex>
+#include <algorithm>
+
+#define PYRAMID_BLUR_MAX_SIGMA 3.0f		// the separable shader has 12 taps a side, 4 standard deviations
+#define PYRAMID_BLOOM_MAX_LEVELS 8
 
 namespace LibGraphics
 {
@@ -16,6 +24,51 @@ namespace LibGraphics
             TexCoord = aTexCoord;               \
         }";
 
+    // the quad is drawn once per layer, the geometry shader sends every instance to its own layer
+    const char* LAYERED_VERTEX_SHADER = R"(
+        layout(location = 0) in vec3 aPos;
+        layout(location = 1) in vec2 aTexCoord;
+
+        out vec2 vTexCoord;
+        flat out int vLayer;
+
+        void main()
+        {
+            gl_Position = vec4(aPos, 1.0);
+            vTexCoord = aTexCoord;
+            vLayer = gl_InstanceID;
+        }
+    )";
+
+    const char* LAYERED_GEOMETRY_SHADER = R"(
+        layout(triangles) in;
+        layout(triangle_strip, max_vertices = 3) out;
+
+        in vec2 vTexCoord[];
+        flat in int vLayer[];
+        out vec2 TexCoord;
+
+        void main()
+        {
+            for (int i = 0; i < 3; ++i)
+            {
+                gl_Layer = vLayer[0];
+                gl_Position = gl_in[i].gl_Position;
+                TexCoord = vTexCoord[i];
+                EmitVertex();
+            }
+            EndPrimitive();
+        }
+    )";
+
+    // the filter shaders sample their own layer unchanged: sampler2D is swapped for sampler2DArray in the
+    // source and the lookups take gl_Layer, which fragment shaders read since GLSL 4.30
+    const char* LAYERED_FRAGMENT_PREFIX = R"(
+        #define texture(s, uv) texture(s, vec3(uv, gl_Layer))
+        #define texelFetch(s, p, lod) texelFetch(s, ivec3(p, gl_Layer), lod)
+        #define textureSize(s, lod) textureSize(s, lod).xy
+    )";
+
 	std::shared_ptr<TextureFilter> TextureFilter::CreateFromShader(const std::string& fragShader)
 	{
         return CreateFromShaders({ fragShader });
@@ -32,83 +85,286 @@ namespace LibGraphics
             if (!results->shaders.back()->GenShaderProgram())
                 return nullptr;
         }
+        results->fragmentSources = fragShaders;
+
+        const std::vector<std::string> pyramidBlur = { SEPARABLE_GAUSSIAN_BLUR_SHADER, SEPARABLE_GAUSSIAN_BLUR_SHADER, BLUR_RESAMPLE_SHADER };
+        const std::vector<std::string> pyramidBloom = { BLOOM_BRIGHT_PASS_SHADER, BLUR_RESAMPLE_SHADER, BLOOM_UPSAMPLE_SHADER, BLOOM_COMPOSITE_SHADER };
+        const std::vector<std::string> canny = { CANNY_EDGE_DETECT_BLUR_SHADER, CANNY_EDGE_DETECT_SOBEL_SHADER, CANNY_EDGE_DETECT_THRESHOLD_SHADER, CANNY_EDGE_DETECT_HYSTERIESIS_SHADER };
+        if (fragShaders == pyramidBlur)
+            results->customPasses = &TextureFilter::PyramidBlurPasses;
+        else if (fragShaders == pyramidBloom)
+            results->customPasses = &TextureFilter::PyramidBloomPasses;
+        else if (fragShaders == canny && (results->cannyCompute = CannyCompute::Create()) != nullptr)
+            results->customPasses = &TextureFilter::ComputeCannyPasses;  // the fragment passes stay the fallback
         return results;
     }
 
     std::shared_ptr<Texture> TextureFilter::Apply(const std::shared_ptr<Texture>& texture)
     {
-        if(framebuffer == nullptr || framebuffer->GetWidth() != texture->GetWidth() || framebuffer->GetHeight() != texture->GetHeight())
-            framebuffer = FrameBuffer::CreateFrameBuffer(texture->GetWidth(), texture->GetHeight());
+        // targets of an earlier image size would only hold on to VRAM
+        auto sameSize = framebuffers.find({ texture->GetWidth(), texture->GetHeight() });
+        if (sameSize == framebuffers.end())
+            framebuffers.clear();
+        GPUMemory::Touch(residency);
+
+        if (timer)
+            timer->BeginSample(timerLabel, texture->GetWidth(), texture->GetHeight());
 
         auto filteredTexture = texture;
-        for (auto& shader : shaders)
+        if (customPasses)
+            filteredTexture = (this->*customPasses)(texture);
+        else
         {
-            framebuffer->RenderToBuffer([this, &shader, &filteredTexture]() {
-                shader->UseProgram();
+            for (size_t i = 0; i < shaders.size(); ++i)
+                filteredTexture = RenderPass(i, static_cast<int>(i), filteredTexture, texture->GetWidth(), texture->GetHeight());
+        }
+
+        if (timer)
+            timer->EndSample();
+        return filteredTexture;
+    }
+
+    void TextureFilter::SetTimer(const std::shared_ptr<GPUTimer>& newTimer, const std::string& label)
+    {
+        timer = newTimer;
+        timerLabel = label;
+    }
+
+    std::shared_ptr<Texture> TextureFilter::RenderPass(
+        size_t shader,
+        int passIndex,
+        const std::shared_ptr<Texture>& input,
+        int width,
+        int height,
+        const std::function<void(const Shader&)>& uniforms,
+        const std::shared_ptr<Texture>& secondary)
+    {
+        auto& framebuffer = framebuffers[{ width, height }];
+        if (framebuffer == nullptr)
+            framebuffer = FrameBuffer::CreateFrameBuffer(width, height);
 
-                for (auto& p : intValues)   shader->SetInt(p.first.c_str(), p.second);
-                for (auto& p : floatValues) shader->SetFloat(p.first.c_str(), p.second);
-                for (auto& p : vec2Values)  shader->SetVec2(p.first.c_str(), p.second);
-                for (auto& p : vec3Values)  shader->SetVec3(p.first.c_str(), p.second);
-                for (auto& p : vec4Values)  shader->SetVec4(p.first.c_str(), p.second);
+        // the targets only cache the last run, an idle filter gives them up when over the VRAM budget
+        if (residency == 0)
+            residency = GPUMemory::RegisterEvictable([this]() { framebuffers.clear(); residency = 0; });
 
-                shader->SetVec2("_Resolution_", LibCore::Math::Vec2{ (float)filteredTexture->GetWidth(), (float)filteredTexture->GetHeight() });
+        const auto& program = shaders[shader];
+        if (timer)
+            timer->BeginPass();
+        framebuffer->RenderToBuffer([&]() {
+            program->UseProgram();
+            SetUniforms(*program, passIndex, input->GetWidth(), input->GetHeight());
+            if (uniforms)
+                uniforms(*program);
 
-                filteredTexture->Bind();
+            if (secondary)
+            {
+                // Texture::Bind always binds to unit 0
+                program->SetInt("texture2", 1);
+                glActiveTexture(GL_TEXTURE1);
+                glBindTexture(GL_TEXTURE_2D, static_cast<GLuint>(secondary->GetHandler()));
+                glActiveTexture(GL_TEXTURE0);
+            }
+            input->Bind();
+
+            glBindVertexArray(quadVAO);
+            glDrawArrays(GL_TRIANGLES, 0, 6);
+            glBindVertexArray(0);
+        });
+        if (timer)
+            timer->EndPass();
+
+        return framebuffer->GetGLTexture();
+    }
+
+    void TextureFilter::SetUniforms(const Shader& program, int passIndex, int width, int height) const
+    {
+        for (auto& p : uniformValues.Ints)   program.SetInt(p.first.c_str(), p.second);
+        for (auto& p : uniformValues.Floats) program.SetFloat(p.first.c_str(), p.second);
+        for (auto& p : uniformValues.Vec2s)  program.SetVec2(p.first.c_str(), p.second);
+        for (auto& p : uniformValues.Vec3s)  program.SetVec3(p.first.c_str(), p.second);
+        for (auto& p : uniformValues.Vec4s)  program.SetVec4(p.first.c_str(), p.second);
+
+        program.SetVec2("_Resolution_", LibCore::Math::Vec2{ (float)width, (float)height });
+        program.SetInt("_PassIndex_", passIndex);
+    }
+
+    bool TextureFilter::PrepareLayers()
+    {
+        if (customPasses || fragmentSources.empty() || layersFailed)
+            return false;
+        if (layerShaders.size() == fragmentSources.size())
+            return true;
+
+        static const std::regex sampler2D{ R"(\bsampler2D\b)" };
+        layerShaders.clear();
+        for (auto& source : fragmentSources)
+        {
+            auto program = std::make_shared<LibGraphics::Shader>();
+            program->AddShaderFromString(LAYERED_VERTEX_SHADER, LibGraphics::Shader::TYPE::VERTEX);
+            program->AddShaderFromString(LAYERED_GEOMETRY_SHADER, LibGraphics::Shader::TYPE::GEOMETRY);
+            program->AddShaderFromString(LAYERED_FRAGMENT_PREFIX + std::regex_replace(source, sampler2D, "sampler2DArray"), LibGraphics::Shader::TYPE::FRAGMENT);
+            if (!program->GenShaderProgram())
+            {
+                // would fail the same way every batch, the filter stays on single textures
+                layersFailed = true;
+                layerShaders.clear();
+                return false;
+            }
+            layerShaders.push_back(program);
+        }
+        return true;
+    }
+
+    std::shared_ptr<TextureArray> TextureFilter::ApplyLayers(const std::shared_ptr<TextureArray>& layers)
+    {
+        if (timer)
+            timer->BeginSample(timerLabel, layers->GetWidth(), layers->GetHeight());
+
+        auto filtered = layers;
+        for (size_t i = 0; i < layerShaders.size(); ++i)
+        {
+            // a new target per pass, the caller keeps the returned array while reading it back
+            auto target = TextureArray::Create(layers->GetWidth(), layers->GetHeight(), layers->GetLayers());
+            if (!target)
+            {
+                filtered = nullptr;
+                break;
+            }
+
+            const auto& program = layerShaders[i];
+            if (timer)
+                timer->BeginPass();
+            target->RenderToLayers([&]() {
+                program->UseProgram();
+                SetUniforms(*program, static_cast<int>(i), filtered->GetWidth(), filtered->GetHeight());
+                filtered->Bind();
 
                 glBindVertexArray(quadVAO);
-                glDrawArrays(GL_TRIANGLES, 0, 6);
+                glDrawArraysInstanced(GL_TRIANGLES, 0, 6, filtered->GetLayers());
                 glBindVertexArray(0);
             });
-
-            filteredTexture = framebuffer->GetGLTexture();
+            if (timer)
+                timer->EndPass();
+            filtered = target;
         }
 
-        return framebuffer->GetGLTexture();
+        if (timer)
+            timer->EndSample();
+        return filtered;
+    }
+
+    std::shared_ptr<Texture> TextureFilter::PyramidBlurPasses(const std::shared_ptr<Texture>& texture)
+    {
+        auto radius = uniformValues.Floats.find("uBlurRadius");
+        const float sigma = std::max(radius == uniformValues.Floats.end() ? 2.0f : radius->second, 0.0f);
+        const int width = texture->GetWidth(), height = texture->GetHeight();
+
+        // halve until what is left of the deviation fits the shader's kernel, every pixel then costs the same
+        int levels = 0;
+        while (sigma / float(1 << levels) > PYRAMID_BLUR_MAX_SIGMA && (width >> (levels + 1)) > 0 && (height >> (levels + 1)) > 0)
+            ++levels;
+
+        // 2x2 box downsampling and bilinear upsampling blur as well, the kernel only adds what they leave out
+        const float scale = float(1 << levels);
+        const float resampleVariance = (scale * scale - 1.0f) * 11.0f / 36.0f;
+        const float levelSigma = std::sqrt(std::max(sigma * sigma - resampleVariance, 0.0f)) / scale;
+        auto levelUniforms = [levelSigma](const Shader& shader) { shader.SetFloat("uBlurRadius", levelSigma); };
+
+        auto results = texture;
+        for (int level = 1; level <= levels; ++level)
+            results = RenderPass(2, 0, results, std::max(1, width >> level), std::max(1, height >> level));
+
+        const int levelWidth = std::max(1, width >> levels), levelHeight = std::max(1, height >> levels);
+        results = RenderPass(0, 0, results, levelWidth, levelHeight, levelUniforms);
+        results = RenderPass(1, 1, results, levelWidth, levelHeight, levelUniforms);
+
+        for (int level = levels - 1; level >= 0; --level)
+            results = RenderPass(2, 0, results, std::max(1, width >> level), std::max(1, height >> level));
+        return results;
+    }
+
+    std::shared_ptr<Texture> TextureFilter::PyramidBloomPasses(const std::shared_ptr<Texture>& texture)
+    {
+        auto levelValue = uniformValues.Ints.find("uBloomLevels");
+        const int width = texture->GetWidth(), height = texture->GetHeight();
+
+        int levels = std::clamp(levelValue == uniformValues.Ints.end() ? 5 : levelValue->second, 1, PYRAMID_BLOOM_MAX_LEVELS);
+        while (levels > 1 && ((width >> levels) == 0 || (height >> levels) == 0))
+            --levels;
+
+        // bright pass, then a chain of halvings: level n glows 2^n texels wide
+        std::vector<std::shared_ptr<Texture>> pyramid{ RenderPass(0, 0, texture, width, height) };
+        for (int level = 1; level <= levels; ++level)
+            pyramid.push_back(RenderPass(1, 1, pyramid.back(), std::max(1, width >> level), std::max(1, height >> level)));
+
+        // back up, every level blends in the glow gathered below it
+        auto glow = pyramid.back();
+        for (int level = levels - 1; level >= 1; --level)
+            glow = RenderPass(2, 2, pyramid[level], std::max(1, width >> level), std::max(1, height >> level), nullptr, glow);
+
+        return RenderPass(3, 3, texture, width, height, nullptr, glow);
+    }
+
+    std::shared_ptr<Texture> TextureFilter::ComputeCannyPasses(const std::shared_ptr<Texture>& texture)
+    {
+        // unset thresholds read as 0 in the fragment passes as well
+        auto low = uniformValues.Floats.find("uEdgeThresholdLow");
+        auto high = uniformValues.Floats.find("uEdgeThresholdHigh");
+
+        // the worklist checks read back in between, timed as a single pass
+        if (timer)
+            timer->BeginPass();
+        auto results = cannyCompute->Apply(
+            texture,
+            low == uniformValues.Floats.end() ? 0.0f : low->second,
+            high == uniformValues.Floats.end() ? 0.0f : high->second);
+        if (timer)
+            timer->EndPass();
+        return results;
     }
 
     std::shared_ptr<TextureFilter> TextureFilter::Clone() const
     {
         auto results = std::shared_ptr<TextureFilter>{ new TextureFilter{} };
         results->shaders = shaders;
-        results->framebuffer = nullptr;
-        results->intValues = intValues;
-        results->floatValues = floatValues;
-        results->vec2Values = vec2Values;
-        results->vec3Values = vec3Values;
-        results->vec4Values = vec4Values;
+        results->layerShaders = layerShaders;
+        results->layersFailed = layersFailed;
+        results->fragmentSources = fragmentSources;
+        results->customPasses = customPasses;
+        results->cannyCompute = cannyCompute;
+        results->uniformValues = uniformValues;
         return results;
     }
 
     void TextureFilter::SetInt(const char* location, int data)
     {
-        intValues[location] = data;
+        uniformValues.Ints[location] = data;
     }
 
     void TextureFilter::SetFloat(const char* location, float data)
     {
-        floatValues[location] = data;
+        uniformValues.Floats[location] = data;
     }
 
     void TextureFilter::SetVec4(const char* location, const LibCore::Math::Vec4& data)
     {
-        vec4Values[location] = data;
+        uniformValues.Vec4s[location] = data;
     }
 
     void TextureFilter::SetVec3(const char* location, const LibCore::Math::Vec3& data)
     {
-        vec3Values[location] = data;
+        uniformValues.Vec3s[location] = data;
     }
 
     void TextureFilter::SetVec2(const char* location, const LibCore::Math::Vec2& data)
     {
-        vec2Values[location] = data;
+        uniformValues.Vec2s[location] = data;
     }
 
     bool TextureFilter::GetInt(const char* location, int& data)
     {
-        auto it = intValues.find(location);
-        if (it == intValues.end())
+        auto it = uniformValues.Ints.find(location);
+        if (it == uniformValues.Ints.end())
             return false;
         data = it->second;
         return true;
@@ -116,8 +372,8 @@ namespace LibGraphics
 
     bool TextureFilter::GetFloat(const char* location, float& data)
     {
-        auto it = floatValues.find(location);
-        if (it == floatValues.end())
+        auto it = uniformValues.Floats.find(location);
+        if (it == uniformValues.Floats.end())
             return false;
         data = it->second;
         return true;
@@ -125,8 +381,8 @@ namespace LibGraphics
 
     bool TextureFilter::GetVec4(const char* location, LibCore::Math::Vec4& data)
     {
-        auto it = vec4Values.find(location);
-        if (it == vec4Values.end())
+        auto it = uniformValues.Vec4s.find(location);
+        if (it == uniformValues.Vec4s.end())
             return false;
         data = it->second;
         return true;
@@ -134,8 +390,8 @@ namespace LibGraphics
 
     bool TextureFilter::GetVec3(const char* location, LibCore::Math::Vec3& data)
     {
-        auto it = vec3Values.find(location);
-        if (it == vec3Values.end())
+        auto it = uniformValues.Vec3s.find(location);
+        if (it == uniformValues.Vec3s.end())
             return false;
         data = it->second;
         return true;
@@ -143,14 +399,91 @@ namespace LibGraphics
 
     bool TextureFilter::GetVec2(const char* location, LibCore::Math::Vec2& data)
     {
-        auto it = vec2Values.find(location);
-        if (it == vec2Values.end())
+        auto it = uniformValues.Vec2s.find(location);
+        if (it == uniformValues.Vec2s.end())
             return false;
         data = it->second;
         return true;
     }
 
+    int TextureFilter::HaloRadius() const
+    {
+        // hysteresis on the worklist follows an edge across the whole image
+        if (cannyCompute)
+            return -1;
+
+        // per pixel, the output only depends on the texel under the fragment
+        static const char* POINT_SHADERS[] = {
+            BRIGHTNESS_SHADER, CONTRAST_SHADER, HSL_ADJUSTMENT_SHADER, TEMPERATURE_SHADER, GAMMA_SHADER,
+            GRAY_SCALE_SHADER, SEPIA_TONE_SHADER, POSTERISATION_SHADER, TOON_SHADER, BLOOM_SHADER,
+            XRAY_SHADER, NEON_GLOW_SHADER, NIGHT_VISION_SHADER, CANNY_EDGE_DETECT_THRESHOLD_SHADER
+        };
+        // fixed neighbourhoods in texels, offsets are divided by the texture size
+        static const std::pair<const char*, int> NEIGHBOURHOOD_SHADERS[] = {
+            { SHARPEN_SHADER, 1 }, { PREWITT_EDGE_DETECT_SHADER, 1 }, { ROBERTS_CROSS_EDGE_DETECT_SHADER, 1 },
+            { CANNY_EDGE_DETECT_BLUR_SHADER, 2 }, { CANNY_EDGE_DETECT_SOBEL_SHADER, 1 }, { CANNY_EDGE_DETECT_HYSTERIESIS_SHADER, 1 }
+        };
+
+        // scaled offsets land between texels, bilinear filtering reads one texel further
+        auto scaledRadius = [](float texels) { return static_cast<int>(std::ceil(std::fabs(texels))) + 1; };
+
+        int results = 0;
+        for (auto& source : fragmentSources)
+        {
+            int radius = -1;
+            if (std::find_if(std::begin(POINT_SHADERS), std::end(POINT_SHADERS), [&source](const char* shader) { return source == shader; }) != std::end(POINT_SHADERS))
+                radius = 0;
+            for (auto& shader : NEIGHBOURHOOD_SHADERS)
+            {
+                if (source == shader.first)
+                    radius = shader.second;
+            }
+
+            if (source == GAUSSIAN_BLUR_SHADER)
+            {
+                auto scale = uniformValues.Floats.find("uBlurScale");
+                radius = scaledRadius(scale == uniformValues.Floats.end() ? 1.0f : scale->second);
+            }
+            else if (source == EMBOSS_SHADER)
+            {
+                auto texelSize = uniformValues.Vec2s.find("uTexelSize");
+                radius = texelSize == uniformValues.Vec2s.end() ? scaledRadius(1.0f) : scaledRadius(std::max(std::fabs(texelSize->second.x), std::fabs(texelSize->second.y)));
+            }
+
+            if (radius < 0)
+                return -1;
+            results += radius;
+        }
+        return results;
+    }
+
+    uint64_t TextureFilter::ParameterHash(uint64_t seed) const
+    {
+        return uniformValues.Hash(seed);
+    }
+
+    void TextureFilter::Serialize(LibCore::Event::TraceWriter& writer) const
+    {
+        LibCore::Utils::FilterParameters::SerializeSources(writer, fragmentSources);
+        uniformValues.Serialize(writer);
+    }
+
+    std::shared_ptr<TextureFilter> TextureFilter::Deserialize(LibCore::Event::TraceReader& reader)
+    {
+        auto sources = LibCore::Utils::FilterParameters::DeserializeSources(reader);
+        if (sources.empty())
+            return nullptr;
+
+        auto results = CreateFromShaders(sources);
+        if (!results)
+            return nullptr;
+        return results->uniformValues.Deserialize(reader) ? results : nullptr;
+    }
+
 	TextureFilter::TextureFilter()
+        : layersFailed{ false }
+        , customPasses{ nullptr }
+        , residency{ 0 }
 	{
         // Define the quad vertices
         static float quadVertices[] = {
@@ -185,6 +518,7 @@ namespace LibGraphics
 
     TextureFilter::~TextureFilter()
     {
+        GPUMemory::Unregister(residency);
         glDeleteBuffers(1, &quadVBO);
         glDeleteVertexArrays(1, &quadVAO);
     }
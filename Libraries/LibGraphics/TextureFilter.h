@@ -1,11 +1,20 @@
 #pragma once
 
 #include <map>
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <utility>
+#include <functional>
 #include "Shader.h"
 #include "Texture.h"
 #include "FrameBuffer.h"
+#include "CannyCompute.h"
+#include "TextureArray.h"
+#include "GPUTimer.h"
+#include "GPUMemory.h"
+#include "LibCore/EventTrace.h"
+#include "LibCore/FilterParameters.h"
 
 namespace LibGraphics
 {
@@ -15,8 +24,16 @@ namespace LibGraphics
 		static std::shared_ptr<TextureFilter> CreateFromShader(const std::string& fragShader);
 		static std::shared_ptr<TextureFilter> CreateFromShaders(const std::vector<std::string>& fragShaders);
 		std::shared_ptr<Texture> Apply(const std::shared_ptr<Texture>& texture);
+		// builds the layered programs on first use; false if the filter only runs on single textures (pyramids,
+		// compute Canny) or its shaders do not build for sampler2DArray
+		bool PrepareLayers();
+		// every pass is one instanced draw over all layers, PrepareLayers() must have returned true
+		std::shared_ptr<TextureArray> ApplyLayers(const std::shared_ptr<TextureArray>& layers);
 		std::shared_ptr<TextureFilter> Clone() const;
 
+		// every Apply() becomes a sample of label with a query per pass, nullptr stops timing; clones are not timed
+		void SetTimer(const std::shared_ptr<GPUTimer>& timer, const std::string& label);
+
 		void SetInt(const char* location, int data);
 		void SetFloat(const char* location, float data);
 		void SetVec4(const char* location, const LibCore::Math::Vec4& data);
@@ -29,19 +46,56 @@ namespace LibGraphics
 		bool GetVec3(const char* location, LibCore::Math::Vec3& data);
 		bool GetVec2(const char* location, LibCore::Math::Vec2& data);
 
+		// texels a fragment reads around itself, summed over the passes; -1 if it may read anywhere or depends on
+		// where the fragment is in the image (TexCoord, gl_FragCoord, offsets in texture coordinates), such filters
+		// only give the same result on the whole image and cannot run on tiles
+		int HaloRadius() const;
+
+		// hash of every uniform name and value, chain filters through seed to hash a whole stack
+		uint64_t ParameterHash(uint64_t seed = 0) const;
+
+		// shader sources and uniform values, Deserialize compiles the shaders and needs a current GL context
+		void Serialize(LibCore::Event::TraceWriter& writer) const;
+		static std::shared_ptr<TextureFilter> Deserialize(LibCore::Event::TraceReader& reader);
+
 		~TextureFilter();
 
 	private:
 		TextureFilter();
+
+		// one pass of shader into a new texture of width x height; _PassIndex_ is passIndex, secondary is bound
+		// as texture2 and uniforms can override the filter's values for this pass
+		std::shared_ptr<Texture> RenderPass(
+			size_t shader,
+			int passIndex,
+			const std::shared_ptr<Texture>& input,
+			int width,
+			int height,
+			const std::function<void(const Shader&)>& uniforms = nullptr,
+			const std::shared_ptr<Texture>& secondary = nullptr);
+
+		void SetUniforms(const Shader& program, int passIndex, int width, int height) const;
+
+		// filters that are not a plain chain of their shaders (BlurShaders.h), picked by their sources
+		using CustomPasses = std::shared_ptr<Texture>(TextureFilter::*)(const std::shared_ptr<Texture>&);
+		std::shared_ptr<Texture> PyramidBlurPasses(const std::shared_ptr<Texture>& texture);
+		std::shared_ptr<Texture> PyramidBloomPasses(const std::shared_ptr<Texture>& texture);
+		std::shared_ptr<Texture> ComputeCannyPasses(const std::shared_ptr<Texture>& texture);
+
 		unsigned int quadVAO, quadVBO;
 		std::vector<std::shared_ptr<Shader>> shaders;
-		std::shared_ptr<FrameBuffer> framebuffer;
+		std::vector<std::shared_ptr<Shader>> layerShaders;	// same passes on sampler2DArray, see PrepareLayers()
+		bool layersFailed;
+		std::vector<std::string> fragmentSources;
+		CustomPasses customPasses;
+		std::shared_ptr<CannyCompute> cannyCompute;
+		std::shared_ptr<GPUTimer> timer;
+		std::string timerLabel;
+		// one per target size, pyramids render into several; dropped when the input size changes
+		std::map<std::pair<int, int>, std::shared_ptr<FrameBuffer>> framebuffers;
+		GPUMemory::Handle residency;	// of framebuffers, 0 while there are none registered
 
 		// variables
-		std::map<std::string, int> intValues;
-		std::map<std::string, float> floatValues;
-		std::map<std::string, LibCore::Math::Vec2> vec2Values;
-		std::map<std::string, LibCore::Math::Vec3> vec3Values;
-		std::map<std::string, LibCore::Math::Vec4> vec4Values;
+		LibCore::Utils::FilterParameters uniformValues;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,111 @@
+#include "TileGrid.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace LibGraphics
+{
+	std::shared_ptr<TileGrid> TileGrid::Create(int width, int height, int halo, int maxTileSize)
+	{
+		if (width <= 0 || height <= 0 || halo < 0 || maxTileSize - 2 * halo <= 0)
+			return nullptr;
+
+		auto results = std::shared_ptr<TileGrid>{ new TileGrid{} };
+		results->width = width;
+		results->height = height;
+		results->halo = halo;
+		results->tileWidth = std::min(width, maxTileSize - 2 * halo);
+		results->tileHeight = std::min(height, maxTileSize - 2 * halo);
+
+		// the last tile of a row or column is moved back to end on the image edge
+		for (int y = 0; y < height; y += results->tileHeight)
+		{
+			for (int x = 0; x < width; x += results->tileWidth)
+				results->tiles.push_back(Tile{ std::min(x, width - results->tileWidth), std::min(y, height - results->tileHeight) });
+		}
+		return results;
+	}
+
+	const std::vector<TileGrid::Tile>& TileGrid::Tiles() const
+	{
+		return tiles;
+	}
+
+	int TileGrid::GetTileWidth() const
+	{
+		return tileWidth;
+	}
+
+	int TileGrid::GetTileHeight() const
+	{
+		return tileHeight;
+	}
+
+	int TileGrid::GetPaddedWidth() const
+	{
+		return tileWidth + 2 * halo;
+	}
+
+	int TileGrid::GetPaddedHeight() const
+	{
+		return tileHeight + 2 * halo;
+	}
+
+	std::vector<unsigned char> TileGrid::Extract(const std::vector<char>& pixels, int channels, const Tile& tile) const
+	{
+		const int paddedWidth = GetPaddedWidth(), paddedHeight = GetPaddedHeight();
+		const size_t rowSize = static_cast<size_t>(width) * channels;
+		auto wrap = [](int index, int size) { return ((index % size) + size) % size; };
+
+		std::vector<unsigned char> results(static_cast<size_t>(paddedWidth) * paddedHeight * channels);
+		for (int y = 0; y < paddedHeight; ++y)
+		{
+			const char* row = pixels.data() + wrap(tile.Y - halo + y, height) * rowSize;
+			unsigned char* out = results.data() + static_cast<size_t>(y) * paddedWidth * channels;
+
+			// runs of the padded row that do not cross the image edge are copied at once
+			for (int x = 0; x < paddedWidth;)
+			{
+				const int source = wrap(tile.X - halo + x, width);
+				const int run = std::min(paddedWidth - x, width - source);
+				std::memcpy(out + static_cast<size_t>(x) * channels, row + static_cast<size_t>(source) * channels, static_cast<size_t>(run) * channels);
+				x += run;
+			}
+		}
+		return results;
+	}
+
+	void TileGrid::Store(const std::vector<unsigned char>& padded, int channels, bool swapRedBlue, const Tile& tile, std::vector<char>& pixels) const
+	{
+		const int paddedWidth = GetPaddedWidth();
+		for (int y = 0; y < tileHeight; ++y)
+		{
+			const unsigned char* in = padded.data() + (static_cast<size_t>(y + halo) * paddedWidth + halo) * channels;
+			char* out = pixels.data() + (static_cast<size_t>(tile.Y + y) * width + tile.X) * channels;
+			if (!swapRedBlue || channels < 3)
+			{
+				std::memcpy(out, in, static_cast<size_t>(tileWidth) * channels);
+				continue;
+			}
+
+			for (int x = 0; x < tileWidth; ++x, in += channels, out += channels)
+			{
+				out[0] = static_cast<char>(in[2]);
+				out[1] = static_cast<char>(in[1]);
+				out[2] = static_cast<char>(in[0]);
+				if (channels == 4)
+					out[3] = static_cast<char>(in[3]);
+			}
+		}
+	}
+
+	TileGrid::TileGrid()
+		: width{ 0 }
+		, height{ 0 }
+		, halo{ 0 }
+		, tileWidth{ 0 }
+		, tileHeight{ 0 }
+	{
+
+	}
+}
\ No newline at end of file
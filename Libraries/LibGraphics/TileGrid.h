@@ -0,0 +1,41 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+namespace LibGraphics
+{
+	// Splits an image too large for one texture into tiles, each uploaded with a halo of texels around it so
+	// filters that read their neighbours (TextureFilter::HaloRadius) see the same texels as on the whole image.
+	// Texels past the image edges wrap around like GL_REPEAT. Every tile has the same padded size, the last
+	// column and row overlap their neighbours instead of shrinking, so the framebuffers are never recreated.
+	class TileGrid
+	{
+	public:
+		struct Tile
+		{
+			int X, Y;	// first texel of the interior in the image
+		};
+
+		// nullptr if the halo leaves no interior within maxTileSize
+		static std::shared_ptr<TileGrid> Create(int width, int height, int halo, int maxTileSize);
+
+		const std::vector<Tile>& Tiles() const;
+		int GetTileWidth() const;		// interior
+		int GetTileHeight() const;
+		int GetPaddedWidth() const;		// interior plus the halo on both sides, the size of the texture
+		int GetPaddedHeight() const;
+
+		// the padded tile out of tightly packed rows of the whole image
+		std::vector<unsigned char> Extract(const std::vector<char>& pixels, int channels, const Tile& tile) const;
+		// writes the interior of a padded tile into the whole image, swapRedBlue for RGB read back into BGR
+		void Store(const std::vector<unsigned char>& padded, int channels, bool swapRedBlue, const Tile& tile, std::vector<char>& pixels) const;
+
+	private:
+		TileGrid();
+
+		int width, height, halo;
+		int tileWidth, tileHeight;
+		std::vector<Tile> tiles;
+	};
+}
\ No newline at end of file
@@ -1,7 +1,12 @@
 #include "LibCore/EventSystem.h"
+#include "LibCore/EventTrace.h"
+#include "LibCore/EventReplay.h"
 #include "LibCore/Path.h"
 
+#include "ImageProcessor.h"
+
 #include <vector>
+#include <string>
 
 namespace Event
 {
@@ -18,10 +23,135 @@ namespace Event
 
 	struct DragDropFiles : LibCore::Event::Event
 	{
+		// each drop replaces the thumbnails, so only the latest batch matters
+		static constexpr bool COALESCE = true;
+
 		DragDropFiles(const std::vector<LibCore::Filesystem::Path>& paths)
 			: Paths{ paths }
 		{}
 
 		std::vector<LibCore::Filesystem::Path> Paths;
+
+		static constexpr const char* TRACE_NAME = "DragDropFiles";
+		void Serialize(LibCore::Event::TraceWriter& writer) const
+		{
+			writer.Write(static_cast<uint32_t>(Paths.size()));
+			for (auto& path : Paths)
+				writer.WriteString(path.String());
+		}
+
+		static DragDropFiles Deserialize(LibCore::Event::TraceReader& reader)
+		{
+			std::vector<LibCore::Filesystem::Path> paths(reader.Read<uint32_t>());
+			for (auto& path : paths)
+				path = LibCore::Filesystem::Path{ reader.ReadString().c_str() };
+			return DragDropFiles{ paths };
+		}
+	};
+
+	// UISettings slider moved, applied to the ImageProcessor by its listener
+	struct ImageSettingChanged : LibCore::Event::Event
+	{
+		ImageSettingChanged(ImageProcessor::IMAGE_SETTINGS setting, float value)
+			: Setting{ setting }
+			, Value{ value }
+		{}
+
+		ImageProcessor::IMAGE_SETTINGS Setting;
+		float Value;
+
+		static constexpr const char* TRACE_NAME = "ImageSettingChanged";
+		void Serialize(LibCore::Event::TraceWriter& writer) const
+		{
+			writer.Write(static_cast<int32_t>(Setting));
+			writer.Write(Value);
+		}
+
+		static ImageSettingChanged Deserialize(LibCore::Event::TraceReader& reader)
+		{
+			const auto setting = static_cast<ImageProcessor::IMAGE_SETTINGS>(reader.Read<int32_t>());
+			return ImageSettingChanged{ setting, reader.Read<float>() };
+		}
+	};
+
+	struct ImageSettingsReset : LibCore::Event::Event
+	{
+		static constexpr const char* TRACE_NAME = "ImageSettingsReset";
+		void Serialize(LibCore::Event::TraceWriter& writer) const {}
+		static ImageSettingsReset Deserialize(LibCore::Event::TraceReader& reader) { return {}; }
+	};
+
+	// Starts a batch export of the given images
+	struct ApplyToImages : LibCore::Event::Event
+	{
+		ApplyToImages(const std::vector<std::string>& files, const std::string& saveDirectory, bool logPoolMetrics, unsigned workerProcesses)
+			: Files{ files }
+			, SaveDirectory{ saveDirectory }
+			, LogPoolMetrics{ logPoolMetrics }
+			, WorkerProcesses{ workerProcesses }
+		{}
+
+		std::vector<std::string> Files;
+		std::string SaveDirectory;
+		bool LogPoolMetrics;
+		unsigned WorkerProcesses;	// 0 exports in this process
+
+		static constexpr const char* TRACE_NAME = "ApplyToImages";
+		void Serialize(LibCore::Event::TraceWriter& writer) const
+		{
+			writer.Write(static_cast<uint32_t>(Files.size()));
+			for (auto& file : Files)
+				writer.WriteString(file);
+			writer.WriteString(SaveDirectory);
+			writer.Write(static_cast<uint8_t>(LogPoolMetrics));
+			writer.Write(static_cast<uint8_t>(WorkerProcesses));
+		}
+
+		static ApplyToImages Deserialize(LibCore::Event::TraceReader& reader)
+		{
+			std::vector<std::string> files(reader.Read<uint32_t>());
+			for (auto& file : files)
+				file = reader.ReadString();
+			auto saveDirectory = reader.ReadString();
+			const bool logPoolMetrics = reader.Read<uint8_t>() != 0;
+			// traces recorded before worker processes existed end here
+			const unsigned workerProcesses = reader.AtEnd() ? 0 : reader.Read<uint8_t>();
+			return ApplyToImages{ files, saveDirectory, logPoolMetrics, workerProcesses };
+		}
 	};
+
+	// Starts watching a folder and processing images as they land, an empty Directory stops watching
+	struct WatchFolder : LibCore::Event::Event
+	{
+		WatchFolder(const std::string& directory, const std::string& saveDirectory)
+			: Directory{ directory }
+			, SaveDirectory{ saveDirectory }
+		{}
+
+		std::string Directory;
+		std::string SaveDirectory;
+
+		static constexpr const char* TRACE_NAME = "WatchFolder";
+		void Serialize(LibCore::Event::TraceWriter& writer) const
+		{
+			writer.WriteString(Directory);
+			writer.WriteString(SaveDirectory);
+		}
+
+		static WatchFolder Deserialize(LibCore::Event::TraceReader& reader)
+		{
+			auto directory = reader.ReadString();
+			return WatchFolder{ directory, reader.ReadString() };
+		}
+	};
+
+	// Registers every traceable event above for replay
+	inline void RegisterReplayEvents(LibCore::Event::EventReplayer& replayer)
+	{
+		replayer.Register<DragDropFiles>();
+		replayer.Register<ImageSettingChanged>();
+		replayer.Register<ImageSettingsReset>();
+		replayer.Register<ApplyToImages>();
+		replayer.Register<WatchFolder>();
+	}
 }
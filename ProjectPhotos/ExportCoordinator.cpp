@@ -0,0 +1,418 @@
+#include "ExportCoordinator.h"
+
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+#include <filesystem>
+
+#include "LibCore/Parallel.h"
+#include "LibCore/MainThreadExecutor.h"
+#include "LibGraphics/Texture.h"
+#include "LibGraphics/OffscreenContext.h"
+#include "ImageProcessingExecutor.h"
+
+#define MAX_WORKER_ATTEMPTS 3
+#define WORKER_IDLE_MS 1
+#define WORKER_RECORD_PREFIX "@EXPORT RECORD "
+#define WORKER_FINISHED "@EXPORT FINISHED"
+
+#define WORKER_EXIT_BAD_SHARD 2
+#define WORKER_EXIT_BAD_PRESET 4
+
+// A worker's stdout is its channel to the coordinator. RunWorker points std::cout at stderr, so diagnostics
+// from any thread go there, and protocol lines are written whole, one at a time, to the real stdout here.
+static std::mutex workerProtocolMutex;
+static std::streambuf* workerProtocolBuffer = nullptr;
+
+static void WriteProtocolLine(const std::string& line)
+{
+	std::lock_guard<std::mutex> lock{ workerProtocolMutex };
+	std::ostream protocol{ workerProtocolBuffer };
+	protocol << line << '\n';
+	protocol.flush();
+}
+
+std::shared_ptr<ExportCoordinator> ExportCoordinator::Start(
+	const std::shared_ptr<ImageProcessor>& processor,
+	const std::vector<LibCore::Filesystem::File>& imageFiles,
+	const LibCore::Filesystem::Directory& saveDirectory,
+	unsigned workerCount)
+{
+	auto results = std::shared_ptr<ExportCoordinator>(new ExportCoordinator{});
+
+	if (!saveDirectory.Exists())
+		saveDirectory.Create();
+
+	std::error_code ec;
+	const auto workDirectory = std::filesystem::temp_directory_path(ec) / ("PhotoLite_Export_" + std::to_string(ImageProcessingExecutor::NowMicros()));
+	if (ec || !std::filesystem::create_directories(workDirectory, ec))
+		return nullptr;
+
+	results->saveDirectory = saveDirectory;
+	results->workDirectory = workDirectory.string();
+	results->presetPath = (workDirectory / "preset.bin").string();
+	results->executable = LibCore::Utils::Process::CurrentExecutable();
+	if (results->executable.empty() || !processor->SavePreset(LibCore::Filesystem::File{ results->presetPath.c_str() }))
+		return nullptr;
+
+	// workers only read the journal, every record goes through here
+	results->journal = LibCore::Filesystem::JobJournal::Open(ImageProcessingExecutor::JournalFile(saveDirectory), {});
+
+	// output names are decided here, workers cannot see each other's names
+	workerCount = std::max(workerCount, 1U);
+	results->shards.resize(workerCount);
+	std::unordered_set<std::string> scheduledPaths, outputNames;
+	for (auto& file : imageFiles)
+	{
+		const auto canonicalPath = std::filesystem::weakly_canonical(std::filesystem::path{ file.FilePath().String() }, ec);
+		if (!file.Exists() || !scheduledPaths.insert(ec ? file.FilePath().String() : canonicalPath.string()).second)
+			continue;
+
+		// interleaved, so every shard gets a similar mix of image sizes
+		auto& shard = results->shards[results->totalImages++ % workerCount];
+		shard.Images.push_back(ShardImage{ file.FilePath().String(), ImageProcessingExecutor::UniqueOutputName(file, outputNames) });
+		shard.Remaining.insert(shard.Images.back().OutputName);
+	}
+
+	results->shards.erase(
+		std::remove_if(results->shards.begin(), results->shards.end(), [](const Shard& shard) { return shard.Images.empty(); }),
+		results->shards.end());
+	const unsigned cores = std::max(std::thread::hardware_concurrency(), 3U) - 1;	// one core left for this process
+	results->coresPerWorker = std::max(cores / std::max(static_cast<unsigned>(results->shards.size()), 1U), 2U);
+
+	for (size_t i = 0; i < results->shards.size(); ++i)
+	{
+		auto& shard = results->shards[i];
+		if (!results->Launch(shard, i))
+		{
+			results->CompleteRemaining(shard);
+			shard.Finished = true;
+		}
+	}
+
+	std::cout << "[Export] " << results->totalImages << " images across " << results->shards.size()
+		<< " worker processes, " << results->coresPerWorker << " cores each" << std::endl;
+	return results;
+}
+
+ExportCoordinator::ExportCoordinator()
+	: saveDirectory{ }
+	, workDirectory{ }
+	, presetPath{ }
+	, executable{ }
+	, journal{ nullptr }
+	, shards{ }
+	, coresPerWorker{ 2 }
+	, totalImages{ 0 }
+	, completedImages{ 0 }
+	, failedImages{ 0 }
+	, restartedWorkers{ 0 }
+{
+
+}
+
+ExportCoordinator::~ExportCoordinator()
+{
+	for (auto& shard : shards)
+		shard.Worker = nullptr;
+
+	std::error_code ec;
+	if (!workDirectory.empty())
+		std::filesystem::remove_all(workDirectory, ec);
+
+	if (failedImages)
+		std::cout << "[Export] " << failedImages << " images failed" << std::endl;
+	if (restartedWorkers)
+		std::cout << "[Export] " << restartedWorkers << " workers restarted" << std::endl;
+}
+
+void ExportCoordinator::Update()
+{
+	for (size_t i = 0; i < shards.size(); ++i)
+	{
+		auto& shard = shards[i];
+		if (shard.Finished || !shard.Worker)
+			continue;
+
+		// checked before taking the lines, an exited worker has nothing left in flight
+		const bool running = shard.Worker->Running();
+		for (auto& line : shard.Worker->TakeLines())
+			HandleLine(shard, i, line);
+		if (running)
+			continue;
+
+		if (!shard.Remaining.empty() && !shard.Reported)
+		{
+			std::cout << "[Export] worker " << i << " exited with " << shard.Worker->ExitCode()
+				<< ", " << shard.Remaining.size() << " images left" << std::endl;
+			if (shard.Attempts < MAX_WORKER_ATTEMPTS && Launch(shard, i))
+			{
+				++restartedWorkers;
+				continue;
+			}
+		}
+
+		// a finished worker leaves only images it had nothing to report for (e.g. missing inputs)
+		CompleteRemaining(shard);
+		shard.Worker = nullptr;
+		shard.Finished = true;
+	}
+}
+
+bool ExportCoordinator::Launch(Shard& shard, size_t index)
+{
+	// only what is left, a restarted worker does not redo reported images
+	std::ostringstream manifest;
+	manifest << "PRESET\t" << presetPath << "\n"
+		<< "OUTPUT\t" << saveDirectory.String() << "\n"
+		<< "CORES\t" << coresPerWorker << "\n";
+	for (auto& image : shard.Images)
+	{
+		if (shard.Remaining.count(image.OutputName))
+			manifest << "IMAGE\t" << image.InputPath << "\t" << image.OutputName << "\n";
+	}
+
+	const std::string shardPath = workDirectory + "/shard_" + std::to_string(index) + ".txt";
+	if (!LibCore::Filesystem::File{ shardPath.c_str() }.Write(manifest.str()))
+		return false;
+
+	++shard.Attempts;
+	shard.Reported = false;
+	shard.Worker = LibCore::Utils::Process::Start(executable, { "--export-worker", shardPath });
+	return shard.Worker != nullptr;
+}
+
+void ExportCoordinator::HandleLine(Shard& shard, size_t index, const std::string& line)
+{
+	static const std::string recordPrefix = WORKER_RECORD_PREFIX;
+	if (line.compare(0, recordPrefix.size(), recordPrefix) == 0)
+	{
+		LibCore::Filesystem::JobJournal::Record record;
+		if (!LibCore::Filesystem::JobJournal::Parse(line.substr(recordPrefix.size()), record))
+			return;
+
+		if (journal)
+			journal->Append(record.Status, record.Input, record.PresetHash, record.Output);
+		if (shard.Remaining.erase(record.Output))
+		{
+			++completedImages;
+			if (record.Status != LibCore::Filesystem::JobJournal::STATUS::DONE)
+				++failedImages;
+		}
+	}
+	else if (line == WORKER_FINISHED)
+	{
+		shard.Reported = true;
+	}
+	else
+	{
+		std::cout << "[Worker " << index << "] " << line << std::endl;
+	}
+}
+
+void ExportCoordinator::CompleteRemaining(Shard& shard)
+{
+	completedImages += static_cast<unsigned>(shard.Remaining.size());
+	failedImages += static_cast<unsigned>(shard.Remaining.size());
+	shard.Remaining.clear();
+}
+
+bool ExportCoordinator::Completed() const
+{
+	return std::all_of(shards.begin(), shards.end(), [](const Shard& shard) { return shard.Finished; });
+}
+
+float ExportCoordinator::PercentageCompleted() const
+{
+	return totalImages ? 100.0f * ((float)completedImages / (float)totalImages) : 100.0f;
+}
+
+unsigned ExportCoordinator::CompletedImages() const
+{
+	return completedImages;
+}
+
+unsigned ExportCoordinator::FailedImages() const
+{
+	return failedImages;
+}
+
+unsigned ExportCoordinator::RunningWorkers() const
+{
+	return static_cast<unsigned>(std::count_if(shards.begin(), shards.end(), [](const Shard& shard) {
+		return shard.Worker && shard.Worker->Running();
+	}));
+}
+
+unsigned ExportCoordinator::RestartedWorkers() const
+{
+	return restartedWorkers;
+}
+
+int ExportCoordinator::RunWorker(const std::string& shardPath)
+{
+	workerProtocolBuffer = std::cout.rdbuf(std::cerr.rdbuf());
+
+	std::string presetFile, outputDirectory;
+	unsigned cores = 0;
+	std::vector<ShardImage> images;
+
+	std::istringstream manifest{ LibCore::Filesystem::File{ shardPath.c_str() }.ReadText() };
+	for (std::string line; std::getline(manifest, line);)
+	{
+		const size_t tab = line.find('\t');
+		if (tab == std::string::npos)
+			continue;
+
+		const std::string key = line.substr(0, tab), value = line.substr(tab + 1);
+		if (key == "PRESET")
+			presetFile = value;
+		else if (key == "OUTPUT")
+			outputDirectory = value;
+		else if (key == "CORES")
+		{
+			try
+			{
+				cores = static_cast<unsigned>(std::stoul(value));
+			}
+			catch (const std::exception&)
+			{
+				std::cerr << "Invalid core count " << value << ", sizing the pools from the machine" << std::endl;
+			}
+		}
+		else if (key == "IMAGE" && value.find('\t') != std::string::npos)
+			images.push_back(ShardImage{ value.substr(0, value.find('\t')), value.substr(value.find('\t') + 1) });
+	}
+
+	if (presetFile.empty() || outputDirectory.empty())
+	{
+		std::cerr << "Invalid export shard " << shardPath << std::endl;
+		return WORKER_EXIT_BAD_SHARD;
+	}
+
+	// no window, workers also run on machines without a display when EGL or OSMesa is built in
+	auto context = LibGraphics::OffscreenContext::Create();
+	if (!context)
+	{
+		std::cerr << "Export worker has no GL context, exporting on the CPU" << std::endl;
+		return RunCPUWorker(presetFile, outputDirectory, cores, images);
+	}
+	std::cerr << "GL context: " << context->Backend() << ", " << context->Renderer() << std::endl;
+
+	auto processor = std::make_shared<ImageProcessor>();
+	if (!processor->LoadPreset(LibCore::Filesystem::File{ presetFile.c_str() }))
+		return WORKER_EXIT_BAD_PRESET;
+
+	// records arrive on pool threads and are sent from this one
+	std::mutex recordMutex;
+	std::vector<std::string> records;
+	auto emitRecords = [&recordMutex, &records]() {
+		std::vector<std::string> pending;
+		{
+			std::lock_guard<std::mutex> lock{ recordMutex };
+			std::swap(pending, records);
+		}
+		for (auto& record : pending)
+			WriteProtocolLine(WORKER_RECORD_PREFIX + record);
+	};
+
+	auto mainThread = std::make_shared<LibCore::Async::MainThreadExecutor>();
+	auto executor = ImageProcessingExecutor::Run(
+		processor,
+		{},
+		LibCore::Filesystem::Directory{ outputDirectory.c_str() },
+		mainThread,
+		false,
+		[&recordMutex, &records](const std::string& line) {
+			std::lock_guard<std::mutex> lock{ recordMutex };
+			records.push_back(line);
+		});
+	if (cores)
+		executor->SetCoreBudget(cores);
+
+	const uint64_t now = ImageProcessingExecutor::NowMicros();
+	for (auto& image : images)
+		executor->Add(LibCore::Filesystem::File{ image.InputPath.c_str() }, now, image.OutputName);
+
+	// no frames to present, the GL stages run back to back
+	while (!executor->Completed())
+	{
+		const size_t executed = mainThread->ProcessTasks();
+		executor->Update();
+		emitRecords();
+		if (executed == 0)
+			std::this_thread::sleep_for(std::chrono::milliseconds{ WORKER_IDLE_MS });
+	}
+
+	executor = nullptr;
+	emitRecords();
+	WriteProtocolLine(WORKER_FINISHED);
+	return 0;
+}
+
+int ExportCoordinator::RunCPUWorker(
+	const std::string& presetFile,
+	const std::string& outputDirectory,
+	unsigned cores,
+	const std::vector<ShardImage>& images)
+{
+	CPUPreset preset;
+	if (!ImageProcessor::LoadCPUPreset(LibCore::Filesystem::File{ presetFile.c_str() }, preset))
+		return WORKER_EXIT_BAD_PRESET;
+
+	// records come from pool threads, each is written as a whole
+	LibCore::Filesystem::JobJournal::Options journalOptions;
+	journalOptions.Forward = [](const std::string& line) {
+		WriteProtocolLine(WORKER_RECORD_PREFIX + line);
+	};
+	const LibCore::Filesystem::Directory directory{ outputDirectory.c_str() };
+	auto journal = LibCore::Filesystem::JobJournal::Open(ImageProcessingExecutor::JournalFile(directory), journalOptions);
+
+	// images are spread over the pool and every filter splits its rows over the same pool, the waiting threads help
+	LibCore::Async::ThreadPool pool{ cores ? cores : std::max(1u, std::thread::hardware_concurrency()) };
+	LibCore::Async::ParallelFor(pool, LibCore::Async::Range{ 0, images.size() }, 1, [&](const LibCore::Async::Range& range) {
+		for (size_t i = range.Begin; i < range.End; ++i)
+		{
+			const auto& shardImage = images[i];
+			const LibCore::Filesystem::File file{ shardImage.InputPath.c_str() };
+			const std::string savePath = (std::filesystem::path{ outputDirectory } / shardImage.OutputName).string();
+			const auto fingerprint = file.Fingerprint();
+
+			bool saved = journal && fingerprint.Valid && journal->IsCompleted(shardImage.OutputName, fingerprint, preset.Hash);
+			if (!saved)
+			{
+				auto image = LibCV::Image::Create(file);
+				if (image && !image->Empty())
+				{
+					image = ImageProcessor::ApplyCPUPreset(preset, LibCV::ImageFX::AutoEnhance(image, preset.FXFlags), pool);
+
+					// same encoder as the GL path, which reads back RGB
+					auto imageData = image->GetImageData();
+					std::vector<unsigned char> pixels(imageData.Pixels.begin(), imageData.Pixels.end());
+					for (size_t p = 0; p + 2 < pixels.size(); p += 3)
+						std::swap(pixels[p], pixels[p + 2]);
+					saved = LibGraphics::Texture::SavePixels(savePath, imageData.ImageWidth, imageData.ImageHeight, 3, pixels);
+				}
+
+				if (!saved)
+					std::cerr << "Failed to process " << shardImage.InputPath << std::endl;
+			}
+
+			if (journal && fingerprint.Valid)
+			{
+				journal->Append(
+					saved ? LibCore::Filesystem::JobJournal::STATUS::DONE : LibCore::Filesystem::JobJournal::STATUS::FAILED,
+					fingerprint,
+					preset.Hash,
+					shardImage.OutputName);
+			}
+		}
+	});
+
+	journal = nullptr;
+	WriteProtocolLine(WORKER_FINISHED);
+	return 0;
+}
\ No newline at end of file
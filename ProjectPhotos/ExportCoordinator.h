@@ -0,0 +1,77 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_set>
+#include "LibCore/File.h"
+#include "LibCore/Directory.h"
+#include "LibCore/Process.h"
+#include "LibCore/JobJournal.h"
+#include "ImageProcessor.h"
+
+// Splits an export across worker processes (this executable with --export-worker), each with its own
+// offscreen GL context and pools, so filter passes and readbacks are no longer serialised on one GL thread.
+// Workers report finished outputs over their stdout, the coordinator owns the export's journal,
+// and a shard whose worker dies is handed to a new worker with only its unfinished images.
+class ExportCoordinator
+{
+public:
+	static std::shared_ptr<ExportCoordinator> Start(
+		const std::shared_ptr<ImageProcessor>& processor,
+		const std::vector<LibCore::Filesystem::File>& imageFiles,
+		const LibCore::Filesystem::Directory& saveDirectory,
+		unsigned workerCount);
+	~ExportCoordinator();	// kills workers still running
+
+	// main thread, collects worker reports and restarts crashed workers
+	void Update();
+	bool Completed() const;
+	float PercentageCompleted() const;
+	unsigned CompletedImages() const;
+	unsigned FailedImages() const;
+	unsigned RunningWorkers() const;
+	unsigned RestartedWorkers() const;
+
+	// entry point of a worker process, returns its exit code
+	static int RunWorker(const std::string& shardPath);
+
+private:
+	ExportCoordinator();
+	ExportCoordinator(const ExportCoordinator&) = delete;
+	ExportCoordinator& operator=(const ExportCoordinator&) = delete;
+
+	struct ShardImage
+	{
+		std::string InputPath;
+		std::string OutputName;
+	};
+
+	struct Shard
+	{
+		std::vector<ShardImage> Images;
+		std::unordered_set<std::string> Remaining;	// output names not reported yet
+		std::shared_ptr<LibCore::Utils::Process> Worker;
+		unsigned Attempts;
+		bool Reported;		// worker said it finished, anything left had nothing to report
+		bool Finished;
+	};
+
+	// the worker body for machines without a GL context, the preset runs through LibCV::CPUFilter
+	static int RunCPUWorker(
+		const std::string& presetFile,
+		const std::string& outputDirectory,
+		unsigned cores,
+		const std::vector<ShardImage>& images);
+
+	bool Launch(Shard& shard, size_t index);
+	void HandleLine(Shard& shard, size_t index, const std::string& line);
+	void CompleteRemaining(Shard& shard);
+
+	LibCore::Filesystem::Directory saveDirectory;
+	std::string workDirectory, presetPath, executable;
+	std::shared_ptr<LibCore::Filesystem::JobJournal> journal;
+	std::vector<Shard> shards;
+	unsigned coresPerWorker;
+	unsigned totalImages, completedImages, failedImages, restartedWorkers;
+};
\ No newline at end of file
@@ -22,6 +22,7 @@
 
 #include "LibCore/ThreadPool.h"
 #include "LibCore/EventSystem.h"
+#include "LibCore/MainThreadExecutor.h"
 
 struct PanelSharedData
 {
@@ -29,6 +30,8 @@ struct PanelSharedData
 	std::shared_ptr<LibGraphics::Application> Application;
 	std::shared_ptr<LibCore::Event::EventSystem> EvtSystem;
 	std::shared_ptr<LibCore::Async::ThreadPool> ThreadPool;
+	std::shared_ptr<LibCore::Async::MainThreadExecutor> MainThread;	// GL work, drained once per frame
+	bool BatchRunning = false;	// a batch export is in progress
 };
 
 class UIHeader
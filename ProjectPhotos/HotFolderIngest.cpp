@@ -0,0 +1,100 @@
+#include "HotFolderIngest.h"
+
+#include <iostream>
+
+#define HOT_FOLDER_SETTLE_MS 750
+#define HOT_FOLDER_POLL_INTERVAL_MS 500
+
+std::shared_ptr<HotFolderIngest> HotFolderIngest::Start(
+	const std::shared_ptr<ImageProcessor>& processor,
+	const LibCore::Filesystem::Directory& watchDirectory,
+	const LibCore::Filesystem::Directory& saveDirectory,
+	const std::shared_ptr<LibCore::Async::MainThreadExecutor>& mainThread)
+{
+	auto results = std::shared_ptr<HotFolderIngest>(new HotFolderIngest{});
+
+	LibCore::Filesystem::DirectoryWatcher::Options options;
+	options.SettleMs = HOT_FOLDER_SETTLE_MS;
+	options.PollIntervalMs = HOT_FOLDER_POLL_INTERVAL_MS;
+	options.Extensions = { ".jpeg", ".jpg", ".png" };
+
+	results->watchDirectory = watchDirectory;
+	results->watcher = LibCore::Filesystem::DirectoryWatcher::Create(watchDirectory, options);
+	if (!results->watcher)
+		return nullptr;
+
+	// an empty executor that grows as files arrive
+	results->executor = ImageProcessingExecutor::Run(processor, {}, saveDirectory, mainThread);
+	// a camera or another machine may still rewrite a file after it settled, a mapping would fault on truncation
+	results->executor->SetInputMode(LibCore::Filesystem::MAP_MODE::READ);
+
+	std::cout << "[HotFolder] Watching " << watchDirectory.String()
+		<< (results->watcher->UsingNotifications() ? " (notifications)" : " (polling)")
+		<< ", saving to " << saveDirectory.String() << std::endl;
+	return results;
+}
+
+HotFolderIngest::HotFolderIngest()
+	: watchDirectory{ }
+	, watcher{ nullptr }
+	, executor{ nullptr }
+	, receivedImages{ 0 }
+{
+
+}
+
+HotFolderIngest::~HotFolderIngest()
+{
+	// stop taking new files before the executor cancels what is in flight
+	if (watcher)
+		watcher->Stop();
+}
+
+void HotFolderIngest::Update()
+{
+	for (auto& ready : watcher->TakeReadyFiles())
+	{
+		// latency is measured from detection so the settle time counts towards it
+		if (executor->Add(ready.WatchedFile, ready.DetectedMicros))
+			++receivedImages;
+		else
+			std::cout << "[HotFolder] Skipped " << ready.WatchedFile.FileName() << ", already processed" << std::endl;
+	}
+
+	executor->Update();
+}
+
+const LibCore::Filesystem::Directory& HotFolderIngest::WatchDirectory() const
+{
+	return watchDirectory;
+}
+
+bool HotFolderIngest::UsingNotifications() const
+{
+	return watcher->UsingNotifications();
+}
+
+unsigned HotFolderIngest::ReceivedImages() const
+{
+	return receivedImages;
+}
+
+unsigned HotFolderIngest::CompletedImages() const
+{
+	return executor->CompletedImages();
+}
+
+bool HotFolderIngest::Idle() const
+{
+	return executor->Completed();
+}
+
+const LibCore::Async::LatencyHistogram& HotFolderIngest::ImageLatency() const
+{
+	return executor->ImageLatency();
+}
+
+float HotFolderIngest::ImagesPerSecond() const
+{
+	return executor->ImagesPerSecond();
+}
\ No newline at end of file
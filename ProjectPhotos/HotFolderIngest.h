@@ -0,0 +1,44 @@
+#pragma once
+
+#include <memory>
+#include "LibCore/Directory.h"
+#include "LibCore/DirectoryWatcher.h"
+#include "LibCore/MainThreadExecutor.h"
+#include "ImageProcessingExecutor.h"
+#include "ImageProcessor.h"
+
+// Watch mode: images that land in a folder (e.g. from a tethered camera) go through the
+// AutoEnhance + filter stack captured when watching started, without any user action.
+class HotFolderIngest
+{
+public:
+	static std::shared_ptr<HotFolderIngest> Start(
+		const std::shared_ptr<ImageProcessor>& processor,
+		const LibCore::Filesystem::Directory& watchDirectory,
+		const LibCore::Filesystem::Directory& saveDirectory,
+		const std::shared_ptr<LibCore::Async::MainThreadExecutor>& mainThread);
+	~HotFolderIngest();
+
+	// main thread, hands settled files to the executor and collects finished images
+	void Update();
+
+	const LibCore::Filesystem::Directory& WatchDirectory() const;
+	bool UsingNotifications() const;
+	unsigned ReceivedImages() const;
+	unsigned CompletedImages() const;
+	bool Idle() const;
+
+	// detected -> saved, and images per second since the first arrival
+	const LibCore::Async::LatencyHistogram& ImageLatency() const;
+	float ImagesPerSecond() const;
+
+private:
+	HotFolderIngest();
+	HotFolderIngest(const HotFolderIngest&) = delete;
+	HotFolderIngest& operator=(const HotFolderIngest&) = delete;
+
+	LibCore::Filesystem::Directory watchDirectory;
+	std::shared_ptr<LibCore::Filesystem::DirectoryWatcher> watcher;
+	std::shared_ptr<ImageProcessingExecutor> executor;
+	unsigned receivedImages;
+};
\ No newline at end of file
@@ -1,9 +1,37 @@
 #include "ImageProcessingExecutor.h"
 
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <algorithm>
+#include <unordered_set>
+#include <filesystem>
+
+#include "LibCore/StringUtils.h"
+#include "LibCore/Hash.h"
+#include "LibCore/EventTrace.h"
+#include "LibGraphics/TileGrid.h"
+#include "LibGraphics/TextureArray.h"
+
+#define POOL_METRICS_INTERVAL_MS 1000
+#define REBALANCE_INTERVAL_MS 500
+#define REBALANCE_MIN_SAMPLES 4
+#define SERVICE_TIME_SMOOTHING 0.5
+#define EXPORT_JOURNAL_NAME "export_journal.txt"
+#define JOURNAL_SYNC_INTERVAL_MS 500
+#define JOURNAL_SYNC_BATCH 32
+#define TILED_RENDER_MIN_SIZE 8192	// images with a longer side are filtered in tiles (or beyond GL_MAX_TEXTURE_SIZE)
+#define TILE_SIZE 2048				// padded tile, bounds the VRAM of a tiled image to a few textures of this size
+#define BATCH_MAX_LAYERS 8
+#define BATCH_MAX_PIXELS (48 * 1024 * 1024)	// per texture array, a pass holds two of them
+
 std::shared_ptr<ImageProcessingExecutor> ImageProcessingExecutor::Run(
 	const std::shared_ptr< ImageProcessor>& processor,
 	const std::vector<LibCore::Filesystem::File>& imageFiles,
-	const LibCore::Filesystem::Directory& saveDirectory
+	const LibCore::Filesystem::Directory& saveDirectory,
+	const std::shared_ptr<LibCore::Async::MainThreadExecutor>& mainThread,
+	bool logPoolMetrics,
+	std::function<void(const std::string& line)> forwardJournal
 )
 {
 	auto results = std::shared_ptr<ImageProcessingExecutor>(new ImageProcessingExecutor{});
@@ -12,6 +40,17 @@ std::shared_ptr<ImageProcessingExecutor> ImageProcessingExecutor::Run(
 		saveDirectory.Create();
 
 	results->saveDirectory = saveDirectory;
+	results->glQueue = std::make_unique<LibCore::Async::MainThreadQueue>(mainThread, LibCore::Async::MainThreadExecutor::PRIORITY::LOW);
+
+	results->logMetrics = logPoolMetrics;
+	if (logPoolMetrics)
+	{
+		results->poolMonitor = std::make_unique<LibCore::Async::PoolMonitor>(
+			POOL_METRICS_INTERVAL_MS,
+			saveDirectory.String() + "/pool_metrics.csv");
+		results->poolMonitor->Watch(results->imageEnhanceThreadPool);
+		results->poolMonitor->Watch(results->imageSaveThreadPool);
+	}
 
 	results->imageFilters.push_back(processor->brightnessFilter->Clone());
 	results->imageFilters.push_back(processor->contrastFilter->Clone());
@@ -20,83 +59,660 @@ std::shared_ptr<ImageProcessingExecutor> ImageProcessingExecutor::Run(
 	results->imageFilters.push_back(processor->temperatureFilter->Clone());
 	results->imageFilters.push_back(processor->gammaFilter->Clone());
 
+	results->imageFxFlags = processor->imageFXFlags;
+	results->presetHash = LibCore::Utils::Hash::XXHash64(&results->imageFxFlags, sizeof(results->imageFxFlags));
+	for (auto& filter : results->imageFilters)
+		results->presetHash = filter->ParameterHash(results->presetHash);
+
 	for (auto& filter : processor->imageFilters)
 	{
-		if(filter->Active)
+		if (filter->Active)
+		{
 			results->imageFilters.push_back(filter->Filter->Clone());
+			results->presetHash = LibCore::Utils::Hash::XXHash64(filter->Name.data(), filter->Name.size(), results->presetHash);
+			results->presetHash = filter->Filter->ParameterHash(results->presetHash);
+		}
 	}
 
+	LibCore::Filesystem::JobJournal::Options journalOptions;
+	journalOptions.SyncIntervalMs = JOURNAL_SYNC_INTERVAL_MS;
+	journalOptions.SyncBatch = JOURNAL_SYNC_BATCH;
+	journalOptions.Forward = std::move(forwardJournal);
+	results->journal = LibCore::Filesystem::JobJournal::Open(JournalFile(saveDirectory), journalOptions);
+	if (logPoolMetrics && results->journal && results->journal->LoadedRecords())
+		std::cout << "[Journal] resuming export in " << saveDirectory.String() << ", " << results->journal->LoadedRecords() << " records" << std::endl;
+
+	const uint64_t now = NowMicros();
 	for (auto& file : imageFiles)
+		results->Add(file, now);
+
+	return results;
+}
+
+bool ImageProcessingExecutor::Add(const LibCore::Filesystem::File& imageFile, uint64_t arrivalMicros, const std::string& outputName)
+{
+	std::error_code ec;
+	const auto canonicalPath = std::filesystem::weakly_canonical(std::filesystem::path{ imageFile.FilePath().String() }, ec);
+	const std::string inputPath = ec ? imageFile.FilePath().String() : canonicalPath.string();
+	if (!imageFile.Exists())
+		return false;
+
+	std::error_code statEc;
+	const auto lastWrite = std::filesystem::last_write_time(inputPath, statEc);
+	const uint64_t size = statEc ? 0 : std::filesystem::file_size(inputPath, statEc);
+
+	std::string savePath;
+	auto found = scheduledInputs.find(inputPath);
+	if (found != scheduledInputs.end())
 	{
-		if (!file.Exists() || results->enhanceImageFutures.find(file.FileName()) != results->enhanceImageFutures.end())
-			continue;
+		auto& input = found->second;
+		if (input.LastWrite == lastWrite && input.Size == size)
+			return false;
 
-		auto fut = results->imageEnhanceThreadPool.Enqueue([results, file](unsigned imageFxFlags) {
-			auto image = LibCV::Image::Create(file);
-			if (image)
-			{
-				image = LibCV::ImageFX::AutoEnhance(image, imageFxFlags);
-				return image->GetImageData();
-			}
-			return LibCV::ImageData{ 0, 0, 0, {}  };
-		}, processor->imageFXFlags);
+		// rewritten while its previous version is still being processed, queued again by Update once that finishes
+		if (!input.Finished)
+		{
+			input.ChangedMicros = arrivalMicros;
+			return true;
+		}
 
-		++results->totalImages;
-		results->enhanceImageFutures[file.FileName()] = std::move(fut);
+		input.LastWrite = lastWrite;
+		input.Size = size;
+		input.Finished = false;
+		savePath = input.SavePath;
+
+		// the output now gets new content, later copies of the old content must not link to it
+		std::lock_guard<std::mutex> lock{ contentMutex };
+		std::erase_if(contentGroups, [&savePath](const auto& group) { return group.second->Finished && group.second->OutputPath == savePath; });
+	}
+	else
+	{
+		if (!outputName.empty())
+			outputNames.insert(LibCore::Utils::String::ToLower(outputName));
+		savePath = saveDirectory.String() + "/" + (outputName.empty() ? UniqueOutputName(imageFile, outputNames) : outputName);
+		scheduledInputs.emplace(inputPath, ScheduledInput{ lastWrite, size, savePath, false, 0 });
 	}
 
-	return results;
+	if (totalImages == 0)
+		firstArrivalMicros = arrivalMicros;
+
+	++totalImages;
+	imageTasks.push_back(ImageTask{
+		ProcessImage(imageFile, savePath, imageFxFlags),
+		imageFile.FileName(),
+		inputPath,
+		arrivalMicros });
+	return true;
 }
 
 ImageProcessingExecutor::ImageProcessingExecutor()
 	: totalImages{ 0 }
 	, completedImages{ 0 }
+	, cancelled{ false }
+	, imageFxFlags{ 0 }
 	, imageFilters{ }
-	, imageSaveThreadPool{ 2 }
-	, imageEnhanceThreadPool{ std::max(std::thread::hardware_concurrency() >> 2, 3U)}
+	, imageSaveThreadPool{ 1 }
+	, imageEnhanceThreadPool{ 1 }
+	, fileIO{ LibCore::Filesystem::AsyncFileIO::Create() }
+	, mainThreadSeconds{ 0.0 }
+	, mainThreadImages{ 0 }
+	, glQueue{ nullptr }
+	, poolMonitor{ nullptr }
+	, logMetrics{ false }
+	, inputMode{ LibCore::Filesystem::MAP_MODE::MAPPED }
+	, coreBudget{ std::max(std::thread::hardware_concurrency(), 3U) - 1 }	// one core left for the main/GL thread
+	, enhanceStage{ 0, 0.0, 0.0 }
+	, saveStage{ 0, 0.0, 0.0 }
+	, lastRebalance{ std::chrono::steady_clock::now() }
+	, duplicateImages{ 0 }
+	, presetHash{ 0 }
+	, journal{ nullptr }
+	, resumedImages{ 0 }
+	, firstArrivalMicros{ 0 }
+	, lastCompletedMicros{ 0 }
 {
-
+	imageEnhanceThreadPool.SetName("Enhance");
+	imageSaveThreadPool.SetName("Save");
+	SetCoreBudget(coreBudget);
 }
 
 ImageProcessingExecutor::~ImageProcessingExecutor()
 {
+	if (poolMonitor)
+		poolMonitor->Stop();
+
+	// let queued stages run to their next suspension point (they bail out once cancelled),
+	// GL stages still queued on the main thread are dropped along with glQueue
+	// writes still in flight resume on the save pool, so it is stopped last
+	cancelled = true;
+	imageEnhanceThreadPool.Shutdown();
+	fileIO->Shutdown();
+	imageSaveThreadPool.Shutdown();
+
+	if (logMetrics)
+	{
+		for (auto& metrics : GetPoolMetrics())
+			std::cout << metrics.ToString() << std::endl;
+		std::cout << "[Main] " << MainThreadMillisPerImage() << "ms per image" << std::endl;
+	}
+	if (logMetrics && duplicateImages)
+		std::cout << "[Dedup] " << duplicateImages << " duplicate inputs linked instead of processed" << std::endl;
+	if (logMetrics && resumedImages)
+		std::cout << "[Journal] " << resumedImages << " images already exported, skipped" << std::endl;
+	if (logMetrics && imageLatency.Count())
+	{
+		std::cout << "[Latency] mean " << imageLatency.MeanMillis() << "ms, p50 " << imageLatency.PercentileMillis(0.5)
+			<< "ms, p99 " << imageLatency.PercentileMillis(0.99) << "ms, " << ImagesPerSecond() << " images/s" << std::endl;
+	}
+}
+
+void ImageProcessingExecutor::SetCoreBudget(unsigned cores)
+{
+	coreBudget = std::max(cores, 2U);
 
+	// decode + enhance usually dominates, start at 2:1 and let Rebalance() correct it
+	const unsigned enhanceWorkers = std::max(coreBudget * 2 / 3, 1U);
+	imageEnhanceThreadPool.Resize(enhanceWorkers);
+	imageSaveThreadPool.Resize(coreBudget - enhanceWorkers);
 }
 
-void ImageProcessingExecutor::Update()
+void ImageProcessingExecutor::SetInputMode(LibCore::Filesystem::MAP_MODE mode)
+{
+	inputMode = mode;
+}
+
+std::string ImageProcessingExecutor::UniqueOutputName(const LibCore::Filesystem::File& file, std::unordered_set<std::string>& takenNames)
+{
+	const std::filesystem::path fileName{ file.FileName() };
+	const std::string stem = fileName.stem().string(), extension = fileName.extension().string();
+
+	// compared case-insensitively, Windows would map differently cased names to one file
+	std::string outputName = fileName.string();
+	for (unsigned suffix = 1; !takenNames.insert(LibCore::Utils::String::ToLower(outputName)).second; ++suffix)
+		outputName = stem + "_" + std::to_string(suffix) + extension;
+
+	return outputName;
+}
+
+LibCore::Async::Task<bool> ImageProcessingExecutor::ProcessImage(LibCore::Filesystem::File file, std::string savePath, unsigned imageFxFlags)
+{
+	co_await LibCore::Async::ScheduleOn(imageEnhanceThreadPool);
+	if (cancelled)
+		co_return false;
+
+	// hashing pulls the file into the page cache, so decoding it next costs no extra disk reads
+	const auto fingerprint = file.Fingerprint(inputMode);
+	if (ResumeOutput(fingerprint, savePath))
+		co_return true;
+
+	std::shared_ptr<ContentGroup> group;
+	bool linked = false;
+	if (!ClaimContent(fingerprint, savePath, group, linked))
+	{
+		// a copy of an image still being rendered, it succeeds or fails along with that one
+		if (group)
+			co_return co_await WaitForContent(group, savePath);
+		co_return linked;
+	}
+
+	bool saved = false;
+	try
+	{
+		saved = co_await RenderImage(file, savePath, imageFxFlags);
+	}
+	catch (...)
+	{
+		FinishContent(group, false);
+		throw;
+	}
+
+	FinishContent(group, saved);
+	co_return saved;
+}
+
+bool ImageProcessingExecutor::ClaimContent(const LibCore::Filesystem::ContentFingerprint& fingerprint, const std::string& savePath, std::shared_ptr<ContentGroup>& group, bool& result)
+{
+	if (!fingerprint.Valid)
+		return true;	// let the decoder report it
+
+	std::string source;
+	{
+		std::lock_guard<std::mutex> lock{ contentMutex };
+		auto& existing = contentGroups[fingerprint];
+		if (!existing)
+		{
+			existing = group = std::make_shared<ContentGroup>(ContentGroup{ fingerprint, savePath, {}, false, false });
+			return true;
+		}
+
+		duplicateImages.fetch_add(1, std::memory_order_relaxed);
+		if (!existing->Finished)
+		{
+			group = existing;
+			return false;
+		}
+
+		source = existing->OutputPath;
+		result = existing->Succeeded;
+	}
+
+	result = result && LinkOutput(source, savePath);
+	RecordOutput(fingerprint, savePath, result);
+	return false;
+}
+
+void ImageProcessingExecutor::FinishContent(const std::shared_ptr<ContentGroup>& group, bool succeeded)
+{
+	if (!group)
+		return;
+
+	std::vector<DuplicateImage*> duplicates;
+	{
+		std::lock_guard<std::mutex> lock{ contentMutex };
+		group->Finished = true;
+		group->Succeeded = succeeded;
+		std::swap(duplicates, group->Duplicates);
+	}
+
+	RecordOutput(group->Input, group->OutputPath, succeeded);
+	for (auto duplicate : duplicates)
+	{
+		duplicate->Linked = succeeded && LinkOutput(group->OutputPath, duplicate->SavePath);
+		RecordOutput(group->Input, duplicate->SavePath, duplicate->Linked);
+		duplicate->Handle.resume();		// completes its task, a failure is reported like any other
+	}
+}
+
+bool ImageProcessingExecutor::ContentAwaiter::await_suspend(std::coroutine_handle<> handle)
+{
+	std::lock_guard<std::mutex> lock{ Executor.contentMutex };
+	if (Group->Finished)
+		return false;	// finished since it was claimed, linked in await_resume
+
+	Image.Handle = handle;
+	Group->Duplicates.push_back(&Image);
+	return true;
+}
+
+bool ImageProcessingExecutor::ContentAwaiter::await_resume()
+{
+	if (!Image.Handle)
+	{
+		Image.Linked = Group->Succeeded && LinkOutput(Group->OutputPath, Image.SavePath);
+		Executor.RecordOutput(Group->Input, Image.SavePath, Image.Linked);
+	}
+	return Image.Linked;
+}
+
+bool ImageProcessingExecutor::LinkOutput(const std::string& source, const std::string& destination)
+{
+	std::error_code ec;
+	std::filesystem::remove(destination, ec);
+	std::filesystem::create_hard_link(source, destination, ec);
+	if (!ec)
+		return true;
+
+	// e.g. FAT / exFAT cards or a destination on another volume
+	ec.clear();
+	std::filesystem::copy_file(source, destination, std::filesystem::copy_options::overwrite_existing, ec);
+	return !ec;
+}
+
+bool ImageProcessingExecutor::ResumeOutput(const LibCore::Filesystem::ContentFingerprint& fingerprint, const std::string& savePath)
+{
+	const std::string outputName = std::filesystem::path{ savePath }.filename().string();
+	if (!journal || !fingerprint.Valid || !journal->IsCompleted(outputName, fingerprint, presetHash))
+		return false;
+
+	// later duplicates of this input link to the existing output instead of rendering it again
+	{
+		std::lock_guard<std::mutex> lock{ contentMutex };
+		auto& existing = contentGroups[fingerprint];
+		if (!existing)
+			existing = std::make_shared<ContentGroup>(ContentGroup{ fingerprint, savePath, {}, true, true });
+	}
+
+	// a worker still reports it, the coordinator counts progress from the records it receives
+	if (journal->Forwarding())
+		RecordOutput(fingerprint, savePath, true);
+
+	resumedImages.fetch_add(1, std::memory_order_relaxed);
+	return true;
+}
+
+void ImageProcessingExecutor::RecordOutput(const LibCore::Filesystem::ContentFingerprint& fingerprint, const std::string& savePath, bool succeeded)
+{
+	if (!journal || !fingerprint.Valid)
+		return;
+
+	journal->Append(
+		succeeded ? LibCore::Filesystem::JobJournal::STATUS::DONE : LibCore::Filesystem::JobJournal::STATUS::FAILED,
+		fingerprint,
+		presetHash,
+		std::filesystem::path{ savePath }.filename().string());
+}
+
+LibCore::Async::Task<bool> ImageProcessingExecutor::RenderImage(LibCore::Filesystem::File file, std::string savePath, unsigned imageFxFlags)
+{
+	// starts on the enhance pool, ProcessImage is already there
+	auto image = LibCV::Image::Create(file, inputMode);
+	if (!image || image->Empty())
+		co_return false;
+
+	auto imageData = LibCV::ImageFX::AutoEnhance(image, imageFxFlags)->GetImageData();
+
+	co_await LibCore::Async::ScheduleOn(*glQueue);
+	if (cancelled)
+		co_return false;
+
+	const int width = imageData.ImageWidth, height = imageData.ImageHeight;
+	int channels = 3;
+	std::vector<unsigned char> pixels;
+
+	// too large for one texture (or for the VRAM budget), filtered tile by tile
+	if (std::max(width, height) > std::min(TILED_RENDER_MIN_SIZE, LibGraphics::Texture::GetMaxSize()))
+	{
+		pixels = co_await RenderTiled(std::move(imageData));
+		if (pixels.empty())
+			co_return false;
+	}
+	else
+	{
+		BatchedImage batched{ std::move(imageData), {}, 3, nullptr };
+		co_await JoinBatch(batched);
+		if (cancelled || batched.Pixels.empty())
+			co_return false;
+
+		channels = batched.Channels;
+		pixels = std::move(batched.Pixels);
+	}
+
+	co_await LibCore::Async::ScheduleOn(imageSaveThreadPool);
+	if (cancelled)
+		co_return false;
+
+	// only this task is the save stage's service time for Rebalance(), not the short one resuming after the write
+	const auto timeBeg = std::chrono::steady_clock::now();
+	auto encoded = LibGraphics::Texture::EncodePixels(savePath, width, height, channels, pixels);
+	const bool saved = encoded.Empty() && LibGraphics::Texture::SavePixels(savePath, width, height, channels, pixels);	// formats that cannot be encoded in memory
+	saveServiceTime.Record(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - timeBeg).count());
+	if (encoded.Empty())
+		co_return saved;
+
+	co_return co_await fileIO->WriteAsync(LibCore::Filesystem::File{ savePath.c_str() }, std::move(encoded), imageSaveThreadPool);
+}
+
+void ImageProcessingExecutor::BatchAwaiter::await_suspend(std::coroutine_handle<> handle)
+{
+	Image.Handle = handle;
+	const std::pair<int, int> size{ Image.Input.ImageWidth, Image.Input.ImageHeight };
+	auto& batch = Executor.pendingBatches[size];
+	batch.push_back(&Image);
+
+	// runs after the GL work queued so far, every image of this size already waiting joins the batch
+	if (batch.size() == 1)
+	{
+		auto executor = &Executor;
+		Executor.glQueue->Submit([executor, size]() { executor->FlushBatch(size); });
+	}
+}
+
+void ImageProcessingExecutor::FlushBatch(std::pair<int, int> size)
+{
+	auto found = pendingBatches.find(size);
+	if (found == pendingBatches.end())
+		return;
+	auto images = std::move(found->second);
+	pendingBatches.erase(found);
+
+	const auto timeBeg = std::chrono::high_resolution_clock::now();
+
+	// a single image or a filter without a layered path goes through the textures one by one
+	const bool layered = images.size() > 1 && std::all_of(imageFilters.begin(), imageFilters.end(), [](const auto& filter) { return filter->PrepareLayers(); });
+	const size_t imagePixels = static_cast<size_t>(size.first) * size.second;
+	const size_t maxLayers = std::clamp<size_t>(BATCH_MAX_PIXELS / std::max<size_t>(imagePixels, 1), 1, std::min<size_t>(BATCH_MAX_LAYERS, LibGraphics::TextureArray::GetMaxLayers()));
+	for (size_t first = 0; first < images.size() && !cancelled; first += maxLayers)
+	{
+		const std::vector<BatchedImage*> layers(images.begin() + first, images.begin() + std::min(images.size(), first + maxLayers));
+		if (layered && layers.size() > 1)
+			FilterLayers(layers);
+		else
+		{
+			for (auto image : layers)
+				FilterImage(*image);
+		}
+	}
+
+	mainThreadSeconds += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - timeBeg).count() / 1e6;
+	mainThreadImages += static_cast<unsigned>(images.size());
+
+	// each carries on to the save pool
+	for (auto image : images)
+		image->Handle.resume();
+}
+
+void ImageProcessingExecutor::FilterImage(BatchedImage& image)
+{
+	auto glImage = LibGraphics::Texture::CreateFromData(
+		image.Input.Pixels,
+		image.Input.ImageWidth,
+		image.Input.ImageHeight,
+		LibGraphics::Texture::FORMAT::BGR24);
+
+	for (auto& filter : imageFilters)
+		glImage = filter->Apply(glImage);
+
+	image.Channels = glImage->GetChannels();
+	image.Pixels = glImage->ReadPixels();
+}
+
+void ImageProcessingExecutor::FilterLayers(const std::vector<BatchedImage*>& images)
+{
+	auto layers = LibGraphics::TextureArray::Create(images.front()->Input.ImageWidth, images.front()->Input.ImageHeight, static_cast<int>(images.size()));
+	for (size_t i = 0; layers && i < images.size(); ++i)
+		layers->Upload(static_cast<int>(i), images[i]->Input.Pixels, LibGraphics::Texture::FORMAT::BGR24);
+
+	for (size_t i = 0; layers && i < imageFilters.size(); ++i)
+		layers = imageFilters[i]->ApplyLayers(layers);
+
+	if (!layers)
+	{
+		std::cout << "Layered filtering failed, filtering the batch one image at a time" << std::endl;
+		for (auto image : images)
+			FilterImage(*image);
+		return;
+	}
+
+	for (size_t i = 0; i < images.size(); ++i)
+	{
+		images[i]->Channels = 3;
+		images[i]->Pixels = layers->ReadLayer(static_cast<int>(i));
+	}
+}
+
+LibCore::Async::Task<std::vector<unsigned char>> ImageProcessingExecutor::RenderTiled(LibCV::ImageData imageData)
 {
-	for (auto it = enhanceImageFutures.begin(); it != enhanceImageFutures.end(); ++it)
+	// starts on the GL queue
+	if (imageData.ImageChannels != 3)
+		co_return std::vector<unsigned char>{};
+
+	const int tileSize = std::min(TILE_SIZE, LibGraphics::Texture::GetMaxSize());
+	for (size_t first = 0; first < imageFilters.size();)
 	{
-		if (it->second.IsReady())
+		// consecutive filters that read a bounded neighbourhood share one pass over the tiles,
+		// the halo keeps at least half of every tile as interior
+		int halo = 0;
+		size_t last = first;
+		for (; last < imageFilters.size(); ++last)
 		{
-			const auto imageData = it->second.Get();
+			const int radius = imageFilters[last]->HaloRadius();
+			if (radius < 0 || 4 * (halo + radius) > tileSize)
+				break;
+			halo += radius;
+		}
+
+		if (last == first)
+		{
+			// the filter needs the whole image, which does not fit a texture: it runs on the CPU instead
+			auto cpuFilter = CreateCPUFilter(*imageFilters[first]);
+			if (!cpuFilter)
+			{
+				std::cout << "Filter cannot run on tiles and has no CPU implementation" << std::endl;
+				co_return std::vector<unsigned char>{};
+			}
 
-			auto glImage = LibGraphics::Texture::CreateFromData(
-				imageData.Pixels,
-				imageData.ImageWidth,
-				imageData.ImageHeight,
+			co_await LibCore::Async::ScheduleOn(imageEnhanceThreadPool);
+			imageData = cpuFilter->Apply(LibCV::Image::Create(imageData), imageEnhanceThreadPool)->GetImageData();
+
+			co_await LibCore::Async::ScheduleOn(*glQueue);
+			if (cancelled)
+				co_return std::vector<unsigned char>{};
+			++first;
+			continue;
+		}
+
+		auto grid = LibGraphics::TileGrid::Create(imageData.ImageWidth, imageData.ImageHeight, halo, tileSize);
+		std::vector<char> filtered(imageData.Pixels.size());
+		for (auto& tile : grid->Tiles())
+		{
+			const auto timeBeg = std::chrono::high_resolution_clock::now();
+
+			auto glTile = LibGraphics::Texture::CreateFromData(
+				grid->Extract(imageData.Pixels, 3, tile),
+				grid->GetPaddedWidth(),
+				grid->GetPaddedHeight(),
 				LibGraphics::Texture::FORMAT::BGR24);
 
-			for (auto& filter : imageFilters)
-				glImage = filter->Apply(glImage);
+			for (size_t i = first; i < last; ++i)
+				glTile = imageFilters[i]->Apply(glTile);
 
-			auto fut = glImage->Save(saveDirectory.String() + "/" + it->first, imageSaveThreadPool);
-			saveImageFutures.push_back(std::move(fut));
+			grid->Store(glTile->ReadPixels(), 3, true, tile, filtered);
+			glTile.reset();
 
-			enhanceImageFutures.erase(it);
+			mainThreadSeconds += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - timeBeg).count() / 1e6;
 
-			break;
+			// one tile per turn, other GL work and the UI get the main thread in between
+			co_await LibCore::Async::ScheduleOn(*glQueue);
+			if (cancelled)
+				co_return std::vector<unsigned char>{};
 		}
+
+		imageData.Pixels = std::move(filtered);
+		first = last;
 	}
+	++mainThreadImages;
 
-	for (size_t i = 0; i < saveImageFutures.size(); ++i)
+	// RGB rows like Texture::ReadPixels, for the encoder
+	std::vector<unsigned char> results(imageData.Pixels.begin(), imageData.Pixels.end());
+	for (size_t i = 0; i + 2 < results.size(); i += 3)
+		std::swap(results[i], results[i + 2]);
+	co_return results;
+}
+
+std::shared_ptr<LibCV::CPUFilter> ImageProcessingExecutor::CreateCPUFilter(const LibGraphics::TextureFilter& filter)
+{
+	// through the preset format, which carries the shader sources and uniform values
+	LibCore::Event::TraceWriter writer;
+	filter.Serialize(writer);
+	LibCore::Event::TraceReader reader{ writer.Data().data(), writer.Data().size() };
+	return LibCV::CPUFilter::Deserialize(reader);
+}
+
+void ImageProcessingExecutor::Update()
+{
+	Rebalance();
+
+	std::vector<std::pair<std::string, uint64_t>> changedInputs;
+	for (size_t i = 0; i < imageTasks.size();)
 	{
-		if (saveImageFutures[i].IsReady())
+		auto& imageTask = imageTasks[i];
+		if (!imageTask.Work.IsReady())
+		{
+			++i;
+			continue;
+		}
+
+		bool saved = false;
+		try
+		{
+			saved = imageTask.Work.Get();
+			if (!saved)
+				std::cout << "Failed to process " << imageTask.FileName << std::endl;
+		}
+		catch (const std::exception& e)
 		{
-			completedImages++;
-			saveImageFutures.erase(saveImageFutures.begin() + i);
+			std::cout << "Failed to process " << imageTask.FileName << ": " << e.what() << std::endl;
 		}
+
+		if (saved)
+		{
+			lastCompletedMicros = NowMicros();
+			imageLatency.Record(lastCompletedMicros - imageTask.ArrivalMicros);
+		}
+
+		auto& input = scheduledInputs[imageTask.InputPath];
+		input.Finished = true;
+		if (input.ChangedMicros != 0)
+		{
+			changedInputs.emplace_back(imageTask.InputPath, input.ChangedMicros);
+			input.ChangedMicros = 0;
+		}
+
+		completedImages++;
+		imageTasks.erase(imageTasks.begin() + i);
 	}
+
+	for (auto& changed : changedInputs)
+		Add(LibCore::Filesystem::File{ changed.first.c_str() }, changed.second);
+}
+
+bool ImageProcessingExecutor::SampleStage(const LibCore::Async::LatencyHistogram& runTime, StageStats& stage)
+{
+	const uint64_t count = runTime.Count();
+	if (count < stage.Count + REBALANCE_MIN_SAMPLES)
+		return false;
+
+	const double totalMillis = runTime.MeanMillis() * count;
+	const double serviceMillis = (totalMillis - stage.TotalMillis) / (count - stage.Count);
+	stage.ServiceMillis = stage.ServiceMillis == 0.0 
+		? serviceMillis
+		: stage.ServiceMillis + SERVICE_TIME_SMOOTHING * (serviceMillis - stage.ServiceMillis);
+	stage.Count = count;
+	stage.TotalMillis = totalMillis;
+	return true;
+}
+
+void ImageProcessingExecutor::Rebalance()
+{
+	const auto now = std::chrono::steady_clock::now();
+	if (Completed() || now - lastRebalance < std::chrono::milliseconds{ REBALANCE_INTERVAL_MS })
+		return;
+	lastRebalance = now;
+
+	// sample both before bailing out so neither stage is skipped by short-circuiting
+	const bool enhanceSampled = SampleStage(imageEnhanceThreadPool.GetMetrics().RunTime, enhanceStage);
+	const bool saveSampled = SampleStage(saveServiceTime.Snapshot(), saveStage);
+	if (!enhanceSampled || !saveSampled)
+		return;
+
+	// a stage with n workers and service time S finishes n / S images per ms,
+	// so equal throughput means workers proportional to service time
+	const double totalMillis = enhanceStage.ServiceMillis + saveStage.ServiceMillis;
+	const unsigned enhanceWorkers = std::clamp(
+		static_cast<unsigned>(std::lround(coreBudget * enhanceStage.ServiceMillis / totalMillis)),
+		1U,
+		coreBudget - 1);
+	const unsigned saveWorkers = coreBudget - enhanceWorkers;
+
+	if (enhanceWorkers == imageEnhanceThreadPool.Size() && saveWorkers == imageSaveThreadPool.Size())
+		return;
+
+	imageEnhanceThreadPool.Resize(enhanceWorkers);
+	imageSaveThreadPool.Resize(saveWorkers);
+
+	if (logMetrics)
+		std::cout << "[Rebalance] enhance " << enhanceStage.ServiceMillis << "ms x" << enhanceWorkers
+			<< ", save " << saveStage.ServiceMillis << "ms x" << saveWorkers << std::endl;
 }
 
 bool ImageProcessingExecutor::Completed() const
@@ -106,5 +722,58 @@ bool ImageProcessingExecutor::Completed() const
 
 float ImageProcessingExecutor::PercentageCompleted() const
 {
-	return 100.0f * ((float)completedImages / (float)totalImages);
+	return totalImages ? 100.0f * ((float)completedImages / (float)totalImages) : 100.0f;
+}
+
+unsigned ImageProcessingExecutor::CompletedImages() const
+{
+	return completedImages;
+}
+
+std::vector<LibCore::Async::ThreadPoolMetrics> ImageProcessingExecutor::GetPoolMetrics() const
+{
+	return { imageEnhanceThreadPool.GetMetrics(), imageSaveThreadPool.GetMetrics() };
+}
+
+float ImageProcessingExecutor::MainThreadMillisPerImage() const
+{
+	return mainThreadImages ? static_cast<float>(1000.0 * mainThreadSeconds / mainThreadImages) : 0.0f;
+}
+
+const LibCore::Async::LatencyHistogram& ImageProcessingExecutor::ImageLatency() const
+{
+	return imageLatency;
+}
+
+float ImageProcessingExecutor::ImagesPerSecond() const
+{
+	if (lastCompletedMicros <= firstArrivalMicros)
+		return 0.0f;
+	return static_cast<float>(imageLatency.Count() * 1e6 / (lastCompletedMicros - firstArrivalMicros));
+}
+
+unsigned ImageProcessingExecutor::DuplicateImages() const
+{
+	return duplicateImages.load(std::memory_order_relaxed);
+}
+
+unsigned ImageProcessingExecutor::ResumedImages() const
+{
+	return resumedImages.load(std::memory_order_relaxed);
+}
+
+bool ImageProcessingExecutor::IsExportDirectory(const LibCore::Filesystem::Directory& directory)
+{
+	return JournalFile(directory).Exists();
+}
+
+LibCore::Filesystem::File ImageProcessingExecutor::JournalFile(const LibCore::Filesystem::Directory& directory)
+{
+	return LibCore::Filesystem::File{ (directory.String() + "/" + EXPORT_JOURNAL_NAME).c_str() };
+}
+
+uint64_t ImageProcessingExecutor::NowMicros()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
 }
\ No newline at end of file
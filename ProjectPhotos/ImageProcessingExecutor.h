@@ -1,7 +1,21 @@
 #pragma once
 
+#include <map>
 #include <memory>
+#include <atomic>
+#include <coroutine>
+#include <chrono>
+#include <string>
+#include <unordered_set>
+#include <unordered_map>
+#include <mutex>
+#include <functional>
+#include <filesystem>
 #include "LibCore/Directory.h"
+#include "LibCore/Task.h"
+#include "LibCore/MainThreadExecutor.h"
+#include "LibCore/AsyncFileIO.h"
+#include "LibCore/JobJournal.h"
 #include "ImageProcessor.h"
 
 class ImageProcessingExecutor
@@ -10,23 +24,186 @@ public:
 	static std::shared_ptr<ImageProcessingExecutor> Run(
 		const std::shared_ptr<ImageProcessor>& processor,
 		const std::vector<LibCore::Filesystem::File>& imageFiles,
-		const LibCore::Filesystem::Directory& saveDirectory);
+		const LibCore::Filesystem::Directory& saveDirectory,
+		const std::shared_ptr<LibCore::Async::MainThreadExecutor>& mainThread,
+		bool logPoolMetrics = false,
+		// export workers: journal records go here instead of into the journal, which is then only read
+		std::function<void(const std::string& line)> forwardJournal = nullptr);
 	~ImageProcessingExecutor();
 
+	// Queues another image on a running executor (hot folder ingest). arrivalMicros is the
+	// steady clock time the image became known, end-to-end latency is measured from it.
+	// outputName is chosen by the caller when several processes share one export, empty picks a unique one.
+	// A path already added is taken again only once its size or modification time changed, e.g. a re-shot image,
+	// and rewrites its earlier output; if that one is still in flight it is processed again after it finishes.
+	bool Add(const LibCore::Filesystem::File& imageFile, uint64_t arrivalMicros, const std::string& outputName = {});
+
+	// cores shared by the enhance and save pools, e.g. split between several worker processes
+	void SetCoreBudget(unsigned cores);
+	// MAP_MODE::READ for inputs other processes may still be writing, e.g. a hot folder; before any Add
+	void SetInputMode(LibCore::Filesystem::MAP_MODE mode);
+
 	void Update();
 	bool Completed() const;
 	float PercentageCompleted() const;
+	unsigned CompletedImages() const;
+
+	std::vector<LibCore::Async::ThreadPoolMetrics> GetPoolMetrics() const;
+	float MainThreadMillisPerImage() const;
+	const LibCore::Async::LatencyHistogram& ImageLatency() const;
+	float ImagesPerSecond() const;
+	unsigned DuplicateImages() const;
+
+	unsigned ResumedImages() const;
+
+	// outputs with the same name get _1, _2, ... suffixes instead of overwriting each other
+	static std::string UniqueOutputName(const LibCore::Filesystem::File& file, std::unordered_set<std::string>& takenNames);
+
+	// true if the directory holds the journal of an earlier export, running into it again skips finished outputs
+	static bool IsExportDirectory(const LibCore::Filesystem::Directory& directory);
+	static LibCore::Filesystem::File JournalFile(const LibCore::Filesystem::Directory& directory);
+	static uint64_t NowMicros();
 
 private:
 	ImageProcessingExecutor();
 	ImageProcessingExecutor(const ImageProcessingExecutor&) = delete;
 	ImageProcessingExecutor& operator=(const ImageProcessingExecutor&) = delete;
 
+	// fingerprints the input first, byte-identical inputs are processed once and linked to every destination
+	LibCore::Async::Task<bool> ProcessImage(LibCore::Filesystem::File file, std::string savePath, unsigned imageFxFlags);
+	// decode + enhance on the enhance pool -> upload + filters on the main thread -> encode on the save pool
+	// -> asynchronous write, the save worker is free again while the file goes to disk
+	LibCore::Async::Task<bool> RenderImage(LibCore::Filesystem::File file, std::string savePath, unsigned imageFxFlags);
+	// for images larger than a texture: runs of filters with a bounded halo are applied tile by tile on the GL queue,
+	// filters that need the whole image run on the CPU; returns RGB rows like Texture::ReadPixels, empty on failure
+	LibCore::Async::Task<std::vector<unsigned char>> RenderTiled(LibCV::ImageData imageData);
+	static std::shared_ptr<LibCV::CPUFilter> CreateCPUFilter(const LibGraphics::TextureFilter& filter);
+
+	// images that reach the GL queue while others of the same size wait there are filtered together, as layers
+	// of one texture array, so each pass is one draw for the whole batch
+	struct BatchedImage
+	{
+		LibCV::ImageData Input;
+		std::vector<unsigned char> Pixels;	// RGB rows like Texture::ReadPixels
+		int Channels;
+		std::coroutine_handle<> Handle;
+	};
+	struct BatchAwaiter
+	{
+		ImageProcessingExecutor& Executor;
+		BatchedImage& Image;
+		bool await_ready() const noexcept { return false; }
+		void await_suspend(std::coroutine_handle<> handle);
+		void await_resume() const noexcept {}
+	};
+	// resumes on the GL queue once the batch the image joined is filtered
+	BatchAwaiter JoinBatch(BatchedImage& image) { return BatchAwaiter{ *this, image }; }
+	void FlushBatch(std::pair<int, int> size);
+	void FilterImage(BatchedImage& image);
+	void FilterLayers(const std::vector<BatchedImage*>& images);
+
+	struct DuplicateImage
+	{
+		std::string SavePath;
+		bool Linked;
+		std::coroutine_handle<> Handle;
+	};
+	struct ContentGroup
+	{
+		LibCore::Filesystem::ContentFingerprint Input;
+		std::string OutputPath;						// written by the first image with this content
+		std::vector<DuplicateImage*> Duplicates;	// waiting for that output
+		bool Finished;
+		bool Succeeded;
+	};
+	struct ContentAwaiter
+	{
+		ImageProcessingExecutor& Executor;
+		std::shared_ptr<ContentGroup> Group;
+		DuplicateImage Image;
+		bool await_ready() const noexcept { return false; }
+		bool await_suspend(std::coroutine_handle<> handle);
+		bool await_resume();
+	};
+	// true if this image should be processed. Otherwise result says whether its output was linked, or
+	// group is set when the first image with this content is still being rendered and has to be waited for.
+	bool ClaimContent(const LibCore::Filesystem::ContentFingerprint& fingerprint, const std::string& savePath, std::shared_ptr<ContentGroup>& group, bool& result);
+	// resumes once the group's output is finished, with whether it was linked to savePath
+	ContentAwaiter WaitForContent(const std::shared_ptr<ContentGroup>& group, const std::string& savePath) { return ContentAwaiter{ *this, group, DuplicateImage{ savePath, false, nullptr } }; }
+	void FinishContent(const std::shared_ptr<ContentGroup>& group, bool succeeded);
+	static bool LinkOutput(const std::string& source, const std::string& destination);
+
+	// true if the journal shows this output was already written from the same input and settings
+	bool ResumeOutput(const LibCore::Filesystem::ContentFingerprint& fingerprint, const std::string& savePath);
+	void RecordOutput(const LibCore::Filesystem::ContentFingerprint& fingerprint, const std::string& savePath, bool succeeded);
+
+	// splits coreBudget workers between the enhance and save pools in proportion to their service times
+	void Rebalance();
+
+	struct StageStats
+	{
+		uint64_t Count;			// samples seen at the last rebalance
+		double TotalMillis;
+		double ServiceMillis;	// smoothed mean time per image
+	};
+	static bool SampleStage(const LibCore::Async::LatencyHistogram& runTime, StageStats& stage);
+
+	struct ImageTask
+	{
+		LibCore::Async::Task<bool> Work;
+		std::string FileName;
+		std::string InputPath;		// key of scheduledInputs
+		uint64_t ArrivalMicros;
+	};
+
+	struct ScheduledInput
+	{
+		std::filesystem::file_time_type LastWrite;	// of the version last scheduled
+		uint64_t Size;
+		std::string SavePath;
+		bool Finished;
+		uint64_t ChangedMicros;		// arrival of a newer version while this one was in flight, 0 if none
+	};
+
 private:
 	unsigned totalImages, completedImages;
-	std::vector< LibCore::Async::Future<bool>> saveImageFutures;
-	std::unordered_map<std::string, LibCore::Async::Future<LibCV::ImageData>> enhanceImageFutures;
+	std::atomic<bool> cancelled;
+	unsigned imageFxFlags;
 	std::vector<std::shared_ptr<LibGraphics::TextureFilter>> imageFilters;
 	LibCore::Async::ThreadPool imageEnhanceThreadPool, imageSaveThreadPool;
+	std::shared_ptr<LibCore::Filesystem::AsyncFileIO> fileIO;
+	// GL stages go through the app-wide main thread executor at low priority
+	std::unique_ptr<LibCore::Async::MainThreadQueue> glQueue;
+	std::map<std::pair<int, int>, std::vector<BatchedImage*>> pendingBatches;	// by size, GL queue only
+	std::vector<ImageTask> imageTasks;
+	std::unordered_map<std::string, ScheduledInput> scheduledInputs;	// by canonical input path
+	std::unordered_set<std::string> outputNames;
 	LibCore::Filesystem::Directory saveDirectory;
+
+	// content deduplication, touched from the enhance pool
+	std::mutex contentMutex;
+	std::unordered_map<LibCore::Filesystem::ContentFingerprint, std::shared_ptr<ContentGroup>, LibCore::Filesystem::ContentFingerprint::Hasher> contentGroups;
+	std::atomic<unsigned> duplicateImages;
+
+	// resumable exports, presetHash identifies the filter settings and FX flags of this run
+	uint64_t presetHash;
+	std::shared_ptr<LibCore::Filesystem::JobJournal> journal;
+	std::atomic<unsigned> resumedImages;
+
+	// end-to-end latency (arrival -> saved) and throughput since the first arrival
+	LibCore::Async::LatencyHistogram imageLatency;
+	uint64_t firstArrivalMicros, lastCompletedMicros;
+
+	// instrumentation, declared after the pools so the monitor stops first
+	double mainThreadSeconds;
+	unsigned mainThreadImages;
+	std::unique_ptr<LibCore::Async::PoolMonitor> poolMonitor;
+	bool logMetrics;	// the metrics summaries on stdout, export workers use stdout for records
+	LibCore::Filesystem::MAP_MODE inputMode;	// how inputs are fingerprinted and decoded
+
+	// adaptive pool sizing
+	unsigned coreBudget;
+	StageStats enhanceStage, saveStage;
+	LibCore::Async::AtomicLatencyHistogram saveServiceTime;	// encode tasks only, the save pool also runs write resumptions
+	std::chrono::steady_clock::time_point lastRebalance;
 };
\ No newline at end of file
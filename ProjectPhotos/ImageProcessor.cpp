@@ -1,11 +1,30 @@
 #include "ImageProcessor.h"
 
+#include <cstring>
+#include <iostream>
+#include "LibCore/Hash.h"
+#include "LibCore/EventTrace.h"
+
+#define PRESET_MAGIC "PEPRESET"
+#define PRESET_VERSION 1
+
 #define IMAGE_REDUCER(image) image->Resize(std::max(image->Width() > 1920 || image->Height() > 1080 \
 						? (image->Width() > image->Height() ? 1920.0f / image->Width() : 1080.0f / image->Height()) \
 						: 1.0f, 0.5f))
 
 //#define IMAGE_REDUCER(image) image
 
+static bool ReadPresetHeader(LibCore::Event::TraceReader& reader, const LibCore::Filesystem::File& file)
+{
+	char magic[sizeof(PRESET_MAGIC) - 1];
+	if (!reader.ReadBytes(magic, sizeof(magic)) || std::memcmp(magic, PRESET_MAGIC, sizeof(magic)) != 0 || reader.Read<uint8_t>() != PRESET_VERSION)
+	{
+		std::cout << "Not a preset: " << file.FilePath().String() << std::endl;
+		return false;
+	}
+	return true;
+}
+
 void ImageProcessor::ProcessGLChanges()
 {
 	if (procCVImage)
@@ -13,6 +32,16 @@ void ImageProcessor::ProcessGLChanges()
 		// apply settings
 		procGLImagesPost = procGLImagesPre;
 
+		// stack labels follow the position, the same filter can be in the stack twice
+		brightnessFilter->SetTimer(gpuTimer, "Brightness");
+		contrastFilter->SetTimer(gpuTimer, "Contrast");
+		sharpnessFilter->SetTimer(gpuTimer, "Sharpness");
+		hslFilter->SetTimer(gpuTimer, "HSL");
+		temperatureFilter->SetTimer(gpuTimer, "Temperature");
+		gammaFilter->SetTimer(gpuTimer, "Gamma");
+		for (size_t i = 0; i < imageFilters.size(); ++i)
+			imageFilters[i]->Filter->SetTimer(gpuTimer, imageFilters[i]->Name + " #" + std::to_string(i + 1));
+
 		procGLImagesPost = brightnessFilter->Apply(procGLImagesPost);
 		procGLImagesPost = contrastFilter->Apply(procGLImagesPost);
 		procGLImagesPost = sharpnessFilter->Apply(procGLImagesPost);
@@ -28,6 +57,9 @@ void ImageProcessor::ProcessGLChanges()
 
 void ImageProcessor::Update()
 {
+	if (gpuTimer)
+		gpuTimer->Collect();
+
 	if (loadImageFuture.IsReady())
 	{
 		loadImageFuture.Get();
@@ -53,6 +85,25 @@ void ImageProcessor::Update()
 	}
 }
 
+void ImageProcessor::SetProfiling(bool profiling)
+{
+	if (profiling == IsProfiling())
+		return;
+
+	gpuTimer = profiling ? LibGraphics::GPUTimer::Create() : nullptr;
+	ProcessGLChanges();
+}
+
+bool ImageProcessor::IsProfiling() const
+{
+	return gpuTimer != nullptr;
+}
+
+const std::shared_ptr<LibGraphics::GPUTimer>& ImageProcessor::GetGPUTimer() const
+{
+	return gpuTimer;
+}
+
 bool ImageProcessor::LoadImage(const LibCore::Filesystem::Path& path)
 {
 	if (path.Exists())
@@ -327,4 +378,127 @@ std::shared_ptr< ImageProcessor> ImageProcessor::Clone() const
 	results->ProcessGLChanges();
 
 	return results;
+}
+
+bool ImageProcessor::SavePreset(const LibCore::Filesystem::File& file) const
+{
+	LibCore::Event::TraceWriter writer;
+	writer.WriteBytes(PRESET_MAGIC, std::strlen(PRESET_MAGIC));
+	writer.Write(static_cast<uint8_t>(PRESET_VERSION));
+	writer.Write(static_cast<uint32_t>(imageFXFlags));
+
+	for (auto& filter : { brightnessFilter, contrastFilter, sharpnessFilter, hslFilter, temperatureFilter, gammaFilter })
+		filter->Serialize(writer);
+
+	writer.Write(static_cast<uint32_t>(imageFilters.size()));
+	for (auto& filter : imageFilters)
+	{
+		writer.WriteString(filter->Name);
+		writer.Write(static_cast<uint8_t>(filter->Active));
+		filter->Filter->Serialize(writer);
+	}
+
+	const auto& data = writer.Data();
+	return file.Write(reinterpret_cast<const uint8_t*>(data.data()), data.size());
+}
+
+bool ImageProcessor::LoadPreset(const LibCore::Filesystem::File& file)
+{
+	const auto data = file.ReadBinary();
+	LibCore::Event::TraceReader reader{ reinterpret_cast<const char*>(data.data()), data.size() };
+
+	if (!ReadPresetHeader(reader, file))
+		return false;
+
+	// everything is read before anything is replaced, a bad preset leaves the processor as it was
+	const unsigned fxFlags = reader.Read<uint32_t>();
+	std::shared_ptr<LibGraphics::TextureFilter> adjustments[6];
+	for (auto& filter : adjustments)
+	{
+		if (!(filter = LibGraphics::TextureFilter::Deserialize(reader)))
+			return false;
+	}
+
+	std::vector<std::shared_ptr<FilterData>> filters(reader.Read<uint32_t>());
+	for (auto& filter : filters)
+	{
+		filter = std::make_shared<FilterData>();
+		filter->Name = reader.ReadString();
+		filter->Active = reader.Read<uint8_t>() != 0;
+		if (!reader.Good() || !(filter->Filter = LibGraphics::TextureFilter::Deserialize(reader)))
+			return false;
+	}
+
+	imageFXFlags = fxFlags;
+	brightnessFilter = adjustments[0];
+	contrastFilter = adjustments[1];
+	sharpnessFilter = adjustments[2];
+	hslFilter = adjustments[3];
+	temperatureFilter = adjustments[4];
+	gammaFilter = adjustments[5];
+	imageFilters = std::move(filters);
+
+	ProcessGLChanges();
+	return true;
+}
+
+bool ImageProcessor::LoadCPUPreset(const LibCore::Filesystem::File& file, CPUPreset& preset)
+{
+	const auto data = file.ReadBinary();
+	LibCore::Event::TraceReader reader{ reinterpret_cast<const char*>(data.data()), data.size() };
+	if (!ReadPresetHeader(reader, file))
+		return false;
+
+	CPUPreset results;
+	results.FXFlags = reader.Read<uint32_t>();
+
+	// hashed in the same sequence as ImageProcessingExecutor, CPU and GPU exports of a preset resume each other
+	results.Hash = LibCore::Utils::Hash::XXHash64(&results.FXFlags, sizeof(results.FXFlags));
+	for (int i = 0; i < 6; ++i)
+	{
+		auto filter = LibCV::CPUFilter::Deserialize(reader);
+		if (!filter)
+		{
+			std::cout << "Preset adjustment " << i << " has no CPU implementation" << std::endl;
+			return false;
+		}
+		results.Hash = filter->ParameterHash(results.Hash);
+		results.Filters.push_back(std::move(filter));
+	}
+
+	for (uint32_t i = reader.Read<uint32_t>(); i > 0 && reader.Good(); --i)
+	{
+		const std::string name = reader.ReadString();
+		const bool active = reader.Read<uint8_t>() != 0;
+		auto filter = reader.Good() ? LibCV::CPUFilter::Deserialize(reader) : nullptr;
+		if (!filter)
+		{
+			std::cout << "Preset filter " << name << " has no CPU implementation" << std::endl;
+			return false;
+		}
+
+		if (active)
+		{
+			results.Hash = LibCore::Utils::Hash::XXHash64(name.data(), name.size(), results.Hash);
+			results.Hash = filter->ParameterHash(results.Hash);
+			results.Filters.push_back(std::move(filter));
+		}
+	}
+
+	if (!reader.Good())
+		return false;
+
+	preset = std::move(results);
+	return true;
+}
+
+std::shared_ptr<LibCV::Image> ImageProcessor::ApplyCPUPreset(
+	const CPUPreset& preset,
+	const std::shared_ptr<LibCV::Image>& image,
+	LibCore::Async::ThreadPool& threadPool)
+{
+	auto results = image;
+	for (auto& filter : preset.Filters)
+		results = filter->Apply(results, threadPool);
+	return results;
 }
\ No newline at end of file
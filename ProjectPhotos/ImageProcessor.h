@@ -9,6 +9,7 @@
 #include "LibCore/ThreadPool.h"
 
 #include "LibCV/ImageFX.h"
+#include "LibCV/CPUFilter.h"
 
 #include "LibGraphics/TextureFilter.h"
 #include "LibGraphics/DefaultShaders.h"
@@ -20,6 +21,14 @@ struct FilterData
 	std::shared_ptr<LibGraphics::TextureFilter> Filter;
 };
 
+// a preset as loaded for LibCV::CPUFilter: adjustments first, then the active filters, in GL order
+struct CPUPreset
+{
+	unsigned FXFlags = 0;
+	uint64_t Hash = 0;
+	std::vector<std::shared_ptr<LibCV::CPUFilter>> Filters;
+};
+
 class ImageProcessor
 {
 public:
@@ -51,6 +60,7 @@ public:
 		, hslFilter{ nullptr }
 		, temperatureFilter{ nullptr }
 		, gammaFilter{ nullptr }
+		, gpuTimer{ nullptr }
 		, procCVImage{ nullptr }
 		, origGLImage{ nullptr }
 		, procGLImagesPre{ nullptr }
@@ -93,10 +103,26 @@ public:
 	unsigned GetFXFlags() const;
 	void SetFXFlags(unsigned flags);
 
+	// GPU time of every adjustment and stack filter, GetGPUTimer() is nullptr while off
+	void SetProfiling(bool profiling);
+	bool IsProfiling() const;
+	const std::shared_ptr<LibGraphics::GPUTimer>& GetGPUTimer() const;
+
 	unsigned GetImageHeight() const;
 	unsigned GetImageWidth() const;
 	std::shared_ptr< ImageProcessor> Clone() const;
 
+	// FX flags, adjustment settings and filter stack; loading does not reprocess the current image
+	bool SavePreset(const LibCore::Filesystem::File& file) const;
+	bool LoadPreset(const LibCore::Filesystem::File& file);
+
+	// the same preset for machines without a GL context, fails if a filter has no CPU implementation
+	static bool LoadCPUPreset(const LibCore::Filesystem::File& file, CPUPreset& preset);
+	static std::shared_ptr<LibCV::Image> ApplyCPUPreset(
+		const CPUPreset& preset,
+		const std::shared_ptr<LibCV::Image>& image,
+		LibCore::Async::ThreadPool& threadPool);
+
 private:
 	unsigned imageFXFlags;
 
@@ -113,6 +139,7 @@ private:
 	std::shared_ptr<LibGraphics::TextureFilter> hslFilter;
 	std::shared_ptr<LibGraphics::TextureFilter> temperatureFilter;
 	std::shared_ptr<LibGraphics::TextureFilter> gammaFilter;
+	std::shared_ptr<LibGraphics::GPUTimer> gpuTimer;
 
 private:
 	LibCore::Async::Future<void> loadImageFuture;
@@ -4,8 +4,10 @@
 
 #include "Events.h"
 #include "PhotoEditor.h"
+#include "ExportCoordinator.h"
 
 #include "LibCV/Image.h"
+#include "LibGraphics/GPUMemory.h"
 
 #include "imgui/imgui.h"
 #include "imgui/imgui_impl_glfw.h"
@@ -23,15 +25,85 @@ static const int IMGUI_OVERLAY_FLAGS
     | ImGuiWindowFlags_NoScrollWithMouse
     | ImGuiWindowFlags_NoCollapse;
 
-int main()
+// share of a 60Hz frame handed to queued GL work (uploads, filter chains, readbacks)
+static const float FRAME_BUDGET_MS = 1000.0f / 60.0f;
+static const float GL_WORK_BUDGET_SLICE = 0.25f;
+
+// VRAM kept before thumbnail atlas pages and idle filter targets are evicted
+static const int DEFAULT_VRAM_BUDGET_MB = 1024;
+
+// --record-events <trace>   record traceable events to a binary trace
+// --replay-events <trace>   re-emit the events of a trace
+// --replay-speed <x>        1 for the recorded pace (default), 0 for as fast as possible
+// --quit-after-replay       exit once the trace is emitted and all work has finished
+// --watch-folder <dir>      process images dropped into the folder as they arrive, off by default
+// --watch-output <dir>      where the watched folder's images are saved (default <folder>/Hot_Folder_Export)
+// --export-worker <shard>   run as a background export worker for the shard, started by ExportCoordinator
+// --vram-budget <MB>        GPU memory to keep textures within, 0 for no limit (default 1024)
+struct CommandLine
+{
+    std::string RecordPath;
+    std::string ReplayPath;
+    float ReplaySpeed = 1.0f;
+    bool QuitAfterReplay = false;
+    std::string WatchFolder;
+    std::string WatchOutput;
+    std::string ExportWorker;
+    int VRAMBudgetMB = DEFAULT_VRAM_BUDGET_MB;
+
+    CommandLine(int argc, char** argv)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+            if (arg == "--record-events" && hasValue)
+                RecordPath = argv[++i];
+            else if (arg == "--replay-events" && hasValue)
+                ReplayPath = argv[++i];
+            else if (arg == "--replay-speed" && hasValue)
+                ReplaySpeed = std::stof(argv[++i]);
+            else if (arg == "--quit-after-replay")
+                QuitAfterReplay = true;
+            else if (arg == "--watch-folder" && hasValue)
+                WatchFolder = argv[++i];
+            else if (arg == "--watch-output" && hasValue)
+                WatchOutput = argv[++i];
+            else if (arg == "--export-worker" && hasValue)
+                ExportWorker = argv[++i];
+            else if (arg == "--vram-budget" && hasValue)
+                VRAMBudgetMB = std::max(0, std::stoi(argv[++i]));
+            else
+                std::cout << "Unknown argument " << arg << std::endl;
+        }
+    }
+};
+
+int main(int argc, char** argv)
 {
     //_CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
+    const CommandLine cmdLine{ argc, argv };
+    if (!cmdLine.ExportWorker.empty())
+        return ExportCoordinator::RunWorker(cmdLine.ExportWorker);
+
+    LibGraphics::GPUMemory::SetBudget(static_cast<int64_t>(cmdLine.VRAMBudgetMB) * 1024 * 1024);
     auto appManager = LibGraphics::AppManager::Create();
     {
         auto sharedData = std::make_shared<PanelSharedData>();
         sharedData->Application = appManager->CreateApp("PhotoLite", 1280, 720);
         sharedData->EvtSystem = std::make_shared<LibCore::Event::EventSystem>();
         sharedData->ThreadPool = std::make_shared<LibCore::Async::ThreadPool>();
+        sharedData->MainThread = std::make_shared<LibCore::Async::MainThreadExecutor>();
+
+        if (!cmdLine.RecordPath.empty())
+            sharedData->EvtSystem->SetRecorder(LibCore::Event::EventRecorder::Create(cmdLine.RecordPath));
+
+        std::shared_ptr<LibCore::Event::EventReplayer> replayer;
+        if (!cmdLine.ReplayPath.empty() && (replayer = LibCore::Event::EventReplayer::Create(cmdLine.ReplayPath)))
+        {
+            Event::RegisterReplayEvents(*replayer);
+            replayer->SetSpeed(cmdLine.ReplaySpeed);
+        }
 
         bool overlayOpen = false;
         std::function<bool()> overlayRenderFunc;
@@ -79,9 +151,29 @@ int main()
             // initialise
             photoEditor->Init();
 
+            // hot folder ingest, exports default to a subfolder the watcher ignores
+            if (!cmdLine.WatchFolder.empty())
+            {
+                sharedData->EvtSystem->Emit(Event::WatchFolder{
+                    cmdLine.WatchFolder,
+                    cmdLine.WatchOutput.empty() ? cmdLine.WatchFolder + "/Hot_Folder_Export" : cmdLine.WatchOutput });
+            }
+
             sharedData->Application->Run([&](float dt) {
                 auto now = std::chrono::high_resolution_clock::now();
 
+                // GL work posted from worker threads, highest priority first
+                sharedData->MainThread->ProcessTasks(FRAME_BUDGET_MS * GL_WORK_BUDGET_SLICE);
+
+                bool replayDone = false;
+                if (replayer)
+                {
+                    const bool wasFinished = replayer->Finished();
+                    replayDone = replayer->Update(*sharedData->EvtSystem);
+                    if (replayDone && !wasFinished)
+                        std::cout << "Replayed " << replayer->EmittedEvents() << " events in " << replayer->ElapsedSeconds() << "s" << std::endl;
+                }
+
                 // Start the Dear ImGui frame
                 ImGui_ImplOpenGL3_NewFrame();
                 ImGui_ImplGlfw_NewFrame();
@@ -118,7 +210,19 @@ int main()
                 }
                 ImGui::End();
 
-                std::string textFPS = (std::stringstream{} << std::floorf(1.0f / dt) << " FPS").str();
+                // after the frame touched what it draws, so only what went out of view is evicted
+                LibGraphics::GPUMemory::Trim();
+
+                const auto glStats = sharedData->MainThread->GetLastFrameStats();
+                std::stringstream ssFPS;
+                ssFPS << std::floorf(1.0f / dt) << " FPS";
+                if (glStats.Deferred)
+                    ssFPS << " | GL " << glStats.Executed << " run, " << glStats.Deferred << " deferred";
+                ssFPS << " | VRAM " << LibGraphics::GPUMemory::GetUsage() / (1024 * 1024);
+                if (LibGraphics::GPUMemory::GetBudget() > 0)
+                    ssFPS << "/" << LibGraphics::GPUMemory::GetBudget() / (1024 * 1024);
+                ssFPS << " MB";
+                std::string textFPS = ssFPS.str();
                 auto textSize = ImGui::CalcTextSize(textFPS.c_str());
                 ImGui::GetForegroundDrawList()->AddText(ImVec2{ ImGui::GetIO().DisplaySize.x - textSize.x - 2.5f, 2.5f }, 0xff0000ff, textFPS.c_str());
                 
@@ -153,6 +257,12 @@ int main()
                     std::max(0.0f, dt - std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - now).count() / 1000.0f)
                 );
 
+                if (replayDone && cmdLine.QuitAfterReplay && !sharedData->BatchRunning && sharedData->MainThread->PendingTasks() == 0)
+                {
+                    std::cout << "Replay session finished in " << replayer->ElapsedSeconds() << "s" << std::endl;
+                    return true;
+                }
+
                 return false;
             });
 
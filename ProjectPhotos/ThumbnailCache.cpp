@@ -0,0 +1,200 @@
+#include "ThumbnailCache.h"
+
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <thread>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <iostream>
+#include "LibCore/Hash.h"
+#include "LibCore/EventTrace.h"
+
+// entry layout: magic, u8 version, i32 width, i32 height, u32 levels, then u32 size + blocks per level
+static const char THUMBNAIL_CACHE_MAGIC[7] = { 'P', 'E', 'T', 'H', 'U', 'M', 'B' };
+static const uint8_t THUMBNAIL_CACHE_VERSION = 1;
+
+// pruning goes below the limit so the next few stores do not prune again
+#define THUMBNAIL_CACHE_PRUNE_RATIO 0.75
+
+std::shared_ptr<ThumbnailCache> ThumbnailCache::Create(const LibCore::Filesystem::Directory& directory, uint64_t maxBytes)
+{
+	std::error_code ec;
+	std::filesystem::create_directories(directory.String(), ec);
+	if (ec)
+	{
+		std::cout << "Thumbnail cache disabled, cannot create " << directory.String() << ": " << ec.message() << std::endl;
+		return nullptr;
+	}
+
+	auto results = std::shared_ptr<ThumbnailCache>{ new ThumbnailCache{} };
+	results->directory = directory.String();
+	results->maxBytes = maxBytes;
+	results->Prune();
+	return results;
+}
+
+ThumbnailCache::ThumbnailCache()
+	: directory{ }
+	, maxBytes{ DEFAULT_MAX_BYTES }
+	, totalBytes{ 0 }
+{
+
+}
+
+bool ThumbnailCache::Load(const LibCore::Filesystem::File& file, unsigned maxSize, LibGraphics::Texture::CompressedData& data) const
+{
+	const auto entryPath = EntryPath(file, maxSize);
+	if (entryPath.empty())
+		return false;
+
+	std::ifstream entry{ entryPath, std::ios::in | std::ios::binary };
+	if (!entry)
+		return false;
+	const std::vector<char> bytes{ std::istreambuf_iterator<char>{ entry }, std::istreambuf_iterator<char>{} };
+
+	LibCore::Event::TraceReader reader{ bytes.data(), bytes.size() };
+	char magic[sizeof(THUMBNAIL_CACHE_MAGIC)] = {};
+	reader.ReadBytes(magic, sizeof(magic));
+	if (std::memcmp(magic, THUMBNAIL_CACHE_MAGIC, sizeof(magic)) != 0 || reader.Read<uint8_t>() != THUMBNAIL_CACHE_VERSION)
+		return false;
+
+	LibGraphics::Texture::CompressedData results;
+	results.width = reader.Read<int32_t>();
+	results.height = reader.Read<int32_t>();
+	const uint32_t levels = reader.Read<uint32_t>();
+	for (uint32_t level = 0; level < levels && reader.Good(); ++level)
+	{
+		// BC1 is 8 bytes per 4x4 block, anything else is a damaged entry
+		const size_t expected = static_cast<size_t>((std::max(1, results.width >> level) + 3) / 4) * ((std::max(1, results.height >> level) + 3) / 4) * 8;
+		if (reader.Read<uint32_t>() != expected)
+			return false;
+
+		results.levels.emplace_back(expected);
+		reader.ReadBytes(results.levels.back().data(), expected);
+	}
+
+	if (!reader.Good() || results.width <= 0 || results.height <= 0 || results.levels.empty())
+		return false;
+	data = std::move(results);
+
+	// the modification time is the last use, an entry still shown survives pruning
+	entry.close();
+	std::error_code ec;
+	std::filesystem::last_write_time(entryPath, std::filesystem::file_time_type::clock::now(), ec);
+	return true;
+}
+
+void ThumbnailCache::Store(const LibCore::Filesystem::File& file, unsigned maxSize, const LibGraphics::Texture::CompressedData& data) const
+{
+	const auto entryPath = EntryPath(file, maxSize);
+	if (entryPath.empty() || data.levels.empty())
+		return;
+
+	LibCore::Event::TraceWriter writer;
+	writer.WriteBytes(THUMBNAIL_CACHE_MAGIC, sizeof(THUMBNAIL_CACHE_MAGIC));
+	writer.Write(THUMBNAIL_CACHE_VERSION);
+	writer.Write(static_cast<int32_t>(data.width));
+	writer.Write(static_cast<int32_t>(data.height));
+	writer.Write(static_cast<uint32_t>(data.levels.size()));
+	for (auto& level : data.levels)
+	{
+		writer.Write(static_cast<uint32_t>(level.size()));
+		writer.WriteBytes(level.data(), level.size());
+	}
+
+	// a temporary per thread, two workers storing the same image do not write into each other
+	std::ostringstream tempName;
+	tempName << entryPath.filename().string() << "." << std::this_thread::get_id() << ".tmp";
+	const auto tempPath = entryPath.parent_path() / tempName.str();
+	{
+		std::ofstream entry{ tempPath, std::ios::out | std::ios::binary | std::ios::trunc };
+		entry.write(writer.Data().data(), static_cast<std::streamsize>(writer.Data().size()));
+		if (!entry)
+		{
+			entry.close();
+			std::error_code ec;
+			std::filesystem::remove(tempPath, ec);
+			return;
+		}
+	}
+
+	std::error_code ec;
+	std::filesystem::rename(tempPath, entryPath, ec);
+	if (ec)
+	{
+		std::filesystem::remove(tempPath, ec);
+		return;
+	}
+
+	if (totalBytes.fetch_add(writer.Data().size(), std::memory_order_relaxed) + writer.Data().size() > maxBytes)
+		Prune();
+}
+
+void ThumbnailCache::Prune() const
+{
+	std::unique_lock<std::mutex> lock{ pruneMutex, std::try_to_lock };
+	if (!lock.owns_lock())
+		return;	// another thread is already at it
+
+	struct Entry
+	{
+		std::filesystem::path Path;
+		std::filesystem::file_time_type LastUse;
+		uint64_t Size;
+	};
+	std::vector<Entry> entries;
+	uint64_t total = 0;
+
+	std::error_code ec;
+	for (std::filesystem::directory_iterator it{ directory, ec }; !ec && it != std::filesystem::directory_iterator{}; it.increment(ec))
+	{
+		std::error_code entryEc;
+		if (!it->is_regular_file(entryEc))
+			continue;
+		const uint64_t size = it->file_size(entryEc);
+		const auto lastUse = it->last_write_time(entryEc);
+		if (entryEc)
+			continue;
+
+		// temporaries left behind by a crash are counted too, they are old by the time they are reached
+		entries.push_back(Entry{ it->path(), lastUse, size });
+		total += size;
+	}
+
+	if (total > maxBytes)
+	{
+		std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.LastUse < b.LastUse; });
+		const uint64_t target = static_cast<uint64_t>(maxBytes * THUMBNAIL_CACHE_PRUNE_RATIO);
+		for (size_t i = 0; i < entries.size() && total > target; ++i)
+		{
+			std::error_code removeEc;
+			if (std::filesystem::remove(entries[i].Path, removeEc))
+				total -= entries[i].Size;
+		}
+	}
+	totalBytes.store(total, std::memory_order_relaxed);
+}
+
+std::filesystem::path ThumbnailCache::EntryPath(const LibCore::Filesystem::File& file, unsigned maxSize) const
+{
+	const std::filesystem::path path{ file.FilePath().String() };
+	std::error_code ec;
+	const auto size = std::filesystem::file_size(path, ec);
+	if (ec)
+		return {};
+	const auto modified = std::filesystem::last_write_time(path, ec);
+	if (ec)
+		return {};
+
+	// absolute so the same image dropped through another relative path hits
+	const std::string key = std::filesystem::absolute(path, ec).string();
+	uint64_t hash = LibCore::Utils::Hash::XXHash64(key.data(), key.size());
+	const uint64_t stamp[3] = { static_cast<uint64_t>(size), static_cast<uint64_t>(modified.time_since_epoch().count()), maxSize };
+	hash = LibCore::Utils::Hash::XXHash64(stamp, sizeof(stamp), hash);
+
+	std::ostringstream name;
+	name << std::hex << std::setw(16) << std::setfill('0') << hash << ".bc1";
+	return directory / name.str();
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <filesystem>
+#include "LibCore/File.h"
+#include "LibCore/Directory.h"
+#include "LibGraphics/Texture.h"
+
+// BC1 thumbnails on disk, one file per image keyed by its path, size, modification time and the thumbnail size,
+// so an edited image misses instead of showing stale pixels. Safe from any thread: entries are written to a
+// temporary file and renamed into place, a reader never sees half an entry. Past maxBytes the least recently
+// used entries are removed, at creation and whenever a store goes over.
+class ThumbnailCache
+{
+public:
+	static const uint64_t DEFAULT_MAX_BYTES = 256ull * 1024 * 1024;
+
+	// nullptr if the directory cannot be created
+	static std::shared_ptr<ThumbnailCache> Create(const LibCore::Filesystem::Directory& directory, uint64_t maxBytes = DEFAULT_MAX_BYTES);
+
+	bool Load(const LibCore::Filesystem::File& file, unsigned maxSize, LibGraphics::Texture::CompressedData& data) const;
+	void Store(const LibCore::Filesystem::File& file, unsigned maxSize, const LibGraphics::Texture::CompressedData& data) const;
+
+private:
+	ThumbnailCache();
+	ThumbnailCache(const ThumbnailCache&) = delete;
+	ThumbnailCache& operator=(const ThumbnailCache&) = delete;
+
+	// empty if the image cannot be stat'ed
+	std::filesystem::path EntryPath(const LibCore::Filesystem::File& file, unsigned maxSize) const;
+	// removes the oldest entries (by last use) until the cache is back under the pruned size
+	void Prune() const;
+
+	std::filesystem::path directory;
+	uint64_t maxBytes;
+	mutable std::atomic<uint64_t> totalBytes;	// estimate between prunes, other processes may share the directory
+	mutable std::mutex pruneMutex;
+};
\ No newline at end of file
@@ -1,5 +1,9 @@
 #include "UIFilters.h"
 
+#include <cstdio>
+#include <iostream>
+#include "LibCore/Directory.h"
+
 #define REGISTER_FILTER(name, shader) filtersMap[name] = LibGraphics::TextureFilter::CreateFromShader(shader);
 
 #define REGISTER_UNIFORM_VARIABLE_INT(shaderName, uniformName, defaultValue, minValue, maxValue) \
@@ -65,6 +69,32 @@ void UIFilters::Init()
         REGISTER_UNIFORM_VARIABLE_FLOAT("Blur(Guassian)", "uBlurScale", 1.0f, 1.0f, 10.0f);
     }
 
+    filtersMap["Bloom(Pyramid)"] = LibGraphics::TextureFilter::CreateFromShaders(
+        {
+            LibGraphics::BLOOM_BRIGHT_PASS_SHADER,
+            LibGraphics::BLUR_RESAMPLE_SHADER,
+            LibGraphics::BLOOM_UPSAMPLE_SHADER,
+            LibGraphics::BLOOM_COMPOSITE_SHADER,
+        }
+    );
+    {
+        REGISTER_UNIFORM_VARIABLE_FLOAT("Bloom(Pyramid)", "uThreshold", 0.6f, 0.0f, 1.0f);
+        REGISTER_UNIFORM_VARIABLE_FLOAT("Bloom(Pyramid)", "uBloomIntensity", 1.0f, 0.0f, 4.0f);
+        REGISTER_UNIFORM_VARIABLE_FLOAT("Bloom(Pyramid)", "uBloomSpread", 0.6f, 0.0f, 1.0f);
+        REGISTER_UNIFORM_VARIABLE_INT("Bloom(Pyramid)", "uBloomLevels", 5, 1, 8);
+    }
+
+    filtersMap["Blur(Gaussian Pyramid)"] = LibGraphics::TextureFilter::CreateFromShaders(
+        {
+            LibGraphics::SEPARABLE_GAUSSIAN_BLUR_SHADER,
+            LibGraphics::SEPARABLE_GAUSSIAN_BLUR_SHADER,
+            LibGraphics::BLUR_RESAMPLE_SHADER,
+        }
+    );
+    {
+        REGISTER_UNIFORM_VARIABLE_FLOAT("Blur(Gaussian Pyramid)", "uBlurRadius", 2.0f, 0.0f, 100.0f);
+    }
+
     REGISTER_FILTER("Blur(Radial)", LibGraphics::RADIAL_BLUR_SHADER);
     {
         REGISTER_UNIFORM_VARIABLE_INT("Blur(Radial)", "uBlurSteps", 10, 5, 50);
@@ -284,6 +314,42 @@ void UIFilters::Render(float dt)
             }
         }
 
+        // GPU time of the filters as last applied, the adjustments run before the stack
+        bool profiling = imageProcessor->IsProfiling();
+        if (ImGui::Checkbox("GPU Timings##FILTERS_PROFILING", &profiling))
+            imageProcessor->SetProfiling(profiling);
+        const auto& gpuTimer = imageProcessor->GetGPUTimer();
+        if (gpuTimer)
+        {
+            double adjustmentsMillis = 0.0;
+            for (auto label : { "Brightness", "Contrast", "Sharpness", "HSL", "Temperature", "Gamma" })
+            {
+                if (auto stats = gpuTimer->GetStats(label))
+                    adjustmentsMillis += stats->AverageMillis;
+            }
+
+            ImGui::SameLine();
+            ImGui::Text("Adjustments %.2f ms", adjustmentsMillis);
+            ImGui::SameLine();
+            if (ImGui::Button("Export##FILTERS_PROFILING_EXPORT"))
+            {
+                try
+                {
+                    const auto exportDir = LibCore::Filesystem::Directory::OpenDirectoryDialog();
+                    const std::string csvPath = (exportDir / "gpu_timings.csv").String();
+                    if (gpuTimer->ExportCSV(csvPath))
+                        std::cout << "GPU timings written to " << csvPath << std::endl;
+                }
+                catch (const std::exception& e)
+                {
+                    std::cout << "Failed to export GPU timings: " << e.what() << std::endl;
+                }
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Reset##FILTERS_PROFILING_RESET"))
+                gpuTimer->Clear();
+        }
+
         ImGui::Separator();
 
         bool isFilterEdited = false;
@@ -295,7 +361,16 @@ void UIFilters::Render(float dt)
             isFilterEdited = ImGui::Checkbox((imguiIdx + "Active").c_str(), &filters[i]->Active) || isFilterEdited;
             ImGui::SameLine();
             bool selRemoveFilter = true;
-            if (ImGui::CollapsingHeader((filters[i]->Name + imguiIdx + "Details").c_str(), &selRemoveFilter))
+
+            // ### keeps the header's id when the timing in its label changes
+            std::string headerLabel = filters[i]->Name;
+            if (auto stats = gpuTimer ? gpuTimer->GetStats(filters[i]->Name + " #" + std::to_string(i + 1)) : nullptr)
+            {
+                char millis[32];
+                std::snprintf(millis, sizeof(millis), " (%.2f ms)", stats->AverageMillis);
+                headerLabel += millis;
+            }
+            if (ImGui::CollapsingHeader((headerLabel + "###" + filters[i]->Name + imguiIdx + "Details").c_str(), &selRemoveFilter))
             {
                 std::string shaderVarIdx = "##" + filters[i]->Name + std::to_string(i) + "_";
 
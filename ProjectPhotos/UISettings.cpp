@@ -1,4 +1,5 @@
 #include "UISettings.h"
+#include "Events.h"
 
 UISettings::UISettings(
 	const std::shared_ptr<PanelSharedData>& sharedData,
@@ -11,6 +12,15 @@ UISettings::UISettings(
 void UISettings::Init()
 {
 	imageProcessor->SetImageSettingDefaults();
+
+	// changes go through the event system so they can be recorded and replayed
+	UISharedData->EvtSystem->AddListener<Event::ImageSettingChanged>([this](const Event::ImageSettingChanged& evt) {
+		imageProcessor->SetImageSetting(evt.Setting, evt.Value);
+	});
+
+	UISharedData->EvtSystem->AddListener<Event::ImageSettingsReset>([this](const Event::ImageSettingsReset& evt) {
+		imageProcessor->SetImageSettingDefaults();
+	});
 }
 
 void UISettings::SetSettingDragging(
@@ -23,7 +33,7 @@ void UISettings::SetSettingDragging(
 	float value = 100.0f * (imageProcessor->GetImageSetting(setting) - range.x) / (range.y - range.x);
 	if (ImGui::DragFloat(settingsIdx.c_str(), &value, 0.0f, 0.0f, 100.0f, "%.1f"))
 	{
-		imageProcessor->SetImageSetting(setting, range.x + (value / 100.0f) * (range.y - range.x));
+		UISharedData->EvtSystem->Emit(Event::ImageSettingChanged{ setting, range.x + (value / 100.0f) * (range.y - range.x) });
 	}
 }
 
@@ -42,7 +52,7 @@ void UISettings::Render(float dt)
 
 		if (ImGui::Button("Reset to Default", ImVec2{ ImGui::GetContentRegionAvail().x, 0 }))
 		{
-			imageProcessor->SetImageSettingDefaults();
+			UISharedData->EvtSystem->Emit(Event::ImageSettingsReset{});
 		}
 	}
 	ImGui::EndChild();
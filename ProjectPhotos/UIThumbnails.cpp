@@ -3,12 +3,18 @@
 
 #include "LibCore/File.h"
 #include "LibCore/Directory.h"
+#include "LibCore/DirectoryScanner.h"
 #include "LibCore/StringUtils.h"
 
-#include <set>
+#include <unordered_set>
 #include <iostream>
+#include <sstream>
+#include <thread>
+#include <stdexcept>
 
 #define THUMBNAIL_MAX_SIZE 512
+#define THUMBNAIL_ATLAS_PAGE_SIZE 4096		// about 7x7 thumbnails, 10.7MB with its mips
+#define THUMBNAIL_ATLAS_LEVELS 4			// down to an eighth, the grid rarely shows them smaller
 
 static const auto IMAGE_EDIT_WINDOW_FLAGS
 		= ImGuiWindowFlags_NoCollapse
@@ -16,7 +22,63 @@ static const auto IMAGE_EDIT_WINDOW_FLAGS
 		| ImGuiWindowFlags_NoSavedSettings;
 
 
-static std::set<std::string> ACCEPTED_IMAGE_TYPE{
+// a thumbnail letterboxed into [min, max] as ImGui::Image does, on the splitter's second channel:
+// widgets draw with the font texture, kept apart the thumbnails of a page merge into a single draw command
+static void DrawThumbnail(
+	ImDrawList* drawList,
+	ImDrawListSplitter& splitter,
+	ImTextureID texture,
+	float aspect,
+	ImVec2 uv0,
+	ImVec2 uv1,
+	ImVec2 min,
+	ImVec2 max)
+{
+	if (!ImGui::IsItemVisible())
+		return;
+
+	ImVec2 size = max - min;
+	ImVec2 spacing{ 0, 0 };
+	if (aspect > 1.0f)
+	{
+		spacing.y = (size.y - size.x / aspect) * 0.5f;
+		size.y = size.x / aspect;
+	}
+	else
+	{
+		spacing.x = (size.x - size.y * aspect) * 0.5f;
+		size.x = size.y * aspect;
+	}
+
+	splitter.SetCurrentChannel(drawList, 1);
+	drawList->AddImage(texture, min + spacing, min + spacing + size, uv0, uv1);
+	splitter.SetCurrentChannel(drawList, 0);
+}
+
+static void DrawThumbnail(
+	ImDrawList* drawList,
+	ImDrawListSplitter& splitter,
+	const LibGraphics::TextureAtlas& atlas,
+	const LibGraphics::TextureAtlas::Region& region,
+	ImVec2 min,
+	ImVec2 max)
+{
+	if (atlas.IsResident(region))
+		DrawThumbnail(drawList, splitter, (ImTextureID)atlas.GetPageHandler(region.Page), region.GetAspect(), ImVec2{ region.UV0.x, region.UV0.y }, ImVec2{ region.UV1.x, region.UV1.y }, min, max);
+}
+
+// without an atlas each thumbnail is a texture of its own
+static void DrawThumbnail(
+	ImDrawList* drawList,
+	ImDrawListSplitter& splitter,
+	const LibGraphics::Texture& texture,
+	ImVec2 min,
+	ImVec2 max)
+{
+	DrawThumbnail(drawList, splitter, (ImTextureID)texture.GetHandler(), texture.GetAspect(), ImVec2{ 0, 0 }, ImVec2{ 1, 1 }, min, max);
+}
+
+static const std::unordered_set<std::string> ACCEPTED_IMAGE_TYPE{
     ".jpeg",
     ".jpg",
     ".png"
@@ -27,10 +89,18 @@ UIThumbnails::UIThumbnails(const std::shared_ptr<PanelSharedData>& sharedData,
     : UIHeader{ sharedData }
     , imageProcessor{ imageProcessor }
 	, loadImagePool{ 2 }
+	, thumbnailCache{ nullptr }
+	, directoryScanner{ nullptr }
 	, thumbnailScale{ 1.0f }
 	, currClickedTime{ std::chrono::high_resolution_clock::now() }
 	, clickedThumbnail{ nullptr }
+	, logPoolMetrics{ false }
+	, exportWorkers{ 0 }
 {
+	std::error_code ec;
+	const auto tempDirectory = std::filesystem::temp_directory_path(ec);
+	if (!ec)
+		thumbnailCache = ThumbnailCache::Create(LibCore::Filesystem::Directory{ (tempDirectory / "PhotoEditor" / "Thumbnails").string().c_str() });
 }
 
 UIThumbnails::~UIThumbnails()
@@ -40,49 +110,89 @@ UIThumbnails::~UIThumbnails()
 
 void UIThumbnails::Init()
 {
+	thumbnailAtlas = LibGraphics::TextureAtlas::Create(THUMBNAIL_ATLAS_PAGE_SIZE, THUMBNAIL_ATLAS_LEVELS);
+
     UISharedData->EvtSystem->AddListener<Event::DragDropFiles>([this](const Event::DragDropFiles& evt) {
 		// clear all thumbails
 		Clear();
 
-		auto LoadThumbnailFunc = [this](const LibCore::Filesystem::File& file) {
-			auto filename = file.FilePath().String();
-			if (thumbnails.find(filename) == thumbnails.end())
+		// files stream in through LoadImages() while the scan runs
+		LibCore::Filesystem::DirectoryScanner::Options options;
+		options.Recursive = false;
+		options.Extensions = ACCEPTED_IMAGE_TYPE;
+		directoryScanner = LibCore::Filesystem::DirectoryScanner::Start(evt.Paths, options, *UISharedData->ThreadPool);
+    });
+
+	UISharedData->EvtSystem->AddListener<Event::ApplyToImages>([this](const Event::ApplyToImages& evt) {
+		try
+		{
+			std::vector<LibCore::Filesystem::File> imagesToEdit;
+			for (auto& file : evt.Files)
+				imagesToEdit.push_back(LibCore::Filesystem::File{ file.c_str() });
+
+			if (evt.WorkerProcesses > 0)
 			{
-				thumbnails[filename] = std::make_shared<Thumbnail>();
-				thumbnails[filename]->ToEdit = true;
-				thumbnails[filename]->filename = file.FileName();
-				thumbnails[filename]->cancelToken = std::make_shared<LibCore::Async::CancelToken>();
-				thumbnails[filename]->loadFuture = loadImagePool.Enqueue(thumbnails[filename]->cancelToken, [file]() {
-					auto image = LibCV::Image::Create(file.FilePath().String().c_str());
-					if (image->Width() > THUMBNAIL_MAX_SIZE || image->Height() > THUMBNAIL_MAX_SIZE)
-						image = image->Resize(image->Width() > image->Height() ? ((float)THUMBNAIL_MAX_SIZE / image->Width()) : ((float)THUMBNAIL_MAX_SIZE / image->Height()));
-					return image->GetImageData();
-				});
+				exportCoordinator = ExportCoordinator::Start(
+					imageProcessor,
+					imagesToEdit,
+					LibCore::Filesystem::Directory{ evt.SaveDirectory.c_str() },
+					evt.WorkerProcesses);
+				if (!exportCoordinator)
+				{
+					std::cout << "Failed to save: cannot start export workers" << std::endl;
+					UISharedData->BatchRunning = false;
+					return;
+				}
 			}
-		};
-
-		// load thumbnails
-        for (auto& path : evt.Paths)
-        {
-            if (path.IsDirectory())
-            {
-                LibCore::Filesystem::Directory directory{ path };
-                for (auto& file : directory.ListFiles(false))
-                {
-                    if (IsAcceptedImageFormat(file.Extension()))
-						LoadThumbnailFunc(file);
-                }
-            }
-            else if (path.IsFile() && IsAcceptedImageFormat(path.Extension()))
-				LoadThumbnailFunc(LibCore::Filesystem::File{ path.String().c_str() });
-        }
-    });
+			else
+			{
+				imageProcExecutor = ImageProcessingExecutor::Run(
+					imageProcessor,
+					imagesToEdit,
+					LibCore::Filesystem::Directory{ evt.SaveDirectory.c_str() },
+					UISharedData->MainThread,
+					evt.LogPoolMetrics);
+			}
+			UISharedData->BatchRunning = true;
+			UISharedData->EvtSystem->Emit(Event::OverlayPopup{ [this]() {
+				return ShowEditingImages();
+			} });
+		}
+		catch (const std::exception& e)
+		{
+			std::cout << "Failed to save: " << e.what() << std::endl;
+			imageProcExecutor = nullptr;
+			exportCoordinator = nullptr;
+			UISharedData->BatchRunning = false;
+		}
+	});
+
+	UISharedData->EvtSystem->AddListener<Event::WatchFolder>([this](const Event::WatchFolder& evt) {
+		hotFolder = nullptr;
+		if (evt.Directory.empty())
+			return;
+
+		try
+		{
+			hotFolder = HotFolderIngest::Start(
+				imageProcessor,
+				LibCore::Filesystem::Directory{ evt.Directory.c_str() },
+				LibCore::Filesystem::Directory{ evt.SaveDirectory.c_str() },
+				UISharedData->MainThread);
+		}
+		catch (const std::exception& e)
+		{
+			std::cout << "Failed to watch " << evt.Directory << ": " << e.what() << std::endl;
+		}
+	});
 }
 
 void UIThumbnails::Render(float dt)
 {
 	LoadImages();
 	imageProcExecutor ? imageProcExecutor->Update() : void();
+	exportCoordinator ? exportCoordinator->Update() : void();
+	hotFolder ? hotFolder->Update() : void();
 
 	ImGui::PushItemWidth(ImGui::GetContentRegionAvail().x);
 	ImGui::SliderFloat("##THUMBNAIL_SCALE_SLIDER", &thumbnailScale, 0.25f, 1.0f, "");
@@ -97,6 +207,10 @@ void UIThumbnails::Render(float dt)
 		const float window_visible_x2 = ImGui::GetWindowPos().x + ImGui::GetWindowContentRegionMax().x - extraSizes;
 		ImGui::PushStyleVar(ImGuiStyleVar_ItemSpacing, ImVec2(ImGui::GetStyle().ItemSpacing.y, ImGui::GetStyle().ItemSpacing.y));
 
+		ImDrawList* drawList = ImGui::GetWindowDrawList();
+		ImDrawListSplitter splitter;
+		splitter.Split(drawList, 2);
+
 		for (auto& thumbnail : thumbnails)
 		{
 			if (last_button_x2 != 0 && (last_button_x2 + imageSize) < window_visible_x2)
@@ -104,17 +218,28 @@ void UIThumbnails::Render(float dt)
 
 			ImGui::BeginGroup();
 			{
-				const float aspect = thumbnail.second->thumbnailTexture ? thumbnail.second->thumbnailTexture->GetAspect() : 1.0f;
+				const auto& region = thumbnail.second->atlasRegion;
+				const auto& texture = thumbnail.second->texture;
+				const float aspect = region.Valid() ? region.GetAspect() : texture ? texture->GetAspect() : 1.0f;
 				std::string filename = thumbnail.second->filename;
 
+				// the button draws its frame only, the image goes on the thumbnail channel
 				ImGui::ImageButton(
 					(filename + "##IMAGE_ID_" + std::to_string((long long)&thumbnail)).c_str(),
-					(ImTextureID)(thumbnail.second->thumbnailTexture ? thumbnail.second->thumbnailTexture->GetHandler() : 0),
+					(ImTextureID)0,
 					ImVec2(imageSize, imageSize),
 					aspect,
 					ImVec2(0.0f, 0.0f),
 					ImVec2(1.0f, 1.0f),
-					ImVec4{ 0, 0, 0, 1 });
+					ImVec4{ 0, 0, 0, 1 },
+					ImVec4{ 1, 1, 1, 0 });
+				if (ImGui::IsItemVisible())
+					KeepResident(thumbnail.first, *thumbnail.second);
+				const ImVec2 padding = ImGui::GetStyle().FramePadding;
+				if (thumbnailAtlas)
+					DrawThumbnail(drawList, splitter, *thumbnailAtlas, region, ImGui::GetItemRectMin() + padding, ImGui::GetItemRectMax() - padding);
+				else if (texture)
+					DrawThumbnail(drawList, splitter, *texture, ImGui::GetItemRectMin() + padding, ImGui::GetItemRectMax() - padding);
 
 				// check if double clicked
 				if (ImGui::IsItemClicked(ImGuiMouseButton_Left))
@@ -170,25 +295,71 @@ void UIThumbnails::Render(float dt)
 			last_button_x2 = ImGui::GetItemRectMax().x + ImGui::GetStyle().ItemSpacing.x;
 		}
 
+		splitter.Merge(drawList);
 		ImGui::PopStyleVar();
 	}
 	ImGui::EndChild();
 
-	if (ImGui::Button("Apply To Images##PHOTOEDITOR_APPLY_IMAGES", ImVec2{ ImGui::GetContentRegionAvail().x, 0 }))
+	const float btnSize = (ImGui::GetContentRegionAvail().x - ImGui::GetStyle().ItemSpacing.x) * 0.5f;
+	if (ImGui::Button("Apply To Images##PHOTOEDITOR_APPLY_IMAGES", ImVec2{ btnSize, 0 }))
 	{
 		UISharedData->EvtSystem->Emit(Event::OverlayPopup{ [this]() {
 			return ShowImageToEdit();
 		} });
 	}
+
+	ImGui::SameLine();
+
+	if (!hotFolder)
+	{
+		if (ImGui::Button("Watch Folder##PHOTOEDITOR_WATCH_FOLDER", ImVec2{ btnSize, 0 }))
+		{
+			try
+			{
+				// exports go to a subfolder, the watcher is not recursive so they are not picked up again
+				const LibCore::Filesystem::Directory watchDir = LibCore::Filesystem::Directory::OpenDirectoryDialog();
+				UISharedData->EvtSystem->Emit(Event::WatchFolder{ watchDir.String(), (watchDir / "Hot_Folder_Export").String() });
+			}
+			catch (const std::exception& e)
+			{
+				std::cout << "Failed to watch folder: " << e.what() << std::endl;
+			}
+		}
+	}
+	else
+	{
+		std::stringstream ssWatch;
+		ssWatch << "Stop Watching (" << hotFolder->CompletedImages() << "/" << hotFolder->ReceivedImages() << ")##PHOTOEDITOR_WATCH_FOLDER";
+		if (ImGui::Button(ssWatch.str().c_str(), ImVec2{ btnSize, 0 }))
+			UISharedData->EvtSystem->Emit(Event::WatchFolder{ "", "" });
+
+		if (hotFolder && ImGui::IsItemHovered())
+		{
+			const auto& latency = hotFolder->ImageLatency();
+			ImGui::BeginTooltip();
+			ImGui::Text("%s (%s)", hotFolder->WatchDirectory().String().c_str(), hotFolder->UsingNotifications() ? "notifications" : "polling");
+			ImGui::Text("Latency: mean %.1fms, p50 %.1fms, p99 %.1fms", latency.MeanMillis(), latency.PercentileMillis(0.5), latency.PercentileMillis(0.99));
+			ImGui::Text("Throughput: %.2f images/s", hotFolder->ImagesPerSecond());
+			ImGui::EndTooltip();
+		}
+	}
 }
 
 void UIThumbnails::Clear()
 {
+	if (directoryScanner)
+		directoryScanner->Cancel();
+	directoryScanner = nullptr;
+
 	for (auto& thumbnail : thumbnails)
 		thumbnail.second->cancelToken->Cancel();
 
 	for (auto& thumbnail : thumbnails)
 	{
+		if (thumbnailAtlas)
+			thumbnailAtlas->Remove(thumbnail.second->atlasRegion);
+		LibGraphics::GPUMemory::Unregister(thumbnail.second->textureResidency);
+
 		if (thumbnail.second->loadFuture.Valid())
 		{
 			try
@@ -202,23 +373,114 @@ void UIThumbnails::Clear()
 		}
 	}
 
+	// would keep its thumbnail, and a pending upload into it, alive
+	clickedThumbnail = nullptr;
 	thumbnails.clear();
 }
 
+void UIThumbnails::QueueThumbnail(const LibCore::Filesystem::File& file)
+{
+	auto filename = file.FilePath().String();
+	if (thumbnails.find(filename) == thumbnails.end())
+	{
+		thumbnails[filename] = std::make_shared<Thumbnail>();
+		thumbnails[filename]->ToEdit = true;
+		thumbnails[filename]->filename = file.FileName();
+		thumbnails[filename]->cancelToken = std::make_shared<LibCore::Async::CancelToken>();
+		RequestThumbnail(file, *thumbnails[filename]);
+	}
+}
+
+void UIThumbnails::KeepResident(const std::string& path, Thumbnail& thumbnail)
+{
+	if (!thumbnailAtlas)
+	{
+		if (thumbnail.texture)
+			LibGraphics::GPUMemory::Touch(thumbnail.textureResidency);
+		else if (thumbnail.textureEvicted && !thumbnail.loadFuture.Valid())
+		{
+			thumbnail.textureEvicted = false;
+			RequestThumbnail(LibCore::Filesystem::File{ path.c_str() }, thumbnail);
+		}
+		return;
+	}
+
+	if (thumbnailAtlas->IsResident(thumbnail.atlasRegion))
+	{
+		thumbnailAtlas->Touch(thumbnail.atlasRegion);
+		return;
+	}
+
+	// its page went over the VRAM budget while out of view, loaded again from the disk cache
+	if (thumbnail.atlasRegion.Valid() && !thumbnail.loadFuture.Valid())
+	{
+		thumbnail.atlasRegion = {};
+		RequestThumbnail(LibCore::Filesystem::File{ path.c_str() }, thumbnail);
+	}
+}
+
+void UIThumbnails::RequestThumbnail(const LibCore::Filesystem::File& file, Thumbnail& thumbnail)
+{
+	thumbnail.loadFuture = loadImagePool.Enqueue(thumbnail.cancelToken, [file, cache = thumbnailCache]() {
+		LibGraphics::Texture::CompressedData results;
+		if (cache && cache->Load(file, THUMBNAIL_MAX_SIZE, results))
+			return results;
+
+		// reduced decode from the mapped file, a full-size image is never built for a thumbnail
+		auto image = LibCV::Image::CreateThumbnail(file, THUMBNAIL_MAX_SIZE);
+		if (image->Empty())
+			throw std::runtime_error{ "cannot decode " + file.FileName() };
+
+		// BC1 takes a sixth of the VRAM and upload of RGB8, encoded here so the GL thread only copies blocks
+		const auto imageData = image->GetImageData();
+		results = LibGraphics::Texture::CompressBC1(imageData.Pixels, imageData.ImageWidth, imageData.ImageHeight, LibGraphics::Texture::FORMAT::BGR24);
+		if (results.levels.empty())
+			throw std::runtime_error{ "cannot compress " + file.FileName() };
+		if (cache)
+			cache->Store(file, THUMBNAIL_MAX_SIZE, results);
+		return results;
+	});
+}
+
 void UIThumbnails::LoadImages()
 {
+	if (directoryScanner)
+	{
+		// check before taking so the last batch is not missed
+		const bool scanFinished = directoryScanner->Finished();
+		for (auto& entry : directoryScanner->TakeResults())
+			QueueThumbnail(entry.EntryFile);
+		if (scanFinished)
+			directoryScanner = nullptr;
+	}
+
 	for (auto& thumbnail : thumbnails)
 	{
 		try
 		{
 			if (thumbnail.second->loadFuture.IsReady())
 			{
-				auto imageData = thumbnail.second->loadFuture.Get();
-				thumbnail.second->thumbnailTexture = LibGraphics::Texture::CreateFromData(
-					imageData.Pixels,
-					imageData.ImageWidth,
-					imageData.ImageHeight,
-					LibGraphics::Texture::FORMAT::BGR24);
+				// upload within the frame's GL budget rather than all at once
+				auto compressed = std::make_shared<LibGraphics::Texture::CompressedData>(thumbnail.second->loadFuture.Get());
+				UISharedData->MainThread->Submit([compressed, atlas = thumbnailAtlas, weakThumbnail = std::weak_ptr<Thumbnail>{ thumbnail.second }]() {
+					auto thumbnail = weakThumbnail.lock();
+					if (!thumbnail)
+						return;
+					if (atlas && !thumbnail->atlasRegion.Valid())
+						thumbnail->atlasRegion = atlas->Add(*compressed);
+					else if (!atlas && !thumbnail->texture && (thumbnail->texture = LibGraphics::Texture::CreateFromCompressed(*compressed)))
+					{
+						// evictable like an atlas page, KeepResident loads it again from the disk cache
+						thumbnail->textureResidency = LibGraphics::GPUMemory::RegisterEvictable([weakThumbnail]() {
+							if (auto evicted = weakThumbnail.lock())
+							{
+								evicted->texture = nullptr;
+								evicted->textureResidency = 0;
+								evicted->textureEvicted = true;
+							}
+						});
+					}
+				}, LibCore::Async::MainThreadExecutor::PRIORITY::NORMAL);
 			}
 		}
 		catch (const std::exception& e)
@@ -247,6 +509,11 @@ bool UIThumbnails::ShowImageToEdit()
 			const float window_visible_x2 = ImGui::GetWindowPos().x + ImGui::GetWindowContentRegionMax().x - extraSizes;
 			ImGui::PushStyleVar(ImGuiStyleVar_ItemSpacing, ImVec2(ImGui::GetStyle().ItemSpacing.y, ImGui::GetStyle().ItemSpacing.y));
 
+			// widgets, thumbnails, then the selection checkboxes over them
+			ImDrawList* drawList = ImGui::GetWindowDrawList();
+			ImDrawListSplitter splitter;
+			splitter.Split(drawList, 3);
+
 			for (auto& thumbnail : thumbnails)
 			{
 				if (last_button_x2 != 0 && (last_button_x2 + imageSize) < window_visible_x2)
@@ -254,19 +521,28 @@ bool UIThumbnails::ShowImageToEdit()
 
 				ImGui::BeginGroup();
 				{
-					const float aspect = thumbnail.second->thumbnailTexture ? thumbnail.second->thumbnailTexture->GetAspect() : 1.0f;
+					const auto& region = thumbnail.second->atlasRegion;
+					const auto& texture = thumbnail.second->texture;
+					const float aspect = region.Valid() ? region.GetAspect() : texture ? texture->GetAspect() : 1.0f;
 					std::string filename = thumbnail.second->filename;
 
 					const ImVec2 localImagePos = ImGui::GetCursorScreenPos();
 
+					// border only, the image goes on the thumbnail channel
 					ImGui::Image(
-						(ImTextureID)(thumbnail.second->thumbnailTexture ? thumbnail.second->thumbnailTexture->GetHandler() : 0),
+						(ImTextureID)0,
 						ImVec2(imageSize, imageSize),
 						aspect,
 						ImVec2(0.0f, 0.0f),
 						ImVec2(1.0f, 1.0f),
-						ImVec4{ 1.0f, 1.0f, 1.0f, 1.0f },
+						ImVec4{ 1.0f, 1.0f, 1.0f, 0.0f },
 						ImVec4{ 0.0f, 0.0f, 0.0f, 1.0f});
+					if (ImGui::IsItemVisible())
+						KeepResident(thumbnail.first, *thumbnail.second);
+					if (thumbnailAtlas)
+						DrawThumbnail(drawList, splitter, *thumbnailAtlas, region, ImGui::GetItemRectMin() + ImVec2{ 1, 1 }, ImGui::GetItemRectMax() - ImVec2{ 1, 1 });
+					else if (texture)
+						DrawThumbnail(drawList, splitter, *texture, ImGui::GetItemRectMin() + ImVec2{ 1, 1 }, ImGui::GetItemRectMax() - ImVec2{ 1, 1 });
 
 					float textWidth = ImGui::CalcTextSize(filename.c_str()).x;
 					if (textWidth > imageSize)
@@ -300,7 +576,9 @@ bool UIThumbnails::ShowImageToEdit()
 						ImGui::PushStyleVar(ImGuiStyleVar_FrameRounding, 0);
 						ImGui::SetCursorScreenPos(localImagePos);
 						{
+							splitter.SetCurrentChannel(drawList, 2);
 							ImGui::Checkbox(("##SELECT_IMAGE_ID_" + std::to_string((long long)&thumbnail)).c_str(), &thumbnail.second->ToEdit);
+							splitter.SetCurrentChannel(drawList, 0);
 						}
 						ImGui::PopStyleVar();
 					}
@@ -312,10 +590,20 @@ bool UIThumbnails::ShowImageToEdit()
 				ImGui::EndGroup();
 			}
 
+			splitter.Merge(drawList);
 			ImGui::PopStyleVar();
 		}
 		ImGui::EndChild();
 
+		ImGui::Checkbox("Log thread pool metrics##LOG_POOL_METRICS", &logPoolMetrics);
+		ImGui::SameLine();
+		ImGui::PushItemWidth(ImGui::GetContentRegionAvail().x * 0.3f);
+		ImGui::SliderInt("Worker processes##EXPORT_WORKERS", &exportWorkers, 0, static_cast<int>(std::max(std::thread::hardware_concurrency() / 2, 1U)));
+		ImGui::PopItemWidth();
+		if (ImGui::IsItemHovered())
+			ImGui::SetTooltip("0 exports in this process, otherwise the images are split across separate worker processes");
+		ImGui::SameLine();
+
 		const float btnSize = ImGui::GetContentRegionAvail().x * 0.5f;
 		if (ImGui::Button("Apply##APPLY_IMAGES_EDIT", ImVec2{ btnSize , 0 }))
 		{
@@ -337,18 +625,19 @@ bool UIThumbnails::ShowImageToEdit()
 					currDateTime = oss.str();
 				}
 
-				const LibCore::Filesystem::Directory saveDir = LibCore::Filesystem::Directory::OpenDirectoryDialog() / ("Image_Export_" + currDateTime);
-				std::vector<LibCore::Filesystem::File> imagesToEdit;
+				// picking the folder of an earlier export resumes it, anything else gets a new timestamped folder
+				const LibCore::Filesystem::Directory pickedDir = LibCore::Filesystem::Directory::OpenDirectoryDialog();
+				const LibCore::Filesystem::Directory saveDir = ImageProcessingExecutor::IsExportDirectory(pickedDir)
+					? pickedDir
+					: pickedDir / ("Image_Export_" + currDateTime);
+				std::vector<std::string> imagesToEdit;
 				for (auto& thumbnail : thumbnails)
 				{
 					if (thumbnail.second->ToEdit)
-						imagesToEdit.push_back(LibCore::Filesystem::File{ thumbnail.first.c_str() });
+						imagesToEdit.push_back(thumbnail.first);
 				}
 
-				imageProcExecutor = ImageProcessingExecutor::Run(imageProcessor, imagesToEdit, saveDir);
-				UISharedData->EvtSystem->Emit(Event::OverlayPopup{ [this]() {
-					return ShowEditingImages();
-				} });
+				UISharedData->EvtSystem->Emit(Event::ApplyToImages{ imagesToEdit, saveDir.String(), logPoolMetrics, static_cast<unsigned>(exportWorkers) });
 				openPopup = false;
 			}
 			catch (const std::exception& e)
@@ -378,20 +667,49 @@ bool UIThumbnails::ShowEditingImages()
 	ImGui::SetNextWindowSize(winSize);
 	ImGui::SetNextWindowPos((ImGui::GetIO().DisplaySize - winSize) * 0.5f);
 	ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2(10.f, 5.f));
-	if (ImGui::Begin("##IMAGES_EDIT_WINDOW_COMPLETED", nullptr, IMAGE_EDIT_WINDOW_FLAGS))
+	const bool windowOpen = ImGui::Begin("##IMAGES_EDIT_WINDOW_COMPLETED", nullptr, IMAGE_EDIT_WINDOW_FLAGS);
+	if (windowOpen && exportCoordinator)
+	{
+		ImGui::Text("Completed: %.2f%%", exportCoordinator->PercentageCompleted());
+		ImGui::Separator();
+		ImGui::Text("Workers: %u running, %u restarted", exportCoordinator->RunningWorkers(), exportCoordinator->RestartedWorkers());
+		if (exportCoordinator->FailedImages())
+			ImGui::Text("Failed: %u images", exportCoordinator->FailedImages());
+	}
+	else if (windowOpen && imageProcExecutor)
 	{
 		ImGui::Text("Completed: %.2f%%", imageProcExecutor->PercentageCompleted());
+		ImGui::Separator();
+		for (auto& metrics : imageProcExecutor->GetPoolMetrics())
+		{
+			ImGui::Text("%s: %d workers, queue %d, busy %.0f%%, %.2f tasks/s",
+				metrics.Name.c_str(),
+				(int)metrics.WorkerCount,
+				(int)metrics.QueueDepth,
+				metrics.Utilisation * 100.0,
+				metrics.TasksPerSecond);
+			ImGui::Text("    wait %.1fms (p95 %.1fms), run %.1fms (p95 %.1fms)",
+				metrics.WaitTime.MeanMillis(),
+				metrics.WaitTime.PercentileMillis(0.95),
+				metrics.RunTime.MeanMillis(),
+				metrics.RunTime.PercentileMillis(0.95));
+		}
+		ImGui::Text("Main: %.1fms per image", imageProcExecutor->MainThreadMillisPerImage());
+		if (imageProcExecutor->DuplicateImages())
+			ImGui::Text("Duplicates: %u linked instead of processed", imageProcExecutor->DuplicateImages());
+		if (imageProcExecutor->ResumedImages())
+			ImGui::Text("Resumed: %u already exported", imageProcExecutor->ResumedImages());
 	}
 	ImGui::End();
 	ImGui::PopStyleVar();
 
-	if (imageProcExecutor->Completed())
+	if (exportCoordinator && exportCoordinator->Completed())
+		exportCoordinator = nullptr;
+	if (imageProcExecutor && imageProcExecutor->Completed())
 		imageProcExecutor = nullptr;
 
-	return imageProcExecutor != nullptr;
-}
-
-bool UIThumbnails::IsAcceptedImageFormat(const std::string& ext) const
-{
-    return ACCEPTED_IMAGE_TYPE.find(LibCore::Utils::String::ToLower(ext)) != ACCEPTED_IMAGE_TYPE.end();
+	const bool running = exportCoordinator || imageProcExecutor;
+	if (!running)
+		UISharedData->BatchRunning = false;
+	return running;
 }
\ No newline at end of file
@@ -5,9 +5,14 @@
 #include "GlobalDefs.h"
 #include "ImageProcessor.h"
 #include "ImageProcessingExecutor.h"
+#include "HotFolderIngest.h"
+#include "ExportCoordinator.h"
+#include "ThumbnailCache.h"
 
 #include "LibCore/File.h"
+#include "LibCore/DirectoryScanner.h"
 #include "LibCore/ThreadPool.h"
+#include "LibGraphics/TextureAtlas.h"
 
 class UIThumbnails : public UIHeader
 {
@@ -23,28 +28,42 @@ private:
     void LoadImages();
     bool ShowImageToEdit();
     bool ShowEditingImages();
-    bool IsAcceptedImageFormat(const std::string& ext) const;
+    void QueueThumbnail(const LibCore::Filesystem::File& file);
 
 private:
     struct Thumbnail
     {
         bool ToEdit;
         std::string filename;
-        LibCore::Async::Future<LibCV::ImageData> loadFuture;
+        LibCore::Async::Future<LibGraphics::Texture::CompressedData> loadFuture;
         std::shared_ptr<LibCore::Async::CancelToken> cancelToken;
-        std::shared_ptr<LibGraphics::Texture> thumbnailTexture;
+        LibGraphics::TextureAtlas::Region atlasRegion;
+        std::shared_ptr<LibGraphics::Texture> texture;	// instead of atlasRegion when there is no atlas
+        LibGraphics::GPUMemory::Handle textureResidency;	// of texture, 0 while it is not loaded
+        bool textureEvicted;	// went over the VRAM budget, loaded again once back in view
     };
 
+    void RequestThumbnail(const LibCore::Filesystem::File& file, Thumbnail& thumbnail);
+    // for a thumbnail on screen: keeps its atlas page (or texture) from eviction, or reloads it if it was evicted
+    void KeepResident(const std::string& path, Thumbnail& thumbnail);
+
     std::shared_ptr<ImageProcessor> imageProcessor;
     std::map<std::string, std::shared_ptr<Thumbnail>> thumbnails;
     LibCore::Async::ThreadPool loadImagePool;
+    std::shared_ptr<ThumbnailCache> thumbnailCache;	// nullptr runs without one
+    std::shared_ptr<LibGraphics::TextureAtlas> thumbnailAtlas;
+    std::shared_ptr<LibCore::Filesystem::DirectoryScanner> directoryScanner;
 
 private: 
     // UI tools
     float thumbnailScale;
     std::chrono::high_resolution_clock::time_point currClickedTime;
     std::shared_ptr<Thumbnail> clickedThumbnail;
+    bool logPoolMetrics;
+    int exportWorkers;
 
 private:
     std::shared_ptr< ImageProcessingExecutor> imageProcExecutor;
+    std::shared_ptr<ExportCoordinator> exportCoordinator;
+    std::shared_ptr<HotFolderIngest> hotFolder;
 };
\ No newline at end of file